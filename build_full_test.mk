@@ -28,6 +28,12 @@ $(TEST)_SRC= \
 	tests/test_common/test_fixture.cpp
 $(TEST)_SRC += $(patsubst $(ROOTDIR)/%,%,$(wildcard $(TEST_PATH)/*.cpp))
 
+ifeq ($(strip $(KEYMAP_ACTIONS_ENABLE)), yes)
+    KEYMAP_ACTIONS_C := $(TEST_OBJ)/$(TEST)/src/keymap_actions.c
+    KEYMAP_ACTIONS_KEYMAP_OBJ := $(TEST_OBJ)/$(TEST)/$(TEST_PATH)/keymap.o
+    $(TEST)_SRC += $(KEYMAP_ACTIONS_C)
+endif
+
 $(TEST)_DEFS=$(TMK_COMMON_DEFS) $(OPT_DEFS)
 $(TEST)_CONFIG=$(TEST_PATH)/config.h
 VPATH+=$(TOP_DIR)/tests/test_common
\ No newline at end of file
@@ -298,6 +298,13 @@ include bootloader.mk
 
 SRC += $(TMK_COMMON_SRC)
 OPT_DEFS += $(TMK_COMMON_DEFS)
+
+# The action table is generated from the compiled keymap, see util/generate_keymap_actions.sh
+ifeq ($(strip $(KEYMAP_ACTIONS_ENABLE)), yes)
+    KEYMAP_ACTIONS_C := $(KEYMAP_OUTPUT)/src/keymap_actions.c
+    KEYMAP_ACTIONS_KEYMAP_OBJ := $(KEYMAP_OUTPUT)/$(patsubst %.c,%.o,$(KEYMAP_C))
+    SRC += $(KEYMAP_ACTIONS_C)
+endif
 EXTRALDFLAGS += $(TMK_COMMON_LDFLAGS)
 
 ifeq ($(PLATFORM),AVR)
@@ -235,6 +235,13 @@ ifeq ($(strip $(DYNAMIC_KEYMAP_ENABLE)), yes)
     SRC += $(QUANTUM_DIR)/dynamic_keymap.c
 endif
 
+ifeq ($(strip $(KEYMAP_ACTIONS_ENABLE)), yes)
+    ifeq ($(strip $(DYNAMIC_KEYMAP_ENABLE)), yes)
+        $(error KEYMAP_ACTIONS_ENABLE can't be used with DYNAMIC_KEYMAP_ENABLE, the keymap is not known at build time)
+    endif
+    OPT_DEFS += -DKEYMAP_ACTIONS_ENABLE
+endif
+
 ifeq ($(strip $(LEADER_ENABLE)), yes)
   SRC += $(QUANTUM_DIR)/process_keycode/process_leader.c
   OPT_DEFS += -DLEADER_ENABLE
@@ -242,9 +249,20 @@ endif
 
 QUANTUM_SRC:= \
     $(QUANTUM_DIR)/quantum.c \
+    $(QUANTUM_DIR)/send_string.c \
     $(QUANTUM_DIR)/keymap_common.c \
     $(QUANTUM_DIR)/keycode_config.c
 
+DEBOUNCE_DIR:= $(QUANTUM_DIR)/debounce
+DEBOUNCE_TYPE ?= sym_g
+VALID_DEBOUNCE_TYPES := sym_g eager_pk eager_pr asym_eager_defer_pk custom
+ifeq ($(filter $(DEBOUNCE_TYPE),$(VALID_DEBOUNCE_TYPES)),)
+    $(error DEBOUNCE_TYPE="$(DEBOUNCE_TYPE)" is not a valid debounce algorithm)
+endif
+ifneq ($(strip $(DEBOUNCE_TYPE)), custom)
+    QUANTUM_SRC += $(DEBOUNCE_DIR)/$(strip $(DEBOUNCE_TYPE)).c
+endif
+
 ifneq ($(strip $(CUSTOM_MATRIX)), yes)
     ifeq ($(strip $(SPLIT_KEYBOARD)), yes)
         QUANTUM_SRC += $(QUANTUM_DIR)/split_common/matrix.c
@@ -253,10 +271,16 @@ ifneq ($(strip $(CUSTOM_MATRIX)), yes)
     endif
 endif
 
+SPLIT_TRANSPORT ?= bitbang
+VALID_SPLIT_TRANSPORTS := bitbang usart
 ifeq ($(strip $(SPLIT_KEYBOARD)), yes)
+    ifeq ($(filter $(strip $(SPLIT_TRANSPORT)),$(VALID_SPLIT_TRANSPORTS)),)
+        $(error SPLIT_TRANSPORT="$(SPLIT_TRANSPORT)" is not a valid split transport)
+    endif
     OPT_DEFS += -DSPLIT_KEYBOARD
     QUANTUM_SRC += $(QUANTUM_DIR)/split_common/split_flags.c \
                 $(QUANTUM_DIR)/split_common/split_util.c \
                 $(QUANTUM_DIR)/split_common/i2c.c \
-                $(QUANTUM_DIR)/split_common/serial.c
+                $(QUANTUM_DIR)/split_common/serial.c \
+                $(QUANTUM_DIR)/split_common/transport_$(strip $(SPLIT_TRANSPORT)).c
 endif
@@ -32,6 +32,12 @@
 
 static uint8_t i2c_address;
 
+#ifdef I2C_ASYNC_ENABLE
+  #define I2C_WAIT_FOR_ASYNC() i2c_async_wait()
+#else
+  #define I2C_WAIT_FOR_ASYNC()
+#endif
+
 // This configures the I2C clock to 400Mhz assuming a 72Mhz clock
 // For more info : https://www.st.com/en/embedded-software/stsw-stm32126.html
 static const I2CConfig i2cconfig = {
@@ -65,6 +71,7 @@ uint8_t i2c_start(uint8_t address)
 
 uint8_t i2c_transmit(uint8_t address, uint8_t* data, uint16_t length, uint16_t timeout)
 {
+  I2C_WAIT_FOR_ASYNC();
   i2c_address = address;
   i2cStart(&I2C_DRIVER, &i2cconfig);
   return i2cMasterTransmitTimeout(&I2C_DRIVER, (i2c_address >> 1), data, length, 0, 0, MS2ST(timeout));
@@ -72,6 +79,7 @@ uint8_t i2c_transmit(uint8_t address, uint8_t* data, uint16_t length, uint16_t t
 
 uint8_t i2c_receive(uint8_t address, uint8_t* data, uint16_t length, uint16_t timeout)
 {
+  I2C_WAIT_FOR_ASYNC();
   i2c_address = address;
   i2cStart(&I2C_DRIVER, &i2cconfig);
   return i2cMasterReceiveTimeout(&I2C_DRIVER, (i2c_address >> 1), data, length, MS2ST(timeout));
@@ -79,6 +87,7 @@ uint8_t i2c_receive(uint8_t address, uint8_t* data, uint16_t length, uint16_t ti
 
 uint8_t i2c_writeReg(uint8_t devaddr, uint8_t regaddr, uint8_t* data, uint16_t length, uint16_t timeout)
 {
+  I2C_WAIT_FOR_ASYNC();
   i2c_address = devaddr;
   i2cStart(&I2C_DRIVER, &i2cconfig);
 
@@ -94,6 +103,7 @@ uint8_t i2c_writeReg(uint8_t devaddr, uint8_t regaddr, uint8_t* data, uint16_t l
 
 uint8_t i2c_readReg(uint8_t devaddr, uint8_t* regaddr, uint8_t* data, uint16_t length, uint16_t timeout)
 {
+  I2C_WAIT_FOR_ASYNC();
   i2c_address = devaddr;
   i2cStart(&I2C_DRIVER, &i2cconfig);
   return i2cMasterTransmitTimeout(&I2C_DRIVER, (i2c_address >> 1), regaddr, 1, data, length, MS2ST(timeout));
@@ -102,6 +112,123 @@ uint8_t i2c_readReg(uint8_t devaddr, uint8_t* regaddr, uint8_t* data, uint16_t l
 // This is usually not needed. It releases the driver to allow pins to become GPIO again.
 uint8_t i2c_stop(uint16_t timeout)
 {
+  I2C_WAIT_FOR_ASYNC();
   i2cStop(&I2C_DRIVER);
   return 0;
 }
+
+#ifdef I2C_ASYNC_ENABLE
+typedef struct {
+  uint8_t address;
+  uint8_t length;
+  bool coalesce;
+  i2c_async_callback_t callback;
+  uint8_t data[I2C_ASYNC_MAX_LENGTH];
+} i2c_async_transfer_t;
+
+// Ring of queued transfers, only touched with the system locked
+static i2c_async_transfer_t async_queue[I2C_ASYNC_QUEUE_SIZE];
+static uint8_t async_tail = 0;
+static uint8_t async_count = 0;
+static bool async_in_flight = false;
+static bool async_started = false;
+static semaphore_t async_pending;
+
+static THD_WORKING_AREA(waI2CAsyncThread, 256);
+static THD_FUNCTION(I2CAsyncThread, arg) {
+  (void)arg;
+  chRegSetThreadName("i2c_async");
+
+  i2c_async_transfer_t transfer;
+  while (true) {
+    chSemWait(&async_pending);
+
+    chSysLock();
+    transfer = async_queue[async_tail];
+    async_tail = (async_tail + 1) % I2C_ASYNC_QUEUE_SIZE;
+    async_count--;
+    async_in_flight = true;
+    chSysUnlock();
+
+    // The calling thread sleeps until the driver interrupt finishes the transfer
+    i2cStart(&I2C_DRIVER, &i2cconfig);
+    uint8_t status = i2cMasterTransmitTimeout(&I2C_DRIVER, (transfer.address >> 1), transfer.data, transfer.length, 0, 0, MS2ST(I2C_ASYNC_TIMEOUT));
+
+    if (transfer.callback) {
+      transfer.callback(transfer.address, transfer.data[0], status);
+    }
+
+    chSysLock();
+    async_in_flight = false;
+    chSysUnlock();
+  }
+}
+
+static void i2c_async_start(void)
+{
+  chSemObjectInit(&async_pending, 0);
+  async_started = true;
+  (void)chThdCreateStatic(waI2CAsyncThread, sizeof(waI2CAsyncThread),
+                          I2C_ASYNC_THREAD_PRIORITY, I2CAsyncThread, NULL);
+}
+
+// Queue a transfer without waiting for the bus. Returns false if it is too
+// long or the queue is full, in which case nothing was queued.
+bool i2c_transmit_async(uint8_t address, const uint8_t* data, uint16_t length, bool coalesce, i2c_async_callback_t callback)
+{
+  if (length == 0 || length > I2C_ASYNC_MAX_LENGTH) {
+    return false;
+  }
+  if (!async_started) {
+    i2c_async_start();
+  }
+
+  chSysLock();
+  i2c_async_transfer_t *transfer = NULL;
+  if (coalesce) {
+    for (uint8_t i = 0; i < async_count; i++) {
+      i2c_async_transfer_t *queued = &async_queue[(async_tail + i) % I2C_ASYNC_QUEUE_SIZE];
+      if (queued->coalesce && queued->address == address && queued->data[0] == data[0]) {
+        transfer = queued;
+        break;
+      }
+    }
+  }
+  bool append = transfer == NULL;
+  if (append) {
+    if (async_count >= I2C_ASYNC_QUEUE_SIZE) {
+      chSysUnlock();
+      return false;
+    }
+    transfer = &async_queue[(async_tail + async_count) % I2C_ASYNC_QUEUE_SIZE];
+  }
+  transfer->address = address;
+  transfer->length = length;
+  transfer->coalesce = coalesce;
+  transfer->callback = callback;
+  memcpy(transfer->data, data, length);
+  if (append) {
+    async_count++;
+    chSemSignalI(&async_pending);
+    chSchRescheduleS();
+  }
+  chSysUnlock();
+  return true;
+}
+
+// True when nothing is queued or being sent
+bool i2c_async_idle(void)
+{
+  chSysLock();
+  bool idle = async_count == 0 && !async_in_flight;
+  chSysUnlock();
+  return idle;
+}
+
+void i2c_async_wait(void)
+{
+  while (!i2c_async_idle()) {
+    chThdSleepMilliseconds(1);
+  }
+}
+#endif
@@ -37,3 +37,40 @@ uint8_t i2c_receive(uint8_t address, uint8_t* data, uint16_t length, uint16_t ti
 uint8_t i2c_writeReg(uint8_t devaddr, uint8_t regaddr, uint8_t* data, uint16_t length, uint16_t timeout);
 uint8_t i2c_readReg(uint8_t devaddr, uint8_t* regaddr, uint8_t* data, uint16_t length, uint16_t timeout);
 uint8_t i2c_stop(uint16_t timeout);
+
+#ifdef I2C_ASYNC_ENABLE
+/* Transfers posted with i2c_transmit_async() are copied into a bounded queue
+ * and sent by a worker thread, so the caller never waits for the bus.
+ * A coalescing transfer replaces the data of a queued, not yet started,
+ * transfer to the same address whose first byte (the register) is the same.
+ * i2c_transmit() and the other blocking functions wait for the queue to
+ * drain first, so transfers to a device stay in order.
+ */
+#ifndef I2C_ASYNC_QUEUE_SIZE
+  #define I2C_ASYNC_QUEUE_SIZE 24
+#endif
+
+#if I2C_ASYNC_QUEUE_SIZE > 255
+  #error "I2C_ASYNC_QUEUE_SIZE must be no larger than 255"
+#endif
+
+#ifndef I2C_ASYNC_MAX_LENGTH
+  #define I2C_ASYNC_MAX_LENGTH 17
+#endif
+
+#ifndef I2C_ASYNC_TIMEOUT
+  #define I2C_ASYNC_TIMEOUT 100
+#endif
+
+#ifndef I2C_ASYNC_THREAD_PRIORITY
+  #define I2C_ASYNC_THREAD_PRIORITY (NORMALPRIO + 1)
+#endif
+
+/* Called from the worker thread once a transfer has finished, status is
+ * the same as the return value of i2c_transmit() */
+typedef void (*i2c_async_callback_t)(uint8_t address, uint8_t reg, uint8_t status);
+
+bool i2c_transmit_async(uint8_t address, const uint8_t* data, uint16_t length, bool coalesce, i2c_async_callback_t callback);
+bool i2c_async_idle(void);
+void i2c_async_wait(void);
+#endif
@@ -5,6 +5,10 @@
 #ifndef I2C_MASTER_H
 #define I2C_MASTER_H
 
+#ifdef I2C_ASYNC_ENABLE
+#error "I2C_ASYNC_ENABLE is only supported by the ChibiOS I2C driver"
+#endif
+
 #define I2C_READ 0x01
 #define I2C_WRITE 0x00
 
@@ -71,7 +71,9 @@ uint8_t g_twi_transfer_buffer[20];
 // buffers and the transfers in IS31FL3731_write_pwm_buffer() but it's
 // probably not worth the extra complexity.
 uint8_t g_pwm_buffer[DRIVER_COUNT][144];
-bool g_pwm_buffer_update_required = false;
+// One bit per 16 byte page of g_pwm_buffer that differs from the driver,
+// so an update only transfers the pages that actually changed.
+uint16_t g_pwm_buffer_dirty_pages[DRIVER_COUNT] = { 0 };
 
 uint8_t g_led_control_registers[DRIVER_COUNT][18] = { { 0 }, { 0 } };
 bool g_led_control_registers_update_required = false;
@@ -106,32 +108,96 @@ void IS31FL3731_write_register( uint8_t addr, uint8_t reg, uint8_t data )
   #endif
 }
 
-void IS31FL3731_write_pwm_buffer( uint8_t addr, uint8_t *pwm_buffer )
+#if defined(I2C_ASYNC_ENABLE) && ISSI_PERSISTENCE > 0
+// Pages whose queued write failed, set from the I2C thread and marked dirty
+// again on the next update so they are sent until they make it
+static uint16_t g_pwm_buffer_failed_pages[DRIVER_COUNT] = { 0 };
+static uint8_t g_pwm_buffer_address[DRIVER_COUNT] = { 0 };
+
+// Runs on the I2C thread once a queued PWM page write has finished
+static void IS31FL3731_pwm_page_done( uint8_t address, uint8_t reg, uint8_t status )
+{
+    if ( status == 0 ) {
+        return;
+    }
+    chSysLock();
+    for ( uint8_t driver = 0; driver < DRIVER_COUNT; driver++ ) {
+        if ( g_pwm_buffer_address[driver] == address ) {
+            g_pwm_buffer_failed_pages[driver] |= (uint16_t)1 << ( ( reg - 0x24 ) / 16 );
+        }
+    }
+    chSysUnlock();
+}
+
+static void IS31FL3731_retry_failed_pwm_pages( uint8_t addr, uint8_t driver )
+{
+    chSysLock();
+    g_pwm_buffer_address[driver] = addr << 1;
+    g_pwm_buffer_dirty_pages[driver] |= g_pwm_buffer_failed_pages[driver];
+    g_pwm_buffer_failed_pages[driver] = 0;
+    chSysUnlock();
+}
+
+  #define ISSI_PWM_PAGE_CALLBACK IS31FL3731_pwm_page_done
+#else
+  #define ISSI_PWM_PAGE_CALLBACK NULL
+#endif
+
+// Returns false if the page could not be queued
+static bool IS31FL3731_write_pwm_page( uint8_t addr, uint8_t *pwm_buffer, uint8_t page )
 {
     // assumes bank is already selected
 
-    // transmit PWM registers in 9 transfers of 16 bytes
     // g_twi_transfer_buffer[] is 20 bytes
+    g_twi_transfer_buffer[0] = 0x24 + page * 16;
+    // copy the 16 bytes of the page
+    // device will auto-increment register for data after the first byte
+    for ( int j = 0; j < 16; j++ ) {
+        g_twi_transfer_buffer[1 + j] = pwm_buffer[page * 16 + j];
+    }
+
+  #if defined(I2C_ASYNC_ENABLE)
+    // a newer write of the same page replaces one that is still queued
+    return i2c_transmit_async(addr << 1, g_twi_transfer_buffer, 17, true, ISSI_PWM_PAGE_CALLBACK);
+  #elif ISSI_PERSISTENCE > 0
+    for (uint8_t i = 0; i < ISSI_PERSISTENCE; i++) {
+      if (i2c_transmit(addr << 1, g_twi_transfer_buffer, 17, ISSI_TIMEOUT) == 0)
+        break;
+    }
+  #else
+    i2c_transmit(addr << 1, g_twi_transfer_buffer, 17, ISSI_TIMEOUT);
+  #endif
+    return true;
+}
+
+void IS31FL3731_write_pwm_buffer( uint8_t addr, uint8_t *pwm_buffer )
+{
+    // transmit PWM registers in 9 transfers of 16 bytes
+    for ( uint8_t page = 0; page < 9; page++ ) {
+        IS31FL3731_write_pwm_page( addr, pwm_buffer, page );
+    }
+}
 
-    // iterate over the pwm_buffer contents at 16 byte intervals
-    for ( int i = 0; i < 144; i += 16 ) {
-        // set the first register, e.g. 0x24, 0x34, 0x44, etc.
-        g_twi_transfer_buffer[0] = 0x24 + i;
-        // copy the data from i to i+15
-        // device will auto-increment register for data after the first byte
-        // thus this sets registers 0x24-0x33, 0x34-0x43, etc. in one transfer
-        for ( int j = 0; j < 16; j++ ) {
-            g_twi_transfer_buffer[1 + j] = pwm_buffer[i + j];
+// Writes only the pages marked dirty and marks them clean
+static void IS31FL3731_write_dirty_pwm_pages( uint8_t addr, uint8_t driver )
+{
+  #if defined(I2C_ASYNC_ENABLE) && ISSI_PERSISTENCE > 0
+    IS31FL3731_retry_failed_pwm_pages( addr, driver );
+  #endif
+    uint16_t dirty = g_pwm_buffer_dirty_pages[driver];
+    for ( uint8_t page = 0; dirty; page++, dirty >>= 1 ) {
+        if ( ( dirty & 1 ) && IS31FL3731_write_pwm_page( addr, g_pwm_buffer[driver], page ) ) {
+            g_pwm_buffer_dirty_pages[driver] &= ~( (uint16_t)1 << page );
         }
+    }
+}
 
-    #if ISSI_PERSISTENCE > 0
-      for (uint8_t i = 0; i < ISSI_PERSISTENCE; i++) {
-        if (i2c_transmit(addr << 1, g_twi_transfer_buffer, 17, ISSI_TIMEOUT) == 0)
-          break;
-      }
-    #else
-      i2c_transmit(addr << 1, g_twi_transfer_buffer, 17, ISSI_TIMEOUT);
-    #endif
+// Stores a PWM value, marking its page dirty only if the value changed
+static inline void IS31FL3731_set_pwm( uint8_t driver, uint8_t index, uint8_t value )
+{
+    if ( g_pwm_buffer[driver][index] != value ) {
+        g_pwm_buffer[driver][index] = value;
+        g_pwm_buffer_dirty_pages[driver] |= (uint16_t)1 << ( index / 16 );
     }
 }
 
@@ -201,10 +267,9 @@ void IS31FL3731_set_color( int index, uint8_t red, uint8_t green, uint8_t blue )
         is31_led led = g_is31_leds[index];
 
         // Subtract 0x24 to get the second index of g_pwm_buffer
-        g_pwm_buffer[led.driver][led.r - 0x24] = red;
-        g_pwm_buffer[led.driver][led.g - 0x24] = green;
-        g_pwm_buffer[led.driver][led.b - 0x24] = blue;
-        g_pwm_buffer_update_required = true;
+        IS31FL3731_set_pwm( led.driver, led.r - 0x24, red );
+        IS31FL3731_set_pwm( led.driver, led.g - 0x24, green );
+        IS31FL3731_set_pwm( led.driver, led.b - 0x24, blue );
     }
 }
 
@@ -249,12 +314,8 @@ void IS31FL3731_set_led_control_register( uint8_t index, bool red, bool green, b
 
 void IS31FL3731_update_pwm_buffers( uint8_t addr1, uint8_t addr2 )
 {
-    if ( g_pwm_buffer_update_required )
-    {
-        IS31FL3731_write_pwm_buffer( addr1, g_pwm_buffer[0] );
-        IS31FL3731_write_pwm_buffer( addr2, g_pwm_buffer[1] );
-    }
-    g_pwm_buffer_update_required = false;
+    IS31FL3731_write_dirty_pwm_pages( addr1, 0 );
+    IS31FL3731_write_dirty_pwm_pages( addr2, 1 );
 }
 
 void IS31FL3731_update_led_control_registers( uint8_t addr1, uint8_t addr2 )
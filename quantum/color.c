@@ -19,11 +19,29 @@
 #include "led_tables.h"
 #include "progmem.h"
 
-RGB hsv_to_rgb( HSV hsv )
+// h / 43 for every hue, so the conversion needs no division
+static const uint8_t HUE_REGION[256] PROGMEM = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+	2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+	2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+	2, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+	3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+	3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4,
+	4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+	4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+	4, 4, 4, 4, 4, 4, 4, 5, 5, 5, 5, 5, 5, 5, 5, 5,
+	5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5,
+	5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5
+};
+
+static inline RGB hsv_to_rgb_kernel( HSV hsv, bool cie )
 {
 	RGB rgb;
-	uint8_t region, p, q, t;
-	uint16_t h, s, v, remainder;
 
 	if ( hsv.s == 0 )
 	{
@@ -33,16 +51,13 @@ RGB hsv_to_rgb( HSV hsv )
 		return rgb;
 	}
 
-	h = hsv.h;
-	s = hsv.s;
-	v = hsv.v;
-
-	region = h / 43;
-	remainder = (h - (region * 43)) * 6;
-
-	p = (v * (255 - s)) >> 8;
-	q = (v * (255 - ((s * remainder) >> 8))) >> 8;
-	t = (v * (255 - ((s * (255 - remainder)) >> 8))) >> 8;
+	uint8_t region = pgm_read_byte( &HUE_REGION[hsv.h] );
+	uint16_t remainder = (hsv.h - (region * 43)) * 6;
+	uint16_t s = hsv.s;
+	uint16_t v = hsv.v;
+	uint8_t p = (v * (255 - s)) >> 8;
+	uint8_t q = (v * (255 - ((s * remainder) >> 8))) >> 8;
+	uint8_t t = (v * (255 - ((s * (255 - remainder)) >> 8))) >> 8;
 
 	switch ( region )
 	{
@@ -78,10 +93,35 @@ RGB hsv_to_rgb( HSV hsv )
 			break;
 	}
 
-	rgb.r = pgm_read_byte( &CIE1931_CURVE[rgb.r] );
-	rgb.g = pgm_read_byte( &CIE1931_CURVE[rgb.g] );
-	rgb.b = pgm_read_byte( &CIE1931_CURVE[rgb.b] );
+	if ( cie )
+	{
+		rgb.r = pgm_read_byte( &CIE1931_CURVE[rgb.r] );
+		rgb.g = pgm_read_byte( &CIE1931_CURVE[rgb.g] );
+		rgb.b = pgm_read_byte( &CIE1931_CURVE[rgb.b] );
+	}
 
 	return rgb;
 }
 
+RGB hsv_to_rgb( HSV hsv )
+{
+	return hsv_to_rgb_kernel( hsv, true );
+}
+
+void hsv_to_rgb_batch( const HSV *hsv, RGB *rgb, uint16_t count, bool cie )
+{
+	uint16_t i = 0;
+
+	// Four pixels per pass, the tail is converted one at a time
+	for ( ; i + 4 <= count; i += 4 )
+	{
+		rgb[i] = hsv_to_rgb_kernel( hsv[i], cie );
+		rgb[i + 1] = hsv_to_rgb_kernel( hsv[i + 1], cie );
+		rgb[i + 2] = hsv_to_rgb_kernel( hsv[i + 2], cie );
+		rgb[i + 3] = hsv_to_rgb_kernel( hsv[i + 3], cie );
+	}
+	for ( ; i < count; i++ )
+	{
+		rgb[i] = hsv_to_rgb_kernel( hsv[i], cie );
+	}
+}
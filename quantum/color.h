@@ -52,4 +52,8 @@ typedef struct PACKED
 
 RGB hsv_to_rgb( HSV hsv );
 
+// Converts count pixels, giving the same results as hsv_to_rgb() when cie
+// is true. With cie false the CIE 1931 lightness correction is skipped.
+void hsv_to_rgb_batch( const HSV *hsv, RGB *rgb, uint16_t count, bool cie );
+
 #endif // COLOR_H
@@ -0,0 +1,47 @@
+/*
+Copyright 2018 QMK Firmware contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef DEBOUNCE_H
+#define DEBOUNCE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "matrix.h"
+
+/* How long (ms) a key has to settle, see docs/feature_debounce_type.md.
+ * DEBOUNCING_DELAY is the old name and is still honoured.
+ */
+#ifndef DEBOUNCE
+#   ifdef DEBOUNCING_DELAY
+#       define DEBOUNCE DEBOUNCING_DELAY
+#   else
+#       define DEBOUNCE 5
+#   endif
+#endif
+
+/* raw is the current key state
+ * on entry cooked is the previous debounced state
+ * on exit cooked is the current debounced state
+ * changed is true if raw has changed since the last call
+ */
+void debounce(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, bool changed);
+
+/* true while some key is still waiting out its debounce time */
+bool debounce_active(void);
+
+void debounce_init(uint8_t num_rows);
+
+#endif
@@ -0,0 +1,95 @@
+/*
+Copyright 2018 QMK Firmware contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+Asymmetric per-key algorithm. Uses an 8-bit counter per key.
+A press is reported as soon as it is seen. A release is only reported once the
+key has read as released for DEBOUNCE milliseconds in a row, so contact bounce
+on either edge never produces an extra press or release.
+*/
+#include "matrix.h"
+#include "timer.h"
+#include "debounce.h"
+
+#if (DEBOUNCE > 0xFF)
+#   error "DEBOUNCE must fit in 8 bits for asym_eager_defer_pk"
+#endif
+
+#define DEBOUNCE_IDLE 0
+
+static uint8_t debounce_counters[MATRIX_ROWS * MATRIX_COLS];
+static bool counters_need_update = false;
+static uint16_t last_time;
+
+void debounce_init(uint8_t num_rows)
+{
+    for (uint16_t i = 0; i < num_rows * MATRIX_COLS; i++) {
+        debounce_counters[i] = DEBOUNCE_IDLE;
+    }
+    counters_need_update = false;
+    last_time = timer_read();
+}
+
+void debounce(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, bool changed)
+{
+    uint16_t now = timer_read();
+    uint16_t elapsed16 = TIMER_DIFF_16(now, last_time);
+    uint8_t elapsed = elapsed16 > 0xFF ? 0xFF : elapsed16;
+    uint8_t *debounce_pointer = debounce_counters;
+
+    last_time = now;
+    if (!changed && !counters_need_update) {
+        return;
+    }
+
+    counters_need_update = false;
+    for (uint8_t row = 0; row < num_rows; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++, debounce_pointer++) {
+            matrix_row_t col_mask = (matrix_row_t)1 << col;
+            bool raw_on = raw[row] & col_mask;
+
+            if (!(cooked[row] & col_mask)) {
+                // eager press
+                if (raw_on) {
+                    cooked[row] |= col_mask;
+                }
+            } else if (raw_on) {
+                // bounced back on, cancel any pending release
+                *debounce_pointer = DEBOUNCE_IDLE;
+            } else if (*debounce_pointer == DEBOUNCE_IDLE) {
+#if (DEBOUNCE > 0)
+                *debounce_pointer = DEBOUNCE;
+                counters_need_update = true;
+#else
+                cooked[row] &= ~col_mask;
+#endif
+            } else if (*debounce_pointer > elapsed) {
+                *debounce_pointer -= elapsed;
+                counters_need_update = true;
+            } else {
+                // deferred release, stable for DEBOUNCE ms
+                *debounce_pointer = DEBOUNCE_IDLE;
+                cooked[row] &= ~col_mask;
+            }
+        }
+    }
+}
+
+bool debounce_active(void)
+{
+    return counters_need_update;
+}
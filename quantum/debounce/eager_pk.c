@@ -0,0 +1,107 @@
+/*
+Copyright 2018 QMK Firmware contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+Basic per-key algorithm. Uses an 8-bit counter per key.
+After pressing a key, it immediately changes state, and sets a counter.
+No further inputs are accepted until DEBOUNCE milliseconds have occurred.
+*/
+#include "matrix.h"
+#include "timer.h"
+#include "debounce.h"
+
+#if (DEBOUNCE > 0xFF)
+#   error "DEBOUNCE must fit in 8 bits for eager_pk"
+#endif
+
+#define DEBOUNCE_IDLE 0
+
+static uint8_t debounce_counters[MATRIX_ROWS * MATRIX_COLS];
+static bool counters_need_update = false;
+static uint16_t last_time;
+
+static void update_debounce_counters(uint8_t num_rows, uint8_t elapsed);
+static void transfer_matrix_values(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows);
+
+void debounce_init(uint8_t num_rows)
+{
+    for (uint16_t i = 0; i < num_rows * MATRIX_COLS; i++) {
+        debounce_counters[i] = DEBOUNCE_IDLE;
+    }
+    counters_need_update = false;
+    last_time = timer_read();
+}
+
+void debounce(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, bool changed)
+{
+    uint16_t now = timer_read();
+    uint16_t elapsed = TIMER_DIFF_16(now, last_time);
+    last_time = now;
+
+    // a key unlocked by this update may still have a change waiting
+    bool counters_were_running = counters_need_update;
+    if (counters_need_update && elapsed) {
+        update_debounce_counters(num_rows, elapsed > 0xFF ? 0xFF : elapsed);
+    }
+
+    if (changed || counters_were_running) {
+        transfer_matrix_values(raw, cooked, num_rows);
+    }
+}
+
+bool debounce_active(void)
+{
+    return counters_need_update;
+}
+
+// count down every running counter by the time since the last scan
+static void update_debounce_counters(uint8_t num_rows, uint8_t elapsed)
+{
+    uint8_t *debounce_pointer = debounce_counters;
+
+    counters_need_update = false;
+    for (uint16_t i = 0; i < num_rows * MATRIX_COLS; i++, debounce_pointer++) {
+        if (*debounce_pointer != DEBOUNCE_IDLE) {
+            if (*debounce_pointer > elapsed) {
+                *debounce_pointer -= elapsed;
+                counters_need_update = true;
+            } else {
+                *debounce_pointer = DEBOUNCE_IDLE;
+            }
+        }
+    }
+}
+
+// take any changes from keys that are not locked by a running counter
+static void transfer_matrix_values(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows)
+{
+    uint8_t *debounce_pointer = debounce_counters;
+
+    for (uint8_t row = 0; row < num_rows; row++) {
+        matrix_row_t delta = raw[row] ^ cooked[row];
+        for (uint8_t col = 0; col < MATRIX_COLS; col++, debounce_pointer++) {
+            matrix_row_t col_mask = (matrix_row_t)1 << col;
+            if ((delta & col_mask) && *debounce_pointer == DEBOUNCE_IDLE) {
+                cooked[row] ^= col_mask;
+#if (DEBOUNCE > 0)
+                *debounce_pointer = DEBOUNCE;
+                counters_need_update = true;
+#endif
+            }
+        }
+    }
+}
@@ -0,0 +1,100 @@
+/*
+Copyright 2018 QMK Firmware contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+Basic per-row algorithm. Uses an 8-bit counter per row.
+After pressing a key, it immediately changes state, and sets a counter.
+No further inputs are accepted on that row until DEBOUNCE milliseconds have occurred.
+Costs one byte per row instead of one per key, for RAM-constrained AVR boards.
+*/
+#include "matrix.h"
+#include "timer.h"
+#include "debounce.h"
+
+#if (DEBOUNCE > 0xFF)
+#   error "DEBOUNCE must fit in 8 bits for eager_pr"
+#endif
+
+#define DEBOUNCE_IDLE 0
+
+static uint8_t debounce_counters[MATRIX_ROWS];
+static bool counters_need_update = false;
+static uint16_t last_time;
+
+static void update_debounce_counters(uint8_t num_rows, uint8_t elapsed);
+static void transfer_matrix_values(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows);
+
+void debounce_init(uint8_t num_rows)
+{
+    for (uint8_t i = 0; i < num_rows; i++) {
+        debounce_counters[i] = DEBOUNCE_IDLE;
+    }
+    counters_need_update = false;
+    last_time = timer_read();
+}
+
+void debounce(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, bool changed)
+{
+    uint16_t now = timer_read();
+    uint16_t elapsed = TIMER_DIFF_16(now, last_time);
+    last_time = now;
+
+    // a key unlocked by this update may still have a change waiting
+    bool counters_were_running = counters_need_update;
+    if (counters_need_update && elapsed) {
+        update_debounce_counters(num_rows, elapsed > 0xFF ? 0xFF : elapsed);
+    }
+
+    if (changed || counters_were_running) {
+        transfer_matrix_values(raw, cooked, num_rows);
+    }
+}
+
+bool debounce_active(void)
+{
+    return counters_need_update;
+}
+
+// count down every running counter by the time since the last scan
+static void update_debounce_counters(uint8_t num_rows, uint8_t elapsed)
+{
+    counters_need_update = false;
+    for (uint8_t row = 0; row < num_rows; row++) {
+        if (debounce_counters[row] != DEBOUNCE_IDLE) {
+            if (debounce_counters[row] > elapsed) {
+                debounce_counters[row] -= elapsed;
+                counters_need_update = true;
+            } else {
+                debounce_counters[row] = DEBOUNCE_IDLE;
+            }
+        }
+    }
+}
+
+// take whole rows that changed and are not locked by a running counter
+static void transfer_matrix_values(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows)
+{
+    for (uint8_t row = 0; row < num_rows; row++) {
+        if (raw[row] != cooked[row] && debounce_counters[row] == DEBOUNCE_IDLE) {
+            cooked[row] = raw[row];
+#if (DEBOUNCE > 0)
+            debounce_counters[row] = DEBOUNCE;
+            counters_need_update = true;
+#endif
+        }
+    }
+}
@@ -70,6 +70,7 @@ void dynamic_keymap_set_keycode(uint8_t layer, uint8_t row, uint8_t column, uint
 	// Big endian, so we can read/write EEPROM directly from host if we want
 	eeprom_update_byte(address, (uint8_t)(keycode >> 8));
 	eeprom_update_byte(address+1, (uint8_t)(keycode & 0xFF));
+	layer_cache_invalidate();
 }
 
 void dynamic_keymap_reset(void)
@@ -114,6 +115,7 @@ void dynamic_keymap_set_buffer( uint16_t offset, uint16_t size, uint8_t *data )
 		source++;
 		target++;
 	}
+	layer_cache_invalidate();
 }
 
 // This overrides the one in quantum/keymap_common.c
@@ -19,6 +19,7 @@
 #define DYNAMIC_MACROS_H
 
 #include "action_layer.h"
+#include "timer.h"
 
 #ifndef DYNAMIC_MACRO_SIZE
 /* May be overridden with a custom value. Be aware that the effective
@@ -29,10 +30,24 @@
  * Usually it should be fine to set the macro size to at least 256 but
  * there have been reports of it being too much in some users' cases,
  * so 128 is considered a safe default.
+ *
+ * The value is the RAM of that many keyrecord_t. The events are
+ * recorded in a more compact form, so more than this many fit in it,
+ * see DYNAMIC_MACRO_EVENTS.
  */
 #define DYNAMIC_MACRO_SIZE 128
 #endif
 
+/* How many recorded events are replayed per keyboard_task() call. */
+#ifndef DYNAMIC_MACRO_EVENTS_PER_SCAN
+#define DYNAMIC_MACRO_EVENTS_PER_SCAN 1
+#endif
+
+/* Define DYNAMIC_MACRO_USE_RECORDED_TIMING to replay the events with
+ * the pauses they were recorded with instead of as fast as
+ * DYNAMIC_MACRO_EVENTS_PER_SCAN allows.
+ */
+
 /* DYNAMIC_MACRO_RANGE must be set as the last element of user's
  * "planck_keycodes" enum prior to including this header. This allows
  * us to 'extend' it.
@@ -45,6 +60,45 @@ enum dynamic_macro_keycodes {
     DYN_MACRO_PLAY2,
 };
 
+/* A recorded key event. Instead of the absolute time of the event
+ * only the encoded time since the previous event is kept, see
+ * dynamic_macro_encode_delay().
+ */
+typedef struct {
+    keypos_t key;
+    uint8_t  flags;
+    uint8_t  delay;
+} dynamic_macro_event_t;
+
+#define DYNAMIC_MACRO_PRESSED     0x80
+#define DYNAMIC_MACRO_INTERRUPTED 0x40
+#define DYNAMIC_MACRO_TAP_COUNT   0x0F
+
+/* The number of events fitting in the buffer. */
+#define DYNAMIC_MACRO_EVENTS \
+    (DYNAMIC_MACRO_SIZE * sizeof(keyrecord_t) / sizeof(dynamic_macro_event_t))
+
+/* The macro being replayed. direction is 0 when there is none. */
+typedef struct {
+    dynamic_macro_event_t *next;
+    dynamic_macro_event_t *end;
+    int8_t   direction;
+    /* The layers as seen by the macro. The real layer_state is left to
+     * the keys pressed during the playback. */
+    uint32_t layer_state;
+    uint16_t last_time;
+    /* set while a replayed event is processed */
+    bool     replaying;
+    /* the key that cancelled the playback, its release is dropped too */
+    bool     cancelled;
+    keypos_t cancel_key;
+} dynamic_macro_playback_t;
+
+static dynamic_macro_playback_t dynamic_macro_playback;
+
+/* The time of the last recorded event. */
+static uint16_t dynamic_macro_record_time;
+
 /* Blink the LEDs to notify the user about some event. */
 void dynamic_macro_led_blink(void)
 {
@@ -64,6 +118,28 @@ void dynamic_macro_led_blink(void)
 #define DYNAMIC_MACRO_CURRENT_CAPACITY(BEGIN, END2) \
     ((int)(direction * ((END2) - (BEGIN)) + 1))
 
+/**
+ * Encode the time between two events in a byte. Up to 127ms are
+ * kept exactly, longer pauses in steps of 16ms and anything over
+ * 2160ms is shortened to that.
+ */
+uint8_t dynamic_macro_encode_delay(uint16_t ms)
+{
+    if (ms < 128) {
+        return ms;
+    }
+    ms = (ms - 128) / 16;
+    return 128 + (ms > 127 ? 127 : ms);
+}
+
+uint16_t dynamic_macro_decode_delay(uint8_t delay)
+{
+    if (delay < 128) {
+        return delay;
+    }
+    return 128 + (uint16_t)(delay - 128) * 16;
+}
+
 /**
  * Start recording of the dynamic macro.
  *
@@ -71,7 +147,7 @@ void dynamic_macro_led_blink(void)
  * @param[in]  macro_buffer  The macro buffer used to initialize macro_pointer.
  */
 void dynamic_macro_record_start(
-    keyrecord_t **macro_pointer, keyrecord_t *macro_buffer)
+    dynamic_macro_event_t **macro_pointer, dynamic_macro_event_t *macro_buffer)
 {
     dprintln("dynamic macro recording: started");
 
@@ -83,32 +159,99 @@ void dynamic_macro_record_start(
 }
 
 /**
- * Play the dynamic macro.
+ * Stop the playback of the dynamic macro and release whatever it
+ * left pressed.
+ */
+void dynamic_macro_play_end(void)
+{
+    dynamic_macro_playback.direction = 0;
+    clear_keyboard();
+}
+
+/**
+ * Play the dynamic macro. This only sets up the playback, the events
+ * are replayed by dynamic_macro_task() in the following keyboard_task()
+ * calls.
  *
  * @param macro_buffer[in] The beginning of the macro buffer being played.
  * @param macro_end[in]    The element after the last macro buffer element.
  * @param direction[in]    Either +1 or -1, which way to iterate the buffer.
  */
 void dynamic_macro_play(
-    keyrecord_t *macro_buffer, keyrecord_t *macro_end, int8_t direction)
+    dynamic_macro_event_t *macro_buffer, dynamic_macro_event_t *macro_end, int8_t direction)
 {
     dprintf("dynamic macro: slot %d playback\n", DYNAMIC_MACRO_CURRENT_SLOT());
 
-    uint32_t saved_layer_state = layer_state;
-
     clear_keyboard();
-    layer_clear();
 
-    while (macro_buffer != macro_end) {
-        process_record(macro_buffer);
-        macro_buffer += direction;
+    if (macro_buffer == macro_end) {
+        dynamic_macro_playback.direction = 0;
+        return;
     }
+    dynamic_macro_playback.next = macro_buffer;
+    dynamic_macro_playback.end = macro_end;
+    dynamic_macro_playback.direction = direction;
+    dynamic_macro_playback.layer_state = 0;
+    dynamic_macro_playback.last_time = timer_read();
+}
 
-    clear_keyboard();
+/**
+ * Replay a single recorded event with the layers of the macro.
+ */
+void dynamic_macro_play_event(dynamic_macro_event_t *event)
+{
+    keyrecord_t record = {
+        .event = {
+            .key = event->key,
+            .pressed = event->flags & DYNAMIC_MACRO_PRESSED,
+            .time = timer_read() | 1,
+        },
+    };
+#ifndef NO_ACTION_TAPPING
+    record.tap.interrupted = (event->flags & DYNAMIC_MACRO_INTERRUPTED) != 0;
+    record.tap.count = event->flags & DYNAMIC_MACRO_TAP_COUNT;
+#endif
+
+    uint32_t saved_layer_state = layer_state;
+    layer_state = dynamic_macro_playback.layer_state;
 
+    dynamic_macro_playback.replaying = true;
+    process_record(&record);
+    dynamic_macro_playback.replaying = false;
+
+    dynamic_macro_playback.layer_state = layer_state;
     layer_state = saved_layer_state;
 }
 
+/**
+ * Replay the next events of the macro being played, if any. Called
+ * from keyboard_task() through action_output_task(), waits while the
+ * host driver has no room for more reports.
+ */
+void dynamic_macro_task(void)
+{
+    if (host_keyboard_busy()) {
+        return;
+    }
+    for (uint8_t i = 0; i < DYNAMIC_MACRO_EVENTS_PER_SCAN && dynamic_macro_playback.direction; i++) {
+        dynamic_macro_event_t *event = dynamic_macro_playback.next;
+#ifdef DYNAMIC_MACRO_USE_RECORDED_TIMING
+        uint16_t delay = dynamic_macro_decode_delay(event->delay);
+        if (timer_elapsed(dynamic_macro_playback.last_time) < delay) {
+            return;
+        }
+        /* Late scans are caught up with by the following events. */
+        dynamic_macro_playback.last_time += delay;
+#endif
+        dynamic_macro_playback.next += dynamic_macro_playback.direction;
+        dynamic_macro_play_event(event);
+
+        if (dynamic_macro_playback.next == dynamic_macro_playback.end) {
+            dynamic_macro_play_end();
+        }
+    }
+}
+
 /**
  * Record a single key in a dynamic macro.
  *
@@ -119,9 +262,9 @@ void dynamic_macro_play(
  * @param record[in]     The current keypress.
  */
 void dynamic_macro_record_key(
-    keyrecord_t *macro_buffer,
-    keyrecord_t **macro_pointer,
-    keyrecord_t *macro2_end,
+    dynamic_macro_event_t *macro_buffer,
+    dynamic_macro_event_t **macro_pointer,
+    dynamic_macro_event_t *macro2_end,
     int8_t direction,
     keyrecord_t *record)
 {
@@ -135,7 +278,18 @@ void dynamic_macro_record_key(
      * is safe to use before overwriting the other macro.
      */
     if (*macro_pointer - direction != macro2_end) {
-        **macro_pointer = *record;
+        dynamic_macro_event_t *event = *macro_pointer;
+        event->key = record->event.key;
+        event->flags = record->event.pressed ? DYNAMIC_MACRO_PRESSED : 0;
+#ifndef NO_ACTION_TAPPING
+        if (record->tap.interrupted) {
+            event->flags |= DYNAMIC_MACRO_INTERRUPTED;
+        }
+        event->flags |= record->tap.count & DYNAMIC_MACRO_TAP_COUNT;
+#endif
+        event->delay = *macro_pointer == macro_buffer ? 0 :
+            dynamic_macro_encode_delay(TIMER_DIFF_16(record->event.time, dynamic_macro_record_time));
+        dynamic_macro_record_time = record->event.time;
         *macro_pointer += direction;
     } else {
         dynamic_macro_led_blink();
@@ -153,10 +307,10 @@ void dynamic_macro_record_key(
  * pointer to the end of the macro.
  */
 void dynamic_macro_record_end(
-    keyrecord_t *macro_buffer,
-    keyrecord_t *macro_pointer,
+    dynamic_macro_event_t *macro_buffer,
+    dynamic_macro_event_t *macro_pointer,
     int8_t direction,
-    keyrecord_t **macro_end)
+    dynamic_macro_event_t **macro_end)
 {
     dynamic_macro_led_blink();
 
@@ -164,7 +318,7 @@ void dynamic_macro_record_end(
      * i.e. the keys used to access the layer DYN_REC_STOP is on.
      */
     while (macro_pointer != macro_buffer &&
-           (macro_pointer - direction)->event.pressed) {
+           ((macro_pointer - direction)->flags & DYNAMIC_MACRO_PRESSED)) {
         dprintln("dynamic macro: trimming a trailing key-down event");
         macro_pointer -= direction;
     }
@@ -213,28 +367,49 @@ bool process_record_dynamic_macro(uint16_t keycode, keyrecord_t *record)
      * macros or one long macro and one short macro. Or even one empty
      * and one using the whole buffer.
      */
-    static keyrecord_t macro_buffer[DYNAMIC_MACRO_SIZE];
+    static dynamic_macro_event_t macro_buffer[DYNAMIC_MACRO_EVENTS];
 
     /* Pointer to the first buffer element after the first macro.
      * Initially points to the very beginning of the buffer since the
      * macro is empty. */
-    static keyrecord_t *macro_end = macro_buffer;
+    static dynamic_macro_event_t *macro_end = macro_buffer;
 
     /* The other end of the macro buffer. Serves as the beginning of
      * the second macro. */
-    static keyrecord_t *const r_macro_buffer = macro_buffer + DYNAMIC_MACRO_SIZE - 1;
+    static dynamic_macro_event_t *const r_macro_buffer = macro_buffer + DYNAMIC_MACRO_EVENTS - 1;
 
     /* Like macro_end but for the second macro. */
-    static keyrecord_t *r_macro_end = r_macro_buffer;
+    static dynamic_macro_event_t *r_macro_end = r_macro_buffer;
 
     /* A persistent pointer to the current macro position (iterator)
      * used during the recording. */
-    static keyrecord_t *macro_pointer = NULL;
+    static dynamic_macro_event_t *macro_pointer = NULL;
 
     /* 0   - no macro is being recorded right now
      * 1,2 - either macro 1 or 2 is being recorded */
     static uint8_t macro_id = 0;
 
+    /* The events replayed by dynamic_macro_task() come through here
+     * too, they are only processed normally. */
+    if (dynamic_macro_playback.replaying) {
+        return true;
+    }
+
+    /* Pressing any key stops the playback. That key and its release
+     * are not processed further. */
+    if (dynamic_macro_playback.direction && record->event.pressed) {
+        dprintln("dynamic macro: playback cancelled");
+        dynamic_macro_play_end();
+        dynamic_macro_playback.cancelled = true;
+        dynamic_macro_playback.cancel_key = record->event.key;
+        return false;
+    }
+    if (dynamic_macro_playback.cancelled && !record->event.pressed &&
+        KEYEQ(record->event.key, dynamic_macro_playback.cancel_key)) {
+        dynamic_macro_playback.cancelled = false;
+        return false;
+    }
+
     if (macro_id == 0) {
         /* No macro recording in progress. */
         if (!record->event.pressed) {
@@ -46,6 +46,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 // translates key to keycode
 uint16_t keymap_key_to_keycode(uint8_t layer, keypos_t key);
 
+// translates keycode to action, after keycode_config()
+action_t action_for_keycode(uint16_t keycode);
+
 // translates function id to action
 uint16_t keymap_function_id_to_action( uint16_t function_id );
 
@@ -0,0 +1,81 @@
+/*
+Copyright 2018 QMK Firmware contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef KEYMAP_ACTIONS_H
+#define KEYMAP_ACTIONS_H
+
+#include "keymap.h"
+
+/* With KEYMAP_ACTIONS_ENABLE the build turns keymaps[][][] into a table of
+ * ready-made action codes (util/generate_keymap_actions.sh), which
+ * action_for_key() reads instead of converting the keycode on every press.
+ *
+ * Keycodes whose action depends on runtime state, i.e. magic remapping,
+ * fn_actions or backlight side effects, are stored as KEYMAP_ACTION_DYNAMIC
+ * and still go through action_for_keycode(). 0xFFFF is a function action
+ * that no static keycode converts to.
+ */
+#define KEYMAP_ACTION_DYNAMIC 0xFFFF
+
+/* keycodes that keycode_config() or mod_config() may change at runtime */
+#define KEYMAP_KEYCODE_IS_REMAPPED(kc) \
+    ((kc) == KC_CAPSLOCK || (kc) == KC_LOCKING_CAPS || (kc) == KC_LCTL || \
+     (kc) == KC_LALT || (kc) == KC_LGUI || (kc) == KC_RALT || (kc) == KC_RGUI || \
+     (kc) == KC_GRAVE || (kc) == KC_ESC || (kc) == KC_BSLASH || (kc) == KC_BSPACE || \
+     ((kc) >= QK_MOD_TAP && (kc) <= QK_MOD_TAP_MAX && ((kc) & 0x0C00)))
+
+#define KEYMAP_KEYCODE_IN(kc, min, max) ((kc) >= (min) && (kc) <= (max))
+
+#ifdef SWAP_HANDS_ENABLE
+    #define KEYMAP_KEYCODE_IS_SWAP_HANDS(kc) KEYMAP_KEYCODE_IN(kc, QK_SWAP_HANDS, QK_SWAP_HANDS_MAX)
+#else
+    #define KEYMAP_KEYCODE_IS_SWAP_HANDS(kc) 0
+#endif
+
+/* Constant expression version of action_for_keycode(), the two must agree
+ * for every keycode that does not map to KEYMAP_ACTION_DYNAMIC. */
+#define KEYMAP_STATIC_ACTION(kc) ( \
+    KEYMAP_KEYCODE_IS_REMAPPED(kc)                                ? KEYMAP_ACTION_DYNAMIC : \
+    KEYMAP_KEYCODE_IN(kc, KC_FN0, KC_FN31)                        ? KEYMAP_ACTION_DYNAMIC : \
+    KEYMAP_KEYCODE_IN(kc, KC_A, KC_EXSEL)                         ? ACTION_KEY(kc) : \
+    KEYMAP_KEYCODE_IN(kc, KC_LCTRL, KC_RGUI)                      ? ACTION_KEY(kc) : \
+    KEYMAP_KEYCODE_IN(kc, KC_SYSTEM_POWER, KC_SYSTEM_WAKE)        ? ACTION_USAGE_SYSTEM(KEYCODE2SYSTEM(kc)) : \
+    KEYMAP_KEYCODE_IN(kc, KC_AUDIO_MUTE, KC_BRIGHTNESS_DOWN)      ? ACTION_USAGE_CONSUMER(KEYCODE2CONSUMER(kc)) : \
+    KEYMAP_KEYCODE_IN(kc, KC_MS_UP, KC_MS_ACCEL2)                 ? ACTION_MOUSEKEY(kc) : \
+    (kc) == KC_TRNS                                               ? ACTION_TRANSPARENT : \
+    KEYMAP_KEYCODE_IN(kc, QK_MODS, QK_MODS_MAX)                   ? ACTION_MODS_KEY((kc) >> 8, (kc) & 0xFF) : \
+    KEYMAP_KEYCODE_IN(kc, QK_FUNCTION, QK_FUNCTION_MAX)           ? KEYMAP_ACTION_DYNAMIC : \
+    KEYMAP_KEYCODE_IN(kc, QK_MACRO, QK_MACRO_MAX)                 ? ((kc) & 0x800 ? ACTION_MACRO_TAP((kc) & 0xFF) : ACTION_MACRO((kc) & 0xFF)) : \
+    KEYMAP_KEYCODE_IN(kc, QK_LAYER_TAP, QK_LAYER_TAP_MAX)         ? ACTION_LAYER_TAP_KEY(((kc) >> 0x8) & 0xF, (kc) & 0xFF) : \
+    KEYMAP_KEYCODE_IN(kc, QK_TO, QK_TO_MAX)                       ? ACTION_LAYER_SET((kc) & 0xF, ((kc) >> 0x4) & 0x3) : \
+    KEYMAP_KEYCODE_IN(kc, QK_MOMENTARY, QK_MOMENTARY_MAX)         ? ACTION_LAYER_MOMENTARY((kc) & 0xFF) : \
+    KEYMAP_KEYCODE_IN(kc, QK_DEF_LAYER, QK_DEF_LAYER_MAX)         ? ACTION_DEFAULT_LAYER_SET((kc) & 0xFF) : \
+    KEYMAP_KEYCODE_IN(kc, QK_TOGGLE_LAYER, QK_TOGGLE_LAYER_MAX)   ? ACTION_LAYER_TOGGLE((kc) & 0xFF) : \
+    KEYMAP_KEYCODE_IN(kc, QK_ONE_SHOT_LAYER, QK_ONE_SHOT_LAYER_MAX) ? ACTION_LAYER_ONESHOT((kc) & 0xFF) : \
+    KEYMAP_KEYCODE_IN(kc, QK_ONE_SHOT_MOD, QK_ONE_SHOT_MOD_MAX)   ? ACTION_MODS_ONESHOT((kc) & 0xFF) : \
+    KEYMAP_KEYCODE_IN(kc, QK_LAYER_TAP_TOGGLE, QK_LAYER_TAP_TOGGLE_MAX) ? ACTION_LAYER_TAP_TOGGLE((kc) & 0xFF) : \
+    KEYMAP_KEYCODE_IN(kc, QK_LAYER_MOD, QK_LAYER_MOD_MAX)         ? ACTION_LAYER_MODS(((kc) >> 4) & 0xF, (kc) & 0xF) : \
+    KEYMAP_KEYCODE_IN(kc, QK_MOD_TAP, QK_MOD_TAP_MAX)             ? ACTION_MODS_TAP_KEY(((kc) >> 0x8) & 0x1F, (kc) & 0xFF) : \
+    KEYMAP_KEYCODE_IN(kc, BL_ON, BL_STEP)                         ? KEYMAP_ACTION_DYNAMIC : \
+    KEYMAP_KEYCODE_IS_SWAP_HANDS(kc)                              ? ACTION(ACT_SWAP_HANDS, (kc) & 0xFF) : \
+    ACTION_NO)
+
+/* laid out like keymaps[][][], flat because the generator doesn't know the
+ * matrix size */
+extern const uint16_t keymap_actions[];
+extern const uint8_t keymap_actions_layers;
+
+#endif
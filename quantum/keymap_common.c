@@ -37,6 +37,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 	#include "process_midi.h"
 #endif
 
+#ifdef KEYMAP_ACTIONS_ENABLE
+    #include "keymap_actions.h"
+#endif
+
 extern keymap_config_t keymap_config;
 
 #include <inttypes.h>
@@ -44,12 +48,27 @@ extern keymap_config_t keymap_config;
 /* converts key to action */
 action_t action_for_key(uint8_t layer, keypos_t key)
 {
+#ifdef KEYMAP_ACTIONS_ENABLE
+    if (layer < keymap_actions_layers) {
+        action_t action;
+        action.code = pgm_read_word(&keymap_actions[((uint16_t)layer * MATRIX_ROWS + key.row) * MATRIX_COLS + key.col]);
+        if (action.code != KEYMAP_ACTION_DYNAMIC) {
+            return action;
+        }
+    }
+#endif
     // 16bit keycodes - important
     uint16_t keycode = keymap_key_to_keycode(layer, key);
 
     // keycode remapping
     keycode = keycode_config(keycode);
 
+    return action_for_keycode(keycode);
+}
+
+/* converts keycode to action, after remapping */
+action_t action_for_keycode(uint16_t keycode)
+{
     action_t action;
     uint8_t action_layer, when, mod;
 
@@ -205,7 +224,12 @@ void action_function(keyrecord_t *record, uint8_t id, uint8_t opt)
 }
 
 // translates key to keycode
+#ifndef KEYMAP_ACTIONS_ENABLE
 __attribute__ ((weak))
+#else
+// The action table is built from keymaps[][][], an override would be
+// bypassed, so defining one fails to link instead
+#endif
 uint16_t keymap_key_to_keycode(uint8_t layer, keypos_t key)
 {
     // Read entire word (16bits)
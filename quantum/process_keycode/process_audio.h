@@ -4,6 +4,7 @@
 float compute_freq_for_midi_note(uint8_t note);
 
 bool process_audio(uint16_t keycode, keyrecord_t *record);
+#define PROCESS_AUDIO_KEYCODES AU_ON, MUV_DE
 void process_audio_noteon(uint8_t note);
 void process_audio_noteoff(uint8_t note);
 void process_audio_all_notes_off(void);
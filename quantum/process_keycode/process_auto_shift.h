@@ -24,6 +24,8 @@
 #endif
 
 bool process_auto_shift(uint16_t keycode, keyrecord_t *record);
+/* other keys and mods end a pending auto shift */
+#define PROCESS_AUTO_SHIFT_KEYCODES PROCESS_RECORD_ALL_KEYCODES
 
 void autoshift_enable(void);
 void autoshift_disable(void);
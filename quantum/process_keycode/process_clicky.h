@@ -3,6 +3,8 @@
 
 void clicky_play(void);
 bool process_clicky(uint16_t keycode, keyrecord_t *record);
+/* clicks on every key press */
+#define PROCESS_CLICKY_KEYCODES PROCESS_RECORD_ALL_KEYCODES
 
 void clicky_freq_up(void);
 void clicky_freq_down(void);
@@ -31,7 +31,7 @@ void process_combo_event(uint8_t combo_index, bool pressed) {
 
 }
 
-static uint8_t current_combo_index = 0;
+static uint16_t current_combo_index = 0;
 
 static inline void send_combo(uint16_t action, bool pressed)
 {
@@ -46,26 +46,140 @@ static inline void send_combo(uint16_t action, bool pressed)
     }
 }
 
+/* Reverse index from keycode to the combos using it.
+ *
+ * Each entry packs a combo index and the position of the key in that combo's
+ * key list. Entries are sorted by keycode (then combo index, so combos are
+ * still processed in declaration order) and looked up by binary search, so a
+ * key event only touches the combos that contain the key.
+ */
+#define COMBO_KEY_BITS              5
+#define COMBO_ENTRY(combo, key)     ((uint16_t)(combo) << COMBO_KEY_BITS | (key))
+#define COMBO_ENTRY_COMBO(entry)    ((entry) >> COMBO_KEY_BITS)
+#define COMBO_ENTRY_KEY(entry)      ((entry) & ((1 << COMBO_KEY_BITS) - 1))
+
+#if COMBO_COUNT > (0xFFFF >> COMBO_KEY_BITS)
+#   error "Too many combos for the combo index"
+#endif
+
+static uint16_t combo_index[COMBO_INDEX_SIZE];
+static uint16_t combo_index_count = 0;
+static uint8_t combo_lengths[COMBO_COUNT];
+static bool combo_index_ready = false;
+/* More combo keys than COMBO_INDEX_SIZE, fall back to scanning every combo */
+static bool combo_index_overflow = false;
+
+/* Combos with a running timer, the only ones matrix_scan_combo() looks at */
+static uint8_t armed_combos[(COMBO_COUNT + 7) / 8];
+static uint16_t armed_count = 0;
+
+static inline uint16_t combo_key(uint16_t combo_index, uint8_t key_index)
+{
+    return pgm_read_word(&key_combos[combo_index].keys[key_index]);
+}
+
+static inline uint16_t combo_entry_keycode(uint16_t entry)
+{
+    return combo_key(COMBO_ENTRY_COMBO(entry), COMBO_ENTRY_KEY(entry));
+}
+
+static void set_combo_timer(uint16_t index, uint16_t timer)
+{
+    combo_t *combo = &key_combos[index];
+    bool was_armed = combo->timer && combo->timer != (uint16_t)COMBO_TIMER_ELAPSED;
+    bool is_armed = timer && timer != (uint16_t)COMBO_TIMER_ELAPSED;
+
+    combo->timer = timer;
+    if (was_armed != is_armed) {
+        if (is_armed) {
+            armed_combos[index / 8] |= (1 << (index % 8));
+            armed_count++;
+        } else {
+            armed_combos[index / 8] &= ~(1 << (index % 8));
+            armed_count--;
+        }
+    }
+}
+
+/** \brief Mark the combo index stale
+ *
+ * Call this after changing the keys of an entry in key_combos at runtime.
+ * The index is rebuilt on the next matrix scan, key events until then check
+ * every combo.
+ */
+void combo_index_invalidate(void)
+{
+    combo_index_ready = false;
+}
+
+static void combo_index_build(void)
+{
+    combo_index_count = 0;
+    combo_index_overflow = false;
+
+    for (uint16_t c = 0; c < COMBO_COUNT; ++c) {
+        uint8_t count = 0;
+        for (uint16_t key; COMBO_END != (key = combo_key(c, count)); ++count) {
+            /* A key listed twice only counts at its last position */
+            bool listed_again = false;
+            for (uint8_t later = count + 1; COMBO_END != combo_key(c, later); ++later) {
+                if (combo_key(c, later) == key) {
+                    listed_again = true;
+                    break;
+                }
+            }
+            if (listed_again) continue;
+
+            if (combo_index_count >= COMBO_INDEX_SIZE) {
+                combo_index_overflow = true;
+                continue;
+            }
+
+            /* insertion sort, stable so equal keycodes stay in combo order */
+            uint16_t entry = COMBO_ENTRY(c, count);
+            uint16_t i = combo_index_count++;
+            while (i > 0 && combo_entry_keycode(combo_index[i - 1]) > key) {
+                combo_index[i] = combo_index[i - 1];
+                --i;
+            }
+            combo_index[i] = entry;
+        }
+        combo_lengths[c] = count;
+    }
+
+    if (combo_index_overflow) {
+        dprintf("combo: index full (%u keys), define a larger COMBO_INDEX_SIZE\n", combo_index_count);
+    }
+    combo_index_ready = true;
+}
+
+/* first index entry for keycode, or combo_index_count if there is none */
+static uint16_t combo_index_find(uint16_t keycode)
+{
+    uint16_t low = 0;
+    uint16_t high = combo_index_count;
+
+    while (low < high) {
+        uint16_t mid = low + (high - low) / 2;
+        if (combo_entry_keycode(combo_index[mid]) < keycode) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
 #define ALL_COMBO_KEYS_ARE_DOWN     (((1<<count)-1) == combo->state)
 #define NO_COMBO_KEYS_ARE_DOWN      (0 == combo->state)
 #define KEY_STATE_DOWN(key)         do{ combo->state |= (1<<key); } while(0)
 #define KEY_STATE_UP(key)           do{ combo->state &= ~(1<<key); } while(0)
-static bool process_single_combo(combo_t *combo, uint16_t keycode, keyrecord_t *record) 
+static bool process_single_combo(uint8_t index, uint8_t count, uint16_t keycode, keyrecord_t *record)
 {
-    uint8_t count = 0;
-    uint8_t index = -1;
-    /* Find index of keycode and number of combo keys */
-    for (const uint16_t *keys = combo->keys; ;++count) {
-        uint16_t key = pgm_read_word(&keys[count]);
-        if (keycode == key) index = count;
-        if (COMBO_END == key) break;
-    }
-
-    /* Return if not a combo key */
-    if (-1 == (int8_t)index) return false;
+    combo_t *combo = &key_combos[current_combo_index];
 
     /* The combos timer is used to signal whether the combo is active */
-    bool is_combo_active = COMBO_TIMER_ELAPSED == combo->timer ? false : true;
+    bool is_combo_active = (uint16_t)COMBO_TIMER_ELAPSED == combo->timer ? false : true;
 
     if (record->event.pressed) {
         KEY_STATE_DOWN(index);
@@ -73,9 +187,9 @@ static bool process_single_combo(combo_t *combo, uint16_t keycode, keyrecord_t *
         if (is_combo_active) {
             if (ALL_COMBO_KEYS_ARE_DOWN) { /* Combo was pressed */
                 send_combo(combo->keycode, true);
-                combo->timer = COMBO_TIMER_ELAPSED;
+                set_combo_timer(current_combo_index, COMBO_TIMER_ELAPSED);
             } else { /* Combo key was pressed */
-                combo->timer = timer_read();
+                set_combo_timer(current_combo_index, timer_read());
 #ifdef COMBO_ALLOW_ACTION_KEYS
                 combo->prev_record = *record;
 #else
@@ -99,56 +213,92 @@ static bool process_single_combo(combo_t *combo, uint16_t keycode, keyrecord_t *
             send_keyboard_report();
             unregister_code16(keycode);
 #endif
-            combo->timer = 0;            
+            set_combo_timer(current_combo_index, 0);
         }
 
-        KEY_STATE_UP(index);        
+        KEY_STATE_UP(index);
     }
 
     if (NO_COMBO_KEYS_ARE_DOWN) {
-        combo->timer = 0;
+        set_combo_timer(current_combo_index, 0);
     }
 
     return is_combo_active;
 }
 
+/** \brief Build the combo index
+ *
+ * Called from matrix_init_quantum(), so the first key event doesn't pay for
+ * sorting every combo key.
+ */
+void combo_init(void)
+{
+    combo_index_build();
+}
+
 bool process_combo(uint16_t keycode, keyrecord_t *record)
 {
     bool is_combo_key = false;
 
-    for (current_combo_index = 0; current_combo_index < COMBO_COUNT; ++current_combo_index) {
-        combo_t *combo = &key_combos[current_combo_index];
-        is_combo_key |= process_single_combo(combo, keycode, record);
-    }    
+    /* The index is only built from matrix_scan_combo(), never on a key event */
+    if (!combo_index_ready || combo_index_overflow) {
+        for (current_combo_index = 0; current_combo_index < COMBO_COUNT; ++current_combo_index) {
+            uint8_t index = -1;
+            uint8_t count = 0;
+            for (uint16_t key; COMBO_END != (key = combo_key(current_combo_index, count)); ++count) {
+                if (keycode == key) index = count;
+            }
+            if (-1 != (int8_t)index) {
+                is_combo_key |= process_single_combo(index, count, keycode, record);
+            }
+        }
+        return !is_combo_key;
+    }
+
+    for (uint16_t i = combo_index_find(keycode);
+         i < combo_index_count && combo_entry_keycode(combo_index[i]) == keycode; ++i) {
+        current_combo_index = COMBO_ENTRY_COMBO(combo_index[i]);
+        is_combo_key |= process_single_combo(COMBO_ENTRY_KEY(combo_index[i]),
+                                             combo_lengths[current_combo_index], keycode, record);
+    }
 
     return !is_combo_key;
 }
 
 void matrix_scan_combo(void)
 {
-    for (int i = 0; i < COMBO_COUNT; ++i) {
-        // Do not treat the (weak) key_combos too strict.
-        #pragma GCC diagnostic push
-        #pragma GCC diagnostic ignored "-Warray-bounds"
-        combo_t *combo = &key_combos[i];
-        #pragma GCC diagnostic pop
-        if (combo->timer &&
-            combo->timer != COMBO_TIMER_ELAPSED && 
-            timer_elapsed(combo->timer) > COMBO_TERM) {
-            
-            /* This disables the combo, meaning key events for this
-             * combo will be handled by the next processors in the chain 
-             */
-            combo->timer = COMBO_TIMER_ELAPSED;
+    if (!combo_index_ready) {
+        combo_index_build();
+    }
+
+    if (!armed_count) {
+        return;
+    }
+
+    for (uint16_t byte = 0; byte < sizeof(armed_combos); ++byte) {
+        if (!armed_combos[byte]) continue;
+
+        for (uint8_t bit = 0; bit < 8; ++bit) {
+            if (!(armed_combos[byte] & (1 << bit))) continue;
+
+            uint16_t i = byte * 8 + bit;
+            combo_t *combo = &key_combos[i];
+            if (timer_elapsed(combo->timer) > COMBO_TERM) {
+
+                /* This disables the combo, meaning key events for this
+                 * combo will be handled by the next processors in the chain
+                 */
+                set_combo_timer(i, COMBO_TIMER_ELAPSED);
 
 #ifdef COMBO_ALLOW_ACTION_KEYS
-            process_action(&combo->prev_record, 
-                store_or_get_action(combo->prev_record.event.pressed, 
-                                    combo->prev_record.event.key));
+                process_action(&combo->prev_record,
+                    store_or_get_action(combo->prev_record.event.pressed,
+                                        combo->prev_record.event.key));
 #else
-            unregister_code16(combo->prev_key);
-            register_code16(combo->prev_key);
+                unregister_code16(combo->prev_key);
+                register_code16(combo->prev_key);
 #endif
+            }
         }
     }
 }
@@ -20,6 +20,7 @@
 #include <stdint.h>
 #include "progmem.h"
 #include "quantum.h"
+#include "action_tapping.h"
 
 typedef struct
 {
@@ -51,8 +52,18 @@ typedef struct
 #ifndef COMBO_TERM
 #define COMBO_TERM TAPPING_TERM
 #endif
+/* Number of combo keys the keycode index can hold, 2 bytes of RAM each.
+ * Combos beyond it still work, but every key event scans all combos again.
+ */
+#ifndef COMBO_INDEX_SIZE
+#define COMBO_INDEX_SIZE (COMBO_COUNT * 3)
+#endif
 
 bool process_combo(uint16_t keycode, keyrecord_t *record);
+/* combos can be made of any keys */
+#define PROCESS_COMBO_KEYCODES PROCESS_RECORD_ALL_KEYCODES
+void combo_index_invalidate(void);
+void combo_init(void);
 void matrix_scan_combo(void);
 void process_combo_event(uint8_t combo_index, bool pressed);
 
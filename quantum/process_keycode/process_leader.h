@@ -21,6 +21,8 @@
 
 
 bool process_leader(uint16_t keycode, keyrecord_t *record);
+/* collects every key of a leader sequence */
+#define PROCESS_LEADER_KEYCODES PROCESS_RECORD_ALL_KEYCODES
 
 void leader_start(void);
 void leader_end(void);
@@ -45,6 +45,7 @@ extern midi_config_t midi_config;
 
 void midi_init(void);
 bool process_midi(uint16_t keycode, keyrecord_t *record);
+#define PROCESS_MIDI_KEYCODES MIDI_TONE_MIN, MI_BENDU
 
 #define MIDI_INVALID_NOTE 0xFF
 #define MIDI_TONE_COUNT (MIDI_TONE_MAX - MIDI_TONE_MIN + 1)
@@ -35,6 +35,8 @@ enum music_modes {
 #endif
 
 bool process_music(uint16_t keycode, keyrecord_t *record);
+/* music mode plays every key */
+#define PROCESS_MUSIC_KEYCODES PROCESS_RECORD_ALL_KEYCODES
 
 bool is_music_on(void);
 void music_toggle(void);
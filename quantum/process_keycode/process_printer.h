@@ -22,5 +22,7 @@
 #include "protocol/serial.h"
 
 bool process_printer(uint16_t keycode, keyrecord_t *record);
+/* prints every key while printing is on */
+#define PROCESS_PRINTER_KEYCODES PROCESS_RECORD_ALL_KEYCODES
 
 #endif
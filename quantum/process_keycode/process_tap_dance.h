@@ -93,6 +93,8 @@ extern qk_tap_dance_action_t tap_dance_actions[];
 
 void preprocess_tap_dance(uint16_t keycode, keyrecord_t *record);
 bool process_tap_dance(uint16_t keycode, keyrecord_t *record);
+/* other keys interrupt a running tap dance */
+#define PROCESS_TAP_DANCE_KEYCODES PROCESS_RECORD_ALL_KEYCODES
 void matrix_scan_tap_dance (void);
 void reset_tap_dance (qk_tap_dance_state_t *state);
 
@@ -23,5 +23,7 @@ extern const char keycode_to_ascii_lut[58];
 extern const char shifted_keycode_to_ascii_lut[58];
 extern const char terminal_prompt[8];
 bool process_terminal(uint16_t keycode, keyrecord_t *record);
+/* types every key into the terminal while it is on */
+#define PROCESS_TERMINAL_KEYCODES PROCESS_RECORD_ALL_KEYCODES
 
 #endif
\ No newline at end of file
@@ -48,5 +48,7 @@ void qk_ucis_symbol_fallback (void);
 void qk_ucis_success(uint8_t symbol_index);
 void register_ucis(const char *hex);
 bool process_ucis (uint16_t keycode, keyrecord_t *record);
+/* collects every key of a symbol name */
+#define PROCESS_UCIS_KEYCODES PROCESS_RECORD_ALL_KEYCODES
 
 #endif
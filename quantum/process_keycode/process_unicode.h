@@ -20,5 +20,6 @@
 #include "process_unicode_common.h"
 
 bool process_unicode(uint16_t keycode, keyrecord_t *record);
+#define PROCESS_UNICODE_KEYCODES QK_UNICODE, QK_UNICODE_MAX
 
 #endif
@@ -22,4 +22,5 @@
 
 void unicode_map_input_error(void);
 bool process_unicode_map(uint16_t keycode, keyrecord_t *record);
+#define PROCESS_UNICODE_MAP_KEYCODES QK_UNICODE_MAP, 0xFFFF
 #endif
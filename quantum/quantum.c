@@ -15,6 +15,8 @@
  */
 
 #include "quantum.h"
+#include "progmem.h"
+#include "pipeline_trace.h"
 #ifdef PROTOCOL_LUFA
 #include "outputselect.h"
 #endif
@@ -115,21 +117,26 @@ static inline void qk_unregister_mods(uint8_t kc) {
 }
 
 void register_code16 (uint16_t code) {
+  // All mods go out in one report, the key follows in its own
+  begin_keyboard_report();
   if (IS_MOD(code) || code == KC_NO) {
       do_code16 (code, qk_register_mods);
   } else {
       do_code16 (code, qk_register_weak_mods);
   }
+  commit_keyboard_report();
   register_code (code);
 }
 
 void unregister_code16 (uint16_t code) {
   unregister_code (code);
+  begin_keyboard_report();
   if (IS_MOD(code) || code == KC_NO) {
       do_code16 (code, qk_unregister_mods);
   } else {
       do_code16 (code, qk_unregister_weak_mods);
   }
+  commit_keyboard_report();
 }
 
 __attribute__ ((weak))
@@ -147,6 +154,26 @@ bool process_record_user(uint16_t keycode, keyrecord_t *record) {
   return true;
 }
 
+// Replaced by dynamic_macro.h when a keymap includes it
+__attribute__ ((weak))
+void dynamic_macro_task(void) {
+}
+
+/* Output streamed from keyboard_task(): queued strings and dynamic macro
+ * playback. Key events only wait for the strings. */
+void action_flush_output(void) {
+  send_string_wait();
+}
+
+bool action_output_pending(void) {
+  return send_string_pending();
+}
+
+void action_output_task(void) {
+  send_string_task();
+  dynamic_macro_task();
+}
+
 void reset_keyboard(void) {
   clear_keyboard();
 #if defined(MIDI_ENABLE) && defined(MIDI_BASIC)
@@ -195,6 +222,63 @@ static uint16_t scs_timer[2] = {0, 0};
  */
 static bool grave_esc_was_shifted = false;
 
+typedef struct {
+  uint16_t min;
+  uint16_t max;
+  bool (*handler)(uint16_t keycode, keyrecord_t *record);
+} process_record_handler_t;
+
+/* Handlers in the order process_record_quantum() calls them, each one only
+ * for the keycodes it declared. */
+static const process_record_handler_t PROGMEM process_record_handlers[] = {
+  #if defined(AUDIO_ENABLE) && defined(AUDIO_CLICKY)
+    { PROCESS_CLICKY_KEYCODES, process_clicky },
+  #endif //AUDIO_CLICKY
+    { PROCESS_RECORD_KB_KEYCODES, process_record_kb },
+  #if defined(RGB_MATRIX_ENABLE) && defined(RGB_MATRIX_KEYPRESSES)
+    { PROCESS_RGB_MATRIX_KEYCODES, process_rgb_matrix },
+  #endif
+  #if defined(MIDI_ENABLE) && defined(MIDI_ADVANCED)
+    { PROCESS_MIDI_KEYCODES, process_midi },
+  #endif
+  #ifdef AUDIO_ENABLE
+    { PROCESS_AUDIO_KEYCODES, process_audio },
+  #endif
+  #ifdef STENO_ENABLE
+    { PROCESS_STENO_KEYCODES, process_steno },
+  #endif
+  #if ( defined(AUDIO_ENABLE) || (defined(MIDI_ENABLE) && defined(MIDI_BASIC))) && !defined(NO_MUSIC_MODE)
+    { PROCESS_MUSIC_KEYCODES, process_music },
+  #endif
+  #ifdef TAP_DANCE_ENABLE
+    { PROCESS_TAP_DANCE_KEYCODES, process_tap_dance },
+  #endif
+  #ifdef LEADER_ENABLE
+    { PROCESS_LEADER_KEYCODES, process_leader },
+  #endif
+  #ifdef COMBO_ENABLE
+    { PROCESS_COMBO_KEYCODES, process_combo },
+  #endif
+  #ifdef UNICODE_ENABLE
+    { PROCESS_UNICODE_KEYCODES, process_unicode },
+  #endif
+  #ifdef UCIS_ENABLE
+    { PROCESS_UCIS_KEYCODES, process_ucis },
+  #endif
+  #ifdef PRINTING_ENABLE
+    { PROCESS_PRINTER_KEYCODES, process_printer },
+  #endif
+  #ifdef AUTO_SHIFT_ENABLE
+    { PROCESS_AUTO_SHIFT_KEYCODES, process_auto_shift },
+  #endif
+  #ifdef UNICODEMAP_ENABLE
+    { PROCESS_UNICODE_MAP_KEYCODES, process_unicode_map },
+  #endif
+  #ifdef TERMINAL_ENABLE
+    { PROCESS_TERMINAL_KEYCODES, process_terminal },
+  #endif
+};
+
 bool process_record_quantum(keyrecord_t *record) {
 
   /* This gets the keycode from the key pressed */
@@ -229,59 +313,22 @@ bool process_record_quantum(keyrecord_t *record) {
     preprocess_tap_dance(keycode, record);
   #endif
 
-  if (!(
   #if defined(KEY_LOCK_ENABLE)
     // Must run first to be able to mask key_up events.
-    process_key_lock(&keycode, record) &&
-  #endif
-  #if defined(AUDIO_ENABLE) && defined(AUDIO_CLICKY)
-      process_clicky(keycode, record) &&
-  #endif //AUDIO_CLICKY
-    process_record_kb(keycode, record) &&
-  #if defined(RGB_MATRIX_ENABLE) && defined(RGB_MATRIX_KEYPRESSES)
-    process_rgb_matrix(keycode, record) &&
-  #endif
-  #if defined(MIDI_ENABLE) && defined(MIDI_ADVANCED)
-    process_midi(keycode, record) &&
-  #endif
-  #ifdef AUDIO_ENABLE
-    process_audio(keycode, record) &&
-  #endif
-  #ifdef STENO_ENABLE
-    process_steno(keycode, record) &&
-  #endif
-  #if ( defined(AUDIO_ENABLE) || (defined(MIDI_ENABLE) && defined(MIDI_BASIC))) && !defined(NO_MUSIC_MODE)
-    process_music(keycode, record) &&
-  #endif
-  #ifdef TAP_DANCE_ENABLE
-    process_tap_dance(keycode, record) &&
-  #endif
-  #ifdef LEADER_ENABLE
-    process_leader(keycode, record) &&
-  #endif
-  #ifdef COMBO_ENABLE
-    process_combo(keycode, record) &&
-  #endif
-  #ifdef UNICODE_ENABLE
-    process_unicode(keycode, record) &&
-  #endif
-  #ifdef UCIS_ENABLE
-    process_ucis(keycode, record) &&
-  #endif
-  #ifdef PRINTING_ENABLE
-    process_printer(keycode, record) &&
-  #endif
-  #ifdef AUTO_SHIFT_ENABLE
-    process_auto_shift(keycode, record) &&
-  #endif
-  #ifdef UNICODEMAP_ENABLE
-    process_unicode_map(keycode, record) &&
-  #endif
-  #ifdef TERMINAL_ENABLE
-    process_terminal(keycode, record) &&
+    if (!process_key_lock(&keycode, record)) {
+      return false;
+    }
   #endif
-      true)) {
-    return false;
+
+  for (uint8_t i = 0; i < sizeof(process_record_handlers) / sizeof(process_record_handlers[0]); i++) {
+    const process_record_handler_t *entry = &process_record_handlers[i];
+    if (keycode < pgm_read_word(&entry->min) || keycode > pgm_read_word(&entry->max)) {
+      continue;
+    }
+    bool (*handler)(uint16_t, keyrecord_t *) = pgm_read_ptr(&entry->handler);
+    if (!handler(keycode, record)) {
+      return false;
+    }
   }
 
   // Shift / paren setup
@@ -824,80 +871,6 @@ const uint8_t ascii_to_keycode_lut[0x80] PROGMEM = {
     KC_X, KC_Y, KC_Z, KC_LBRC, KC_BSLS, KC_RBRC, KC_GRV, KC_DEL
 };
 
-void send_string(const char *str) {
-  send_string_with_delay(str, 0);
-}
-
-void send_string_P(const char *str) {
-  send_string_with_delay_P(str, 0);
-}
-
-void send_string_with_delay(const char *str, uint8_t interval) {
-    while (1) {
-        char ascii_code = *str;
-        if (!ascii_code) break;
-        if (ascii_code == 1) {
-          // tap
-          uint8_t keycode = *(++str);
-          register_code(keycode);
-          unregister_code(keycode);
-        } else if (ascii_code == 2) {
-          // down
-          uint8_t keycode = *(++str);
-          register_code(keycode);
-        } else if (ascii_code == 3) {
-          // up
-          uint8_t keycode = *(++str);
-          unregister_code(keycode);
-        } else {
-          send_char(ascii_code);
-        }
-        ++str;
-        // interval
-        { uint8_t ms = interval; while (ms--) wait_ms(1); }
-    }
-}
-
-void send_string_with_delay_P(const char *str, uint8_t interval) {
-    while (1) {
-        char ascii_code = pgm_read_byte(str);
-        if (!ascii_code) break;
-        if (ascii_code == 1) {
-          // tap
-          uint8_t keycode = pgm_read_byte(++str);
-          register_code(keycode);
-          unregister_code(keycode);
-        } else if (ascii_code == 2) {
-          // down
-          uint8_t keycode = pgm_read_byte(++str);
-          register_code(keycode);
-        } else if (ascii_code == 3) {
-          // up
-          uint8_t keycode = pgm_read_byte(++str);
-          unregister_code(keycode);
-        } else {
-          send_char(ascii_code);
-        }
-        ++str;
-        // interval
-        { uint8_t ms = interval; while (ms--) wait_ms(1); }
-    }
-}
-
-void send_char(char ascii_code) {
-  uint8_t keycode;
-  keycode = pgm_read_byte(&ascii_to_keycode_lut[(uint8_t)ascii_code]);
-  if (pgm_read_byte(&ascii_to_shift_lut[(uint8_t)ascii_code])) {
-      register_code(KC_LSFT);
-      register_code(keycode);
-      unregister_code(keycode);
-      unregister_code(KC_LSFT);
-  } else {
-      register_code(keycode);
-      unregister_code(keycode);
-  }
-}
-
 void set_single_persistent_default_layer(uint8_t default_layer) {
   #if defined(AUDIO_ENABLE) && defined(DEFAULT_LAYER_SONGS)
     PLAY_SONG(default_layer_songs[default_layer]);
@@ -1002,15 +975,12 @@ void matrix_init_quantum() {
   #ifdef ENCODER_ENABLE
     encoder_init();
   #endif
+  #ifdef COMBO_ENABLE
+    combo_init();
+  #endif
   matrix_init_kb();
 }
 
-uint8_t rgb_matrix_task_counter = 0;
-
-#ifndef RGB_MATRIX_SKIP_FRAMES
-  #define RGB_MATRIX_SKIP_FRAMES 1
-#endif
-
 void matrix_scan_quantum() {
   #if defined(AUDIO_ENABLE) && !defined(NO_MUSIC_MODE)
     matrix_scan_music();
@@ -1029,11 +999,9 @@ void matrix_scan_quantum() {
   #endif
 
   #ifdef RGB_MATRIX_ENABLE
+    PIPELINE_TRACE_BEGIN(PIPELINE_TRACE_RGB);
     rgb_matrix_task();
-    if (rgb_matrix_task_counter == 0) {
-      rgb_matrix_update_pwm_buffers();
-    }
-    rgb_matrix_task_counter = ((rgb_matrix_task_counter + 1) % (RGB_MATRIX_SKIP_FRAMES + 1));
+    PIPELINE_TRACE_END(PIPELINE_TRACE_RGB);
   #endif
 
   #ifdef ENCODER_ENABLE
@@ -206,6 +206,13 @@ void send_string_with_delay(const char *str, uint8_t interval);
 void send_string_P(const char *str);
 void send_string_with_delay_P(const char *str, uint8_t interval);
 void send_char(char ascii_code);
+/* strings are typed out by send_string_task() from keyboard_task() */
+void send_string_task(void);
+bool send_string_pending(void);
+void send_string_wait(void);
+
+/* replays a dynamic macro from keyboard_task(), see dynamic_macro.h */
+void dynamic_macro_task(void);
 
 // For tri-layer
 void update_tri_layer(uint8_t layer1, uint8_t layer2, uint8_t layer3);
@@ -226,6 +233,12 @@ bool process_action_kb(keyrecord_t *record);
 bool process_record_kb(uint16_t keycode, keyrecord_t *record);
 bool process_record_user(uint16_t keycode, keyrecord_t *record);
 
+/* Each process_* handler declares the keycodes it needs to see as a
+ * PROCESS_*_KEYCODES min, max pair; process_record_quantum() skips it for
+ * any other keycode. */
+#define PROCESS_RECORD_ALL_KEYCODES 0x0000, 0xFFFF
+#define PROCESS_RECORD_KB_KEYCODES PROCESS_RECORD_ALL_KEYCODES
+
 #ifndef BOOTMAGIC_LITE_COLUMN
   #define BOOTMAGIC_LITE_COLUMN 0
 #endif
@@ -50,6 +50,21 @@ rgb_config_t rgb_matrix_config;
     #define RGB_MATRIX_MAXIMUM_BRIGHTNESS 255
 #endif
 
+#ifndef RGB_MATRIX_SKIP_FRAMES
+    #define RGB_MATRIX_SKIP_FRAMES 1
+#endif
+
+// Number of LEDs rendered per rgb_matrix_task() call; the default renders
+// the whole frame at once
+#ifndef RGB_MATRIX_LED_PROCESS_LIMIT
+    #define RGB_MATRIX_LED_PROCESS_LIMIT DRIVER_LED_TOTAL
+#endif
+
+// Number of LEDs an effect converts from HSV to RGB in one batch
+#ifndef RGB_MATRIX_HSV_BATCH_SIZE
+    #define RGB_MATRIX_HSV_BATCH_SIZE 8
+#endif
+
 #ifndef RGB_DIGITAL_RAIN_DROPS
     // lower the number for denser effect/wider keyboard
     #define RGB_DIGITAL_RAIN_DROPS 24
@@ -136,6 +151,13 @@ void rgb_matrix_set_color_all( uint8_t red, uint8_t green, uint8_t blue ) {
     rgb_matrix_driver.set_color_all(red, green, blue);
 }
 
+// Sets the LEDs in [led_min, led_max) to one colour
+static void rgb_matrix_set_color_range( uint8_t led_min, uint8_t led_max, uint8_t red, uint8_t green, uint8_t blue ) {
+    for ( uint8_t i = led_min; i < led_max; i++ ) {
+        rgb_matrix_set_color( i, red, green, blue );
+    }
+}
+
 bool process_rgb_matrix(uint16_t keycode, keyrecord_t *record) {
     if ( record->event.pressed ) {
         uint8_t led[8], led_count;
@@ -167,7 +189,7 @@ void rgb_matrix_set_suspend_state(bool state) {
     g_suspend_state = state;
 }
 
-void rgb_matrix_test(void) {
+void rgb_matrix_test(uint8_t led_min, uint8_t led_max) {
     // Mask out bits 4 and 5
     // Increase the factor to make the test animation slower (and reduce to make it faster)
     uint8_t factor = 10;
@@ -175,42 +197,51 @@ void rgb_matrix_test(void) {
     {
         case 0:
         {
-            rgb_matrix_set_color_all( 20, 0, 0 );
+            rgb_matrix_set_color_range( led_min, led_max, 20, 0, 0 );
             break;
         }
         case 1:
         {
-            rgb_matrix_set_color_all( 0, 20, 0 );
+            rgb_matrix_set_color_range( led_min, led_max, 0, 20, 0 );
             break;
         }
         case 2:
         {
-            rgb_matrix_set_color_all( 0, 0, 20 );
+            rgb_matrix_set_color_range( led_min, led_max, 0, 0, 20 );
             break;
         }
         case 3:
         {
-            rgb_matrix_set_color_all( 20, 20, 20 );
+            rgb_matrix_set_color_range( led_min, led_max, 20, 20, 20 );
             break;
         }
     }
 }
 
+// Converts count colors in one go and sets the LEDs from first on to them
+static void rgb_matrix_set_hsv_batch( uint8_t first, HSV *hsv, uint8_t count ) {
+    RGB rgb[RGB_MATRIX_HSV_BATCH_SIZE];
+    hsv_to_rgb_batch( hsv, rgb, count, true );
+    for ( uint8_t j = 0; j < count; j++ ) {
+        rgb_matrix_set_color( first + j, rgb[j].r, rgb[j].g, rgb[j].b );
+    }
+}
+
 // All LEDs off
-void rgb_matrix_all_off(void) {
-    rgb_matrix_set_color_all( 0, 0, 0 );
+void rgb_matrix_all_off(uint8_t led_min, uint8_t led_max) {
+    rgb_matrix_set_color_range( led_min, led_max, 0, 0, 0 );
 }
 
 // Solid color
-void rgb_matrix_solid_color(void) {
+void rgb_matrix_solid_color(uint8_t led_min, uint8_t led_max) {
     HSV hsv = { .h = rgb_matrix_config.hue, .s = rgb_matrix_config.sat, .v = rgb_matrix_config.val };
     RGB rgb = hsv_to_rgb( hsv );
-    rgb_matrix_set_color_all( rgb.r, rgb.g, rgb.b );
+    rgb_matrix_set_color_range( led_min, led_max, rgb.r, rgb.g, rgb.b );
 }
 
-void rgb_matrix_solid_reactive(void) {
+void rgb_matrix_solid_reactive(uint8_t led_min, uint8_t led_max) {
 	// Relies on hue being 8-bit and wrapping
-	for ( int i=0; i<DRIVER_LED_TOTAL; i++ )
+	for ( int i=led_min; i<led_max; i++ )
 	{
 		uint16_t offset2 = g_key_hit[i]<<2;
 		offset2 = (offset2<=130) ? (130-offset2) : 0;
@@ -222,13 +253,13 @@ void rgb_matrix_solid_reactive(void) {
 }
 
 // alphas = color1, mods = color2
-void rgb_matrix_alphas_mods(void) {
+void rgb_matrix_alphas_mods(uint8_t led_min, uint8_t led_max) {
 
     RGB rgb1 = hsv_to_rgb( (HSV){ .h = rgb_matrix_config.hue, .s = rgb_matrix_config.sat, .v = rgb_matrix_config.val } );
     RGB rgb2 = hsv_to_rgb( (HSV){ .h = (rgb_matrix_config.hue + 180) % 360, .s = rgb_matrix_config.sat, .v = rgb_matrix_config.val } );
 
     rgb_led led;
-    for (int i = 0; i < DRIVER_LED_TOTAL; i++) {
+    for (int i = led_min; i < led_max; i++) {
         led = g_rgb_leds[i];
         if ( led.matrix_co.raw < 0xFF ) {
             if ( led.modifier )
@@ -243,7 +274,7 @@ void rgb_matrix_alphas_mods(void) {
     }
 }
 
-void rgb_matrix_gradient_up_down(void) {
+void rgb_matrix_gradient_up_down(uint8_t led_min, uint8_t led_max) {
     int16_t h1 = rgb_matrix_config.hue;
     int16_t h2 = (rgb_matrix_config.hue + 180) % 360;
     int16_t deltaH = h2 - h1;
@@ -264,24 +295,27 @@ void rgb_matrix_gradient_up_down(void) {
     int16_t s2 = rgb_matrix_config.hue;
     int16_t deltaS = ( s2 - s1 ) / 4;
 
-    HSV hsv = { .h = 0, .s = 255, .v = rgb_matrix_config.val };
-    RGB rgb;
+    HSV hsv[RGB_MATRIX_HSV_BATCH_SIZE];
     Point point;
-    for ( int i=0; i<DRIVER_LED_TOTAL; i++ )
+    for ( int i=led_min; i<led_max; i+=RGB_MATRIX_HSV_BATCH_SIZE )
     {
-        // map_led_to_point( i, &point );
-        point = g_rgb_leds[i].point;
-        // The y range will be 0..64, map this to 0..4
-        uint8_t y = (point.y>>4);
-        // Relies on hue being 8-bit and wrapping
-        hsv.h = rgb_matrix_config.hue + ( deltaH * y );
-        hsv.s = rgb_matrix_config.sat + ( deltaS * y );
-        rgb = hsv_to_rgb( hsv );
-        rgb_matrix_set_color( i, rgb.r, rgb.g, rgb.b );
+        uint8_t count = MIN(led_max - i, RGB_MATRIX_HSV_BATCH_SIZE);
+        for ( uint8_t j=0; j<count; j++ )
+        {
+            // map_led_to_point( i + j, &point );
+            point = g_rgb_leds[i + j].point;
+            // The y range will be 0..64, map this to 0..4
+            uint8_t y = (point.y>>4);
+            // Relies on hue being 8-bit and wrapping
+            hsv[j].h = rgb_matrix_config.hue + ( deltaH * y );
+            hsv[j].s = rgb_matrix_config.sat + ( deltaS * y );
+            hsv[j].v = rgb_matrix_config.val;
+        }
+        rgb_matrix_set_hsv_batch( i, hsv, count );
     }
 }
 
-void rgb_matrix_raindrops(bool initialize) {
+void rgb_matrix_raindrops(bool initialize, uint8_t led_min, uint8_t led_max) {
     int16_t h1 = rgb_matrix_config.hue;
     int16_t h2 = (rgb_matrix_config.hue + 180) % 360;
     int16_t deltaH = h2 - h1;
@@ -304,10 +338,14 @@ void rgb_matrix_raindrops(bool initialize) {
     HSV hsv;
     RGB rgb;
 
-    // Change one LED every tick, make sure speed is not 0
-    uint8_t led_to_change = ( g_tick & ( 0x0A / (rgb_matrix_config.speed == 0 ? 1 : rgb_matrix_config.speed) ) ) == 0 ? rand() % (DRIVER_LED_TOTAL) : 255;
+    // Change one LED every tick, make sure speed is not 0.
+    // Picked once per frame, as a frame may be rendered in several ranges.
+    static uint8_t led_to_change = 255;
+    if ( led_min == 0 ) {
+        led_to_change = ( g_tick & ( 0x0A / (rgb_matrix_config.speed == 0 ? 1 : rgb_matrix_config.speed) ) ) == 0 ? rand() % (DRIVER_LED_TOTAL) : 255;
+    }
 
-    for ( int i=0; i<DRIVER_LED_TOTAL; i++ )
+    for ( int i=led_min; i<led_max; i++ )
     {
         // If initialize, all get set to random colors
         // If not, all but one will stay the same as before.
@@ -324,13 +362,13 @@ void rgb_matrix_raindrops(bool initialize) {
     }
 }
 
-void rgb_matrix_cycle_all(void) {
+void rgb_matrix_cycle_all(uint8_t led_min, uint8_t led_max) {
     uint8_t offset = ( g_tick << rgb_matrix_config.speed ) & 0xFF;
 
     rgb_led led;
 
     // Relies on hue being 8-bit and wrapping
-    for ( int i=0; i<DRIVER_LED_TOTAL; i++ )
+    for ( int i=led_min; i<led_max; i++ )
     {
         // map_index_to_led(i, &led);
         led = g_rgb_leds[i];
@@ -345,13 +383,13 @@ void rgb_matrix_cycle_all(void) {
     }
 }
 
-void rgb_matrix_cycle_left_right(void) {
+void rgb_matrix_cycle_left_right(uint8_t led_min, uint8_t led_max) {
     uint8_t offset = ( g_tick << rgb_matrix_config.speed ) & 0xFF;
     HSV hsv = { .h = 0, .s = 255, .v = rgb_matrix_config.val };
     RGB rgb;
     Point point;
     rgb_led led;
-    for ( int i=0; i<DRIVER_LED_TOTAL; i++ )
+    for ( int i=led_min; i<led_max; i++ )
     {
         // map_index_to_led(i, &led);
         led = g_rgb_leds[i];
@@ -369,13 +407,13 @@ void rgb_matrix_cycle_left_right(void) {
     }
 }
 
-void rgb_matrix_cycle_up_down(void) {
+void rgb_matrix_cycle_up_down(uint8_t led_min, uint8_t led_max) {
     uint8_t offset = ( g_tick << rgb_matrix_config.speed ) & 0xFF;
     HSV hsv = { .h = 0, .s = 255, .v = rgb_matrix_config.val };
     RGB rgb;
     Point point;
     rgb_led led;
-    for ( int i=0; i<DRIVER_LED_TOTAL; i++ )
+    for ( int i=led_min; i<led_max; i++ )
     {
         // map_index_to_led(i, &led);
         led = g_rgb_leds[i];
@@ -394,73 +432,89 @@ void rgb_matrix_cycle_up_down(void) {
 }
 
 
-void rgb_matrix_dual_beacon(void) {
-    HSV hsv = { .h = rgb_matrix_config.hue, .s = rgb_matrix_config.sat, .v = rgb_matrix_config.val };
-    RGB rgb;
+void rgb_matrix_dual_beacon(uint8_t led_min, uint8_t led_max) {
+    HSV hsv[RGB_MATRIX_HSV_BATCH_SIZE];
     Point point;
     double cos_value = cos(g_tick * PI / 128) / 32;
     double sin_value =  sin(g_tick * PI / 128) / 112;
-    for (uint8_t i = 0; i < DRIVER_LED_TOTAL; i++) {
-        point = g_rgb_leds[i].point;
-        hsv.h = ((point.y - 32.0)* cos_value + (point.x - 112.0) * sin_value) * (180) + rgb_matrix_config.hue;
-        rgb = hsv_to_rgb( hsv );
-        rgb_matrix_set_color( i, rgb.r, rgb.g, rgb.b );
+    for (int i = led_min; i < led_max; i += RGB_MATRIX_HSV_BATCH_SIZE) {
+        uint8_t count = MIN(led_max - i, RGB_MATRIX_HSV_BATCH_SIZE);
+        for (uint8_t j = 0; j < count; j++) {
+            point = g_rgb_leds[i + j].point;
+            hsv[j].h = ((point.y - 32.0)* cos_value + (point.x - 112.0) * sin_value) * (180) + rgb_matrix_config.hue;
+            hsv[j].s = rgb_matrix_config.sat;
+            hsv[j].v = rgb_matrix_config.val;
+        }
+        rgb_matrix_set_hsv_batch( i, hsv, count );
     }
 }
 
-void rgb_matrix_rainbow_beacon(void) {
-    HSV hsv = { .h = rgb_matrix_config.hue, .s = rgb_matrix_config.sat, .v = rgb_matrix_config.val };
-    RGB rgb;
+void rgb_matrix_rainbow_beacon(uint8_t led_min, uint8_t led_max) {
+    HSV hsv[RGB_MATRIX_HSV_BATCH_SIZE];
     Point point;
     double cos_value = cos(g_tick * PI / 128);
     double sin_value =  sin(g_tick * PI / 128);
-    for (uint8_t i = 0; i < DRIVER_LED_TOTAL; i++) {
-        point = g_rgb_leds[i].point;
-        hsv.h = (1.5 * (rgb_matrix_config.speed == 0 ? 1 : rgb_matrix_config.speed)) * (point.y - 32.0)* cos_value + (1.5 * (rgb_matrix_config.speed == 0 ? 1 : rgb_matrix_config.speed)) * (point.x - 112.0) * sin_value + rgb_matrix_config.hue;
-        rgb = hsv_to_rgb( hsv );
-        rgb_matrix_set_color( i, rgb.r, rgb.g, rgb.b );
+    for (int i = led_min; i < led_max; i += RGB_MATRIX_HSV_BATCH_SIZE) {
+        uint8_t count = MIN(led_max - i, RGB_MATRIX_HSV_BATCH_SIZE);
+        for (uint8_t j = 0; j < count; j++) {
+            point = g_rgb_leds[i + j].point;
+            hsv[j].h = (1.5 * (rgb_matrix_config.speed == 0 ? 1 : rgb_matrix_config.speed)) * (point.y - 32.0)* cos_value + (1.5 * (rgb_matrix_config.speed == 0 ? 1 : rgb_matrix_config.speed)) * (point.x - 112.0) * sin_value + rgb_matrix_config.hue;
+            hsv[j].s = rgb_matrix_config.sat;
+            hsv[j].v = rgb_matrix_config.val;
+        }
+        rgb_matrix_set_hsv_batch( i, hsv, count );
     }
 }
 
-void rgb_matrix_rainbow_pinwheels(void) {
-    HSV hsv = { .h = rgb_matrix_config.hue, .s = rgb_matrix_config.sat, .v = rgb_matrix_config.val };
-    RGB rgb;
+void rgb_matrix_rainbow_pinwheels(uint8_t led_min, uint8_t led_max) {
+    HSV hsv[RGB_MATRIX_HSV_BATCH_SIZE];
     Point point;
     double cos_value = cos(g_tick * PI / 128);
     double sin_value =  sin(g_tick * PI / 128);
-    for (uint8_t i = 0; i < DRIVER_LED_TOTAL; i++) {
-        point = g_rgb_leds[i].point;
-        hsv.h = (2 * (rgb_matrix_config.speed == 0 ? 1 : rgb_matrix_config.speed)) * (point.y - 32.0)* cos_value + (2 * (rgb_matrix_config.speed == 0 ? 1 : rgb_matrix_config.speed)) * (66 - abs(point.x - 112.0)) * sin_value + rgb_matrix_config.hue;
-        rgb = hsv_to_rgb( hsv );
-        rgb_matrix_set_color( i, rgb.r, rgb.g, rgb.b );
+    for (int i = led_min; i < led_max; i += RGB_MATRIX_HSV_BATCH_SIZE) {
+        uint8_t count = MIN(led_max - i, RGB_MATRIX_HSV_BATCH_SIZE);
+        for (uint8_t j = 0; j < count; j++) {
+            point = g_rgb_leds[i + j].point;
+            hsv[j].h = (2 * (rgb_matrix_config.speed == 0 ? 1 : rgb_matrix_config.speed)) * (point.y - 32.0)* cos_value + (2 * (rgb_matrix_config.speed == 0 ? 1 : rgb_matrix_config.speed)) * (66 - abs(point.x - 112.0)) * sin_value + rgb_matrix_config.hue;
+            hsv[j].s = rgb_matrix_config.sat;
+            hsv[j].v = rgb_matrix_config.val;
+        }
+        rgb_matrix_set_hsv_batch( i, hsv, count );
     }
 }
 
-void rgb_matrix_rainbow_moving_chevron(void) {
-    HSV hsv = { .h = rgb_matrix_config.hue, .s = rgb_matrix_config.sat, .v = rgb_matrix_config.val };
-    RGB rgb;
+void rgb_matrix_rainbow_moving_chevron(uint8_t led_min, uint8_t led_max) {
+    HSV hsv[RGB_MATRIX_HSV_BATCH_SIZE];
     Point point;
     uint8_t r = 128;
     double cos_value = cos(r * PI / 128);
     double sin_value =  sin(r * PI / 128);
     double multiplier = (g_tick / 256.0 * 224);
-    for (uint8_t i = 0; i < DRIVER_LED_TOTAL; i++) {
-        point = g_rgb_leds[i].point;
-        hsv.h = (1.5 * (rgb_matrix_config.speed == 0 ? 1 : rgb_matrix_config.speed)) * abs(point.y - 32.0)* sin_value + (1.5 * (rgb_matrix_config.speed == 0 ? 1 : rgb_matrix_config.speed)) * (point.x - multiplier) * cos_value + rgb_matrix_config.hue;
-        rgb = hsv_to_rgb( hsv );
-        rgb_matrix_set_color( i, rgb.r, rgb.g, rgb.b );
+    for (int i = led_min; i < led_max; i += RGB_MATRIX_HSV_BATCH_SIZE) {
+        uint8_t count = MIN(led_max - i, RGB_MATRIX_HSV_BATCH_SIZE);
+        for (uint8_t j = 0; j < count; j++) {
+            point = g_rgb_leds[i + j].point;
+            hsv[j].h = (1.5 * (rgb_matrix_config.speed == 0 ? 1 : rgb_matrix_config.speed)) * abs(point.y - 32.0)* sin_value + (1.5 * (rgb_matrix_config.speed == 0 ? 1 : rgb_matrix_config.speed)) * (point.x - multiplier) * cos_value + rgb_matrix_config.hue;
+            hsv[j].s = rgb_matrix_config.sat;
+            hsv[j].v = rgb_matrix_config.val;
+        }
+        rgb_matrix_set_hsv_batch( i, hsv, count );
     }
 }
 
 
-void rgb_matrix_jellybean_raindrops( bool initialize ) {
+void rgb_matrix_jellybean_raindrops(bool initialize, uint8_t led_min, uint8_t led_max) {
     HSV hsv;
     RGB rgb;
 
-    // Change one LED every tick, make sure speed is not 0
-    uint8_t led_to_change = ( g_tick & ( 0x0A / (rgb_matrix_config.speed == 0 ? 1 : rgb_matrix_config.speed) ) ) == 0 ? rand() % (DRIVER_LED_TOTAL) : 255;
+    // Change one LED every tick, make sure speed is not 0.
+    // Picked once per frame, as a frame may be rendered in several ranges.
+    static uint8_t led_to_change = 255;
+    if ( led_min == 0 ) {
+        led_to_change = ( g_tick & ( 0x0A / (rgb_matrix_config.speed == 0 ? 1 : rgb_matrix_config.speed) ) ) == 0 ? rand() % (DRIVER_LED_TOTAL) : 255;
+    }
 
-    for ( int i=0; i<DRIVER_LED_TOTAL; i++ )
+    for ( int i=led_min; i<led_max; i++ )
     {
         // If initialize, all get set to random colors
         // If not, all but one will stay the same as before.
@@ -477,7 +531,7 @@ void rgb_matrix_jellybean_raindrops( bool initialize ) {
     }
 }
 
-void rgb_matrix_digital_rain( const bool initialize ) {
+void rgb_matrix_digital_rain(const bool initialize, uint8_t led_min, uint8_t led_max) {
     // algorithm ported from https://github.com/tremby/Kaleidoscope-LEDEffect-DigitalRain
     const uint8_t drop_ticks           = 28;
     const uint8_t pure_green_intensity = 0xd0;
@@ -487,64 +541,72 @@ void rgb_matrix_digital_rain( const bool initialize ) {
     static uint8_t map[MATRIX_COLS][MATRIX_ROWS] = {{0}};
     static uint8_t drop = 0;
 
-    if (initialize) {
-        rgb_matrix_set_color_all(0, 0, 0);
-        memset(map, 0, sizeof map);
-        drop = 0;
-    }
-    for (uint8_t col = 0; col < MATRIX_COLS; col++) {
-        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
-            if (row == 0 && drop == 0 && rand() < RAND_MAX / RGB_DIGITAL_RAIN_DROPS) {
-                // top row, pixels have just fallen and we're
-                // making a new rain drop in this column
-                map[col][row] = max_intensity;
-            }
-            else if (map[col][row] > 0 && map[col][row] < max_intensity) {
-                // neither fully bright nor dark, decay it
-                map[col][row]--;
-            }
-            // set the pixel colour
-            uint8_t led, led_count;
-            map_row_column_to_led(row, col, &led, &led_count);
-
-            if (map[col][row] > pure_green_intensity) {
-                const uint8_t boost = (uint8_t) ((uint16_t) max_brightness_boost
-                        * (map[col][row] - pure_green_intensity) / (max_intensity - pure_green_intensity));
-                rgb_matrix_set_color(led, boost, max_intensity, boost);
-            }
-            else {
-                const uint8_t green = (uint8_t) ((uint16_t) max_intensity * map[col][row] / pure_green_intensity);
-                rgb_matrix_set_color(led, 0, green, 0);
-            }
+    // The rain is advanced once per frame, then painted range by range
+    if (led_min == 0) {
+        if (initialize) {
+            rgb_matrix_set_color_all(0, 0, 0);
+            memset(map, 0, sizeof map);
+            drop = 0;
         }
-    }
-    if (++drop > drop_ticks) {
-        // reset drop timer
-        drop = 0;
-        for (uint8_t row = MATRIX_ROWS - 1; row > 0; row--) {
-            for (uint8_t col = 0; col < MATRIX_COLS; col++) {
-                // if ths is on the bottom row and bright allow decay
-                if (row == MATRIX_ROWS - 1 && map[col][row] == max_intensity) {
-                    map[col][row]--;
+        else if (++drop > drop_ticks) {
+            // reset drop timer
+            drop = 0;
+            for (uint8_t row = MATRIX_ROWS - 1; row > 0; row--) {
+                for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                    // if ths is on the bottom row and bright allow decay
+                    if (row == MATRIX_ROWS - 1 && map[col][row] == max_intensity) {
+                        map[col][row]--;
+                    }
+                    // check if the pixel above is bright
+                    if (map[col][row - 1] == max_intensity) {
+                        // allow old bright pixel to decay
+                        map[col][row - 1]--;
+                        // make this pixel bright
+                        map[col][row] = max_intensity;
+                    }
                 }
-                // check if the pixel above is bright
-                if (map[col][row - 1] == max_intensity) {
-                    // allow old bright pixel to decay
-                    map[col][row - 1]--;
-                    // make this pixel bright
+            }
+        }
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+                if (row == 0 && drop == 0 && rand() < RAND_MAX / RGB_DIGITAL_RAIN_DROPS) {
+                    // top row, pixels have just fallen and we're
+                    // making a new rain drop in this column
                     map[col][row] = max_intensity;
                 }
+                else if (map[col][row] > 0 && map[col][row] < max_intensity) {
+                    // neither fully bright nor dark, decay it
+                    map[col][row]--;
+                }
             }
         }
     }
+    rgb_led led;
+    for (uint8_t i = led_min; i < led_max; i++) {
+        led = g_rgb_leds[i];
+        if (led.matrix_co.raw == 0xFF || led.matrix_co.row >= MATRIX_ROWS || led.matrix_co.col >= MATRIX_COLS) {
+            continue;
+        }
+        // set the pixel colour
+        const uint8_t intensity = map[led.matrix_co.col][led.matrix_co.row];
+        if (intensity > pure_green_intensity) {
+            const uint8_t boost = (uint8_t) ((uint16_t) max_brightness_boost
+                    * (intensity - pure_green_intensity) / (max_intensity - pure_green_intensity));
+            rgb_matrix_set_color(i, boost, max_intensity, boost);
+        }
+        else {
+            const uint8_t green = (uint8_t) ((uint16_t) max_intensity * intensity / pure_green_intensity);
+            rgb_matrix_set_color(i, 0, green, 0);
+        }
+    }
 }
 
-void rgb_matrix_multisplash(void) {
+void rgb_matrix_multisplash(uint8_t led_min, uint8_t led_max) {
     // if (g_any_key_hit < 0xFF) {
         HSV hsv = { .h = rgb_matrix_config.hue, .s = rgb_matrix_config.sat, .v = rgb_matrix_config.val };
         RGB rgb;
         rgb_led led;
-        for (uint8_t i = 0; i < DRIVER_LED_TOTAL; i++) {
+        for (uint8_t i = led_min; i < led_max; i++) {
             led = g_rgb_leds[i];
             uint16_t c = 0, d = 0;
             rgb_led last_led;
@@ -570,18 +632,18 @@ void rgb_matrix_multisplash(void) {
 }
 
 
-void rgb_matrix_splash(void) {
+void rgb_matrix_splash(uint8_t led_min, uint8_t led_max) {
     g_last_led_count = MIN(g_last_led_count, 1);
-    rgb_matrix_multisplash();
+    rgb_matrix_multisplash(led_min, led_max);
 }
 
 
-void rgb_matrix_solid_multisplash(void) {
+void rgb_matrix_solid_multisplash(uint8_t led_min, uint8_t led_max) {
     // if (g_any_key_hit < 0xFF) {
         HSV hsv = { .h = rgb_matrix_config.hue, .s = rgb_matrix_config.sat, .v = rgb_matrix_config.val };
         RGB rgb;
         rgb_led led;
-        for (uint8_t i = 0; i < DRIVER_LED_TOTAL; i++) {
+        for (uint8_t i = led_min; i < led_max; i++) {
             led = g_rgb_leds[i];
             uint16_t d = 0;
             rgb_led last_led;
@@ -605,18 +667,18 @@ void rgb_matrix_solid_multisplash(void) {
 }
 
 
-void rgb_matrix_solid_splash(void) {
+void rgb_matrix_solid_splash(uint8_t led_min, uint8_t led_max) {
     g_last_led_count = MIN(g_last_led_count, 1);
-    rgb_matrix_solid_multisplash();
+    rgb_matrix_solid_multisplash(led_min, led_max);
 }
 
 
 // Needs eeprom access that we don't have setup currently
 
-void rgb_matrix_custom(void) {
+void rgb_matrix_custom(uint8_t led_min, uint8_t led_max) {
 //     HSV hsv;
 //     RGB rgb;
-//     for ( int i=0; i<DRIVER_LED_TOTAL; i++ )
+//     for ( int i=led_min; i<led_max; i++ )
 //     {
 //         backlight_get_key_color(i, &hsv);
 //         // Override brightness with global brightness control
@@ -626,23 +688,39 @@ void rgb_matrix_custom(void) {
 //     }
 }
 
-void rgb_matrix_task(void) {
+// A frame is rendered RGB_MATRIX_LED_PROCESS_LIMIT LEDs per task call into
+// the driver buffers, which are only flushed once the whole frame is done.
+static struct {
+    uint8_t effect;
+    uint8_t next_led;
+    bool rendering;
+    bool initialize;
+    bool all_off;
+    bool indicators;
+} rgb_frame;
+
+// Picks the effect for the next frame and advances the effect timers.
+// Returns false while rendering should not start yet.
+static bool rgb_matrix_start_frame(void) {
   #ifdef TRACK_PREVIOUS_EFFECT
       static uint8_t toggle_enable_last = 255;
   #endif
+    rgb_frame.initialize = false;
+    rgb_frame.all_off = false;
+    rgb_frame.indicators = true;
+
 	if (!rgb_matrix_config.enable) {
-     rgb_matrix_all_off();
-     rgb_matrix_indicators();
+     rgb_frame.all_off = true;
      #ifdef TRACK_PREVIOUS_EFFECT
          toggle_enable_last = rgb_matrix_config.enable;
      #endif
-     return;
+     return true;
     }
     // delay 1 second before driving LEDs or doing anything else
     static uint8_t startup_tick = 0;
     if ( startup_tick < 20 ) {
         startup_tick++;
-        return;
+        return false;
     }
 
     g_tick++;
@@ -661,15 +739,17 @@ void rgb_matrix_task(void) {
 
     // Factory default magic value
     if ( rgb_matrix_config.mode == 255 ) {
-        rgb_matrix_test();
-        return;
+        rgb_frame.effect = 255;
+        rgb_frame.indicators = false;
+        return true;
     }
 
     // Ideally we would also stop sending zeros to the LED driver PWM buffers
     // while suspended and just do a software shutdown. This is a cheap hack for now.
     bool suspend_backlight = ((g_suspend_state && RGB_DISABLE_WHEN_USB_SUSPENDED) ||
             (RGB_DISABLE_AFTER_TIMEOUT > 0 && g_any_key_hit > RGB_DISABLE_AFTER_TIMEOUT * 60 * 20));
-    uint8_t effect = suspend_backlight ? 0 : rgb_matrix_config.mode;
+    rgb_frame.effect = suspend_backlight ? 0 : rgb_matrix_config.mode;
+    rgb_frame.indicators = !suspend_backlight;
 
     #ifdef TRACK_PREVIOUS_EFFECT
         // Keep track of the effect used last time,
@@ -677,114 +757,153 @@ void rgb_matrix_task(void) {
         // have an optional initialization.
 
         static uint8_t effect_last = 255;
-        bool initialize = (effect != effect_last) || (rgb_matrix_config.enable != toggle_enable_last);
-        effect_last = effect;
+        rgb_frame.initialize = (rgb_frame.effect != effect_last) || (rgb_matrix_config.enable != toggle_enable_last);
+        effect_last = rgb_frame.effect;
         toggle_enable_last = rgb_matrix_config.enable;
     #endif
 
-    // this gets ticked at 20 Hz.
+    return true;
+}
+
+// Renders the LEDs in [led_min, led_max) of the current frame
+static void rgb_matrix_render(uint8_t led_min, uint8_t led_max) {
+    if ( rgb_frame.all_off ) {
+        rgb_matrix_all_off( led_min, led_max );
+        return;
+    }
+
+    if ( rgb_frame.effect == 255 ) {
+        rgb_matrix_test( led_min, led_max );
+        return;
+    }
+
     // each effect can opt to do calculations
     // and/or request PWM buffer updates.
-    switch ( effect ) {
+    switch ( rgb_frame.effect ) {
         case RGB_MATRIX_SOLID_COLOR:
-            rgb_matrix_solid_color();
+            rgb_matrix_solid_color( led_min, led_max );
             break;
         #ifndef DISABLE_RGB_MATRIX_ALPHAS_MODS
             case RGB_MATRIX_ALPHAS_MODS:
-                rgb_matrix_alphas_mods();
+                rgb_matrix_alphas_mods( led_min, led_max );
                 break;
         #endif
         #ifndef DISABLE_RGB_MATRIX_DUAL_BEACON
             case RGB_MATRIX_DUAL_BEACON:
-                rgb_matrix_dual_beacon();
+                rgb_matrix_dual_beacon( led_min, led_max );
                 break;
         #endif
         #ifndef DISABLE_RGB_MATRIX_GRADIENT_UP_DOWN
             case RGB_MATRIX_GRADIENT_UP_DOWN:
-                rgb_matrix_gradient_up_down();
+                rgb_matrix_gradient_up_down( led_min, led_max );
                 break;
         #endif
         #ifndef DISABLE_RGB_MATRIX_RAINDROPS
             case RGB_MATRIX_RAINDROPS:
-                rgb_matrix_raindrops( initialize );
+                rgb_matrix_raindrops( rgb_frame.initialize, led_min, led_max );
                 break;
         #endif
         #ifndef DISABLE_RGB_MATRIX_CYCLE_ALL
             case RGB_MATRIX_CYCLE_ALL:
-                rgb_matrix_cycle_all();
+                rgb_matrix_cycle_all( led_min, led_max );
                 break;
         #endif
         #ifndef DISABLE_RGB_MATRIX_CYCLE_LEFT_RIGHT
             case RGB_MATRIX_CYCLE_LEFT_RIGHT:
-                rgb_matrix_cycle_left_right();
+                rgb_matrix_cycle_left_right( led_min, led_max );
                 break;
         #endif
         #ifndef DISABLE_RGB_MATRIX_CYCLE_UP_DOWN
             case RGB_MATRIX_CYCLE_UP_DOWN:
-                rgb_matrix_cycle_up_down();
+                rgb_matrix_cycle_up_down( led_min, led_max );
                 break;
         #endif
         #ifndef DISABLE_RGB_MATRIX_RAINBOW_BEACON
             case RGB_MATRIX_RAINBOW_BEACON:
-                rgb_matrix_rainbow_beacon();
+                rgb_matrix_rainbow_beacon( led_min, led_max );
                 break;
         #endif
         #ifndef DISABLE_RGB_MATRIX_RAINBOW_PINWHEELS
             case RGB_MATRIX_RAINBOW_PINWHEELS:
-                rgb_matrix_rainbow_pinwheels();
+                rgb_matrix_rainbow_pinwheels( led_min, led_max );
                 break;
         #endif
         #ifndef DISABLE_RGB_MATRIX_RAINBOW_MOVING_CHEVRON
             case RGB_MATRIX_RAINBOW_MOVING_CHEVRON:
-                rgb_matrix_rainbow_moving_chevron();
+                rgb_matrix_rainbow_moving_chevron( led_min, led_max );
                 break;
         #endif
         #ifndef DISABLE_RGB_MATRIX_JELLYBEAN_RAINDROPS
             case RGB_MATRIX_JELLYBEAN_RAINDROPS:
-                rgb_matrix_jellybean_raindrops( initialize );
+                rgb_matrix_jellybean_raindrops( rgb_frame.initialize, led_min, led_max );
                 break;
         #endif
         #ifndef DISABLE_RGB_MATRIX_DIGITAL_RAIN
             case RGB_MATRIX_DIGITAL_RAIN:
-                rgb_matrix_digital_rain( initialize );
+                rgb_matrix_digital_rain( rgb_frame.initialize, led_min, led_max );
                 break;
         #endif
         #ifdef RGB_MATRIX_KEYPRESSES
             #ifndef DISABLE_RGB_MATRIX_SOLID_REACTIVE
                 case RGB_MATRIX_SOLID_REACTIVE:
-                    rgb_matrix_solid_reactive();
+                    rgb_matrix_solid_reactive( led_min, led_max );
                     break;
             #endif
             #ifndef DISABLE_RGB_MATRIX_SPLASH
                 case RGB_MATRIX_SPLASH:
-                    rgb_matrix_splash();
+                    rgb_matrix_splash( led_min, led_max );
                     break;
             #endif
             #ifndef DISABLE_RGB_MATRIX_MULTISPLASH
                 case RGB_MATRIX_MULTISPLASH:
-                    rgb_matrix_multisplash();
+                    rgb_matrix_multisplash( led_min, led_max );
                     break;
             #endif
             #ifndef DISABLE_RGB_MATRIX_SOLID_SPLASH
                 case RGB_MATRIX_SOLID_SPLASH:
-                    rgb_matrix_solid_splash();
+                    rgb_matrix_solid_splash( led_min, led_max );
                     break;
             #endif
             #ifndef DISABLE_RGB_MATRIX_SOLID_MULTISPLASH
                 case RGB_MATRIX_SOLID_MULTISPLASH:
-                    rgb_matrix_solid_multisplash();
+                    rgb_matrix_solid_multisplash( led_min, led_max );
                     break;
             #endif
         #endif
         default:
-            rgb_matrix_custom();
+            rgb_matrix_custom( led_min, led_max );
             break;
     }
+}
 
-    if ( ! suspend_backlight ) {
-        rgb_matrix_indicators();
+void rgb_matrix_task(void) {
+    static uint8_t flush_counter = 0;
+
+    if ( !rgb_frame.rendering ) {
+        if ( !rgb_matrix_start_frame() ) {
+            return;
+        }
+        rgb_frame.rendering = true;
+        rgb_frame.next_led = 0;
     }
 
+    uint8_t led_min = rgb_frame.next_led;
+    uint8_t led_max = MIN(led_min + RGB_MATRIX_LED_PROCESS_LIMIT, DRIVER_LED_TOTAL);
+    rgb_matrix_render( led_min, led_max );
+    rgb_frame.next_led = led_max;
+    if ( led_max < DRIVER_LED_TOTAL ) {
+        return;
+    }
+
+    // The frame is complete, so it can be shown without tearing
+    rgb_frame.rendering = false;
+    if ( rgb_frame.indicators ) {
+        rgb_matrix_indicators();
+    }
+    if ( flush_counter == 0 ) {
+        rgb_matrix_update_pwm_buffers();
+    }
+    flush_counter = ((flush_counter + 1) % (RGB_MATRIX_SKIP_FRAMES + 1));
 }
 
 void rgb_matrix_indicators(void) {
@@ -150,6 +150,8 @@ void rgb_matrix_task(void);
 void rgb_matrix_update_pwm_buffers(void);
 
 bool process_rgb_matrix(uint16_t keycode, keyrecord_t *record);
+/* reacts to every key press */
+#define PROCESS_RGB_MATRIX_KEYCODES PROCESS_RECORD_ALL_KEYCODES
 
 void rgb_matrix_increase(void);
 void rgb_matrix_decrease(void);
@@ -0,0 +1,311 @@
+/* Copyright 2018 QMK Firmware contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include "quantum.h"
+#include "progmem.h"
+#include "timer.h"
+#if defined(PROTOCOL_LUFA) || defined(PROTOCOL_CHIBIOS)
+#include "protocol/usb_descriptor.h"
+#endif
+
+/* Strings are not typed out while the caller waits. send_string() queues
+ * them and send_string_task() emits one report per call, no faster than
+ * SEND_STRING_REPORT_INTERVAL, so the scan loop keeps running.
+ *
+ * Reports are planned a character at a time. A character key replaces the
+ * previous one in the same report and shift stays down across a run of
+ * shifted characters, so "Hello" takes 6 reports instead of 14. A release
+ * is only sent when the same key comes twice in a row, before SS_DOWN/UP
+ * codes, with an interval, and at the end of the string.
+ *
+ * The character key and shift are laid over keyboard_report when sending,
+ * without changing it. Key events wait in the event queue until the queued
+ * strings are typed, and register_code() from the same handler first
+ * finishes them with send_string_wait(), so the output keeps its order.
+ */
+
+/* Time between two reports of a string. Reports sent faster than the host
+ * polls the keyboard would only queue up or block in the USB driver. */
+#ifndef SEND_STRING_REPORT_INTERVAL
+#   ifdef KEYBOARD_POLLING_INTERVAL_MS
+#       define SEND_STRING_REPORT_INTERVAL KEYBOARD_POLLING_INTERVAL_MS
+#   else
+#       define SEND_STRING_REPORT_INTERVAL 10
+#   endif
+#endif
+
+/* Number of strings that can be waiting. PROGMEM strings are read in place,
+ * strings in RAM are copied to a buffer of SEND_STRING_BUFFER_SIZE bytes as
+ * the caller's copy may not outlive the call. When either runs out,
+ * send_string() blocks until the queued strings are typed. */
+#ifndef SEND_STRING_QUEUE_SIZE
+#   define SEND_STRING_QUEUE_SIZE 4
+#endif
+#ifndef SEND_STRING_BUFFER_SIZE
+#   define SEND_STRING_BUFFER_SIZE 64
+#endif
+
+#if SEND_STRING_BUFFER_SIZE > 255
+#   error "SEND_STRING_BUFFER_SIZE can't be larger than 255"
+#endif
+
+#define SS_TAP_CODE  1
+#define SS_DOWN_CODE 2
+#define SS_UP_CODE   3
+
+typedef struct {
+    const char *str;
+    uint8_t interval;
+    bool progmem;
+} send_string_source_t;
+
+static send_string_source_t queue[SEND_STRING_QUEUE_SIZE];
+static uint8_t queue_head = 0;
+static uint8_t queue_count = 0;
+
+static char buffer[SEND_STRING_BUFFER_SIZE];
+static uint8_t buffer_used = 0;
+
+/* state of the report laid over keyboard_report */
+static uint8_t held_key = 0;
+static bool held_shift = false;
+/* non-character key of a SS_TAP that still has to be released */
+static uint8_t pending_release = 0;
+
+static uint16_t last_report_time = 0;
+static uint8_t next_delay = 0;
+static bool stepping = false;
+
+static char source_byte(const send_string_source_t *source, uint8_t offset) {
+    if (source->progmem) {
+        return pgm_read_byte(source->str + offset);
+    }
+    return source->str[offset];
+}
+
+static void send_held_report(void) {
+    if (!held_key && !held_shift) {
+        send_keyboard_report();
+        return;
+    }
+    report_keyboard_t report = *keyboard_report;
+    if (held_key) {
+        add_key_to_report(&report, held_key);
+    }
+    if (held_shift) {
+        report.mods |= MOD_BIT(KC_LSFT);
+    }
+    host_keyboard_send(&report);
+}
+
+static void release_held(bool keep_shift) {
+    held_key = 0;
+    held_shift = held_shift && keep_shift;
+    send_held_report();
+}
+
+static void pop_source(void) {
+    queue_head = (queue_head + 1) % SEND_STRING_QUEUE_SIZE;
+    queue_count--;
+    if (!queue_count) {
+        buffer_used = 0;
+    }
+}
+
+/** \brief Advance the oldest string by one report
+ *
+ * Returns false when nothing was sent, i.e. a string ended or a character
+ * has no key.
+ */
+static bool send_string_step(void) {
+    send_string_source_t *source = &queue[queue_head];
+    next_delay = 0;
+
+    if (pending_release) {
+        unregister_code(pending_release);
+        pending_release = 0;
+        next_delay = source->interval;
+        return true;
+    }
+
+    char ascii_code = source_byte(source, 0);
+    if (!ascii_code) {
+        if (held_key || held_shift) {
+            release_held(false);
+            return true;
+        }
+        pop_source();
+        return false;
+    }
+
+    uint8_t key;
+    bool shift;
+    uint8_t length = 1;
+    if (ascii_code == SS_TAP_CODE || ascii_code == SS_DOWN_CODE || ascii_code == SS_UP_CODE) {
+        uint8_t keycode = source_byte(source, 1);
+        if (ascii_code != SS_TAP_CODE || !IS_KEY(keycode)) {
+            // Mods, media keys and held keys go through the normal report
+            if (held_key || held_shift) {
+                release_held(false);
+                return true;
+            }
+            source->str += 2;
+            if (ascii_code == SS_UP_CODE) {
+                unregister_code(keycode);
+                next_delay = source->interval;
+            } else {
+                register_code(keycode);
+                if (ascii_code == SS_TAP_CODE) {
+                    pending_release = keycode;
+                } else {
+                    next_delay = source->interval;
+                }
+            }
+            return true;
+        }
+        key = keycode;
+        shift = false;
+        length = 2;
+    } else {
+        key = pgm_read_byte(&ascii_to_keycode_lut[(uint8_t)ascii_code]);
+        shift = pgm_read_byte(&ascii_to_shift_lut[(uint8_t)ascii_code]);
+        if (!key) {
+            source->str++;
+            return false;
+        }
+    }
+
+    if (held_key == key || (held_key && (source->interval || (held_shift && !shift)))) {
+        // The host only sees a key twice if it is released in between, and
+        // shift is let go on its own so it can't reach the next key late
+        release_held(shift && !source->interval);
+        next_delay = source->interval;
+        return true;
+    }
+    held_key = key;
+    held_shift = shift;
+    send_held_report();
+    source->str += length;
+    return true;
+}
+
+/** \brief Send the next report of a queued string when it is due
+ *
+ * Called from keyboard_task() through action_output_task(). Waits while
+ * the host driver has no room for more reports.
+ */
+void send_string_task(void) {
+    if (stepping || host_keyboard_busy()) {
+        return;
+    }
+    stepping = true;
+    while (queue_count && timer_elapsed(last_report_time) >= SEND_STRING_REPORT_INTERVAL + next_delay) {
+        if (send_string_step()) {
+            last_report_time = timer_read();
+            break;
+        }
+    }
+    stepping = false;
+}
+
+/** \brief Is a string still being typed */
+bool send_string_pending(void) {
+    return queue_count;
+}
+
+/** \brief Type the queued strings out before returning */
+void send_string_wait(void) {
+    if (stepping) {
+        return;
+    }
+    stepping = true;
+    while (queue_count) {
+        if (send_string_step()) {
+            uint8_t ms = next_delay;
+            while (ms--) wait_ms(1);
+        }
+    }
+    last_report_time = timer_read();
+    stepping = false;
+}
+
+static void send_string_queue(const char *str, uint8_t interval, bool progmem) {
+    bool borrowed = false;
+    if (queue_count == SEND_STRING_QUEUE_SIZE) {
+        send_string_wait();
+    }
+    if (!progmem) {
+        size_t length = strlen(str) + 1;
+        if (length > (size_t)(SEND_STRING_BUFFER_SIZE - buffer_used)) {
+            send_string_wait();
+        }
+        if (length <= SEND_STRING_BUFFER_SIZE) {
+            memcpy(&buffer[buffer_used], str, length);
+            str = &buffer[buffer_used];
+            buffer_used += length;
+        } else {
+            borrowed = true;
+        }
+    }
+    if (!queue_count) {
+        next_delay = 0;
+        if (timer_elapsed(last_report_time) >= SEND_STRING_REPORT_INTERVAL) {
+            // Nothing to pace against, start on the next task call
+            last_report_time = timer_read() - SEND_STRING_REPORT_INTERVAL;
+        }
+    }
+    send_string_source_t *source = &queue[(queue_head + queue_count) % SEND_STRING_QUEUE_SIZE];
+    source->str = str;
+    source->interval = interval;
+    source->progmem = progmem;
+    queue_count++;
+    if (borrowed) {
+        // Too long for the buffer, type it while the caller's copy is valid
+        send_string_wait();
+    }
+}
+
+void send_string(const char *str) {
+    send_string_with_delay(str, 0);
+}
+
+void send_string_P(const char *str) {
+    send_string_with_delay_P(str, 0);
+}
+
+void send_string_with_delay(const char *str, uint8_t interval) {
+    send_string_queue(str, interval, false);
+}
+
+void send_string_with_delay_P(const char *str, uint8_t interval) {
+    send_string_queue(str, interval, true);
+}
+
+void send_char(char ascii_code) {
+    send_string_wait();
+    uint8_t keycode;
+    keycode = pgm_read_byte(&ascii_to_keycode_lut[(uint8_t)ascii_code]);
+    if (pgm_read_byte(&ascii_to_shift_lut[(uint8_t)ascii_code])) {
+        register_code(KC_LSFT);
+        register_code(keycode);
+        unregister_code(keycode);
+        unregister_code(KC_LSFT);
+    } else {
+        register_code(keycode);
+        unregister_code(keycode);
+    }
+}
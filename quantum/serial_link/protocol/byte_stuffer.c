@@ -102,41 +102,63 @@ void byte_stuffer_recv_byte(uint8_t link, uint8_t data) {
     }
 }
 
-static void send_block(uint8_t link, uint8_t* start, uint8_t* end, uint8_t num_non_zero) {
+// Sends the block from position start_pos of part start_part to end_pos of
+// end_part, it can span several parts
+static void send_block(uint8_t link, frame_part_t* parts, uint8_t start_part, uint16_t start_pos,
+        uint8_t end_part, uint16_t end_pos, uint8_t num_non_zero) {
     send_data(link, &num_non_zero, 1);
-    if (end > start) {
-        send_data(link, start, end-start);
+    uint8_t part;
+    for (part=start_part;part<=end_part;part++) {
+        uint16_t start = part == start_part ? start_pos : 0;
+        uint16_t end = part == end_part ? end_pos : parts[part].size;
+        if (end > start) {
+            send_data(link, parts[part].data + start, end - start);
+        }
     }
 }
 
 void byte_stuffer_send_frame(uint8_t link, uint8_t* data, uint16_t size) {
+    frame_part_t part = {data, size};
+    byte_stuffer_send_frame_parts(link, &part, 1);
+}
+
+void byte_stuffer_send_frame_parts(uint8_t link, frame_part_t* parts, uint8_t num_parts) {
     const uint8_t zero = 0;
-    if (size > 0) {
-        uint16_t num_non_zero = 1;
-        uint8_t* end = data + size;
-        uint8_t* start = data;
-        while (data < end) {
+    uint16_t num_non_zero = 1;
+    uint8_t start_part = 0;
+    uint16_t start_pos = 0;
+    bool empty = true;
+    uint8_t part;
+    for (part=0;part<num_parts;part++) {
+        uint8_t* data = parts[part].data;
+        uint16_t pos = 0;
+        while (pos < parts[part].size) {
+            empty = false;
             if (num_non_zero == 0xFF) {
                 // There's more data after big non-zero block
                 // So send it, and start a new block
-                send_block(link, start, data, num_non_zero);
-                start = data;
+                send_block(link, parts, start_part, start_pos, part, pos, num_non_zero);
+                start_part = part;
+                start_pos = pos;
                 num_non_zero = 1;
             }
             else {
-                if (*data == 0) {
+                if (data[pos] == 0) {
                     // A zero encountered, so send the block
-                    send_block(link, start, data, num_non_zero);
-                    start = data + 1;
+                    send_block(link, parts, start_part, start_pos, part, pos, num_non_zero);
+                    start_part = part;
+                    start_pos = pos + 1;
                     num_non_zero = 1;
                 }
                 else {
                     num_non_zero++;
                 }
-                ++data;
+                ++pos;
             }
         }
-        send_block(link, start, data, num_non_zero);
+    }
+    if (!empty) {
+        send_block(link, parts, start_part, start_pos, num_parts - 1, parts[num_parts - 1].size, num_non_zero);
         send_data(link, &zero, 1);
     }
 }
@@ -30,8 +30,16 @@ SOFTWARE.
 #define MAX_FRAME_SIZE 1024
 #define NUM_LINKS 2
 
+// A piece of a frame that is sent from where it is stored
+typedef struct {
+    uint8_t* data;
+    uint16_t size;
+} frame_part_t;
+
 void init_byte_stuffer(void);
 void byte_stuffer_recv_byte(uint8_t link, uint8_t data);
 void byte_stuffer_send_frame(uint8_t link, uint8_t* data, uint16_t size);
+// Sends the parts as one frame
+void byte_stuffer_send_frame_parts(uint8_t link, frame_part_t* parts, uint8_t num_parts);
 
 #endif
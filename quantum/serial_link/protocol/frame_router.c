@@ -54,16 +54,22 @@ void route_incoming_frame(uint8_t link, uint8_t* data, uint16_t size){
 }
 
 void router_send_frame(uint8_t destination, uint8_t* data, uint16_t size) {
+    frame_part_t part = {data, size};
+    router_send_frame_parts(destination, &part, 1);
+}
+
+void router_send_frame_parts(uint8_t destination, frame_part_t* parts, uint8_t num_parts) {
+    frame_part_t* last = &parts[num_parts - 1];
     if (destination == 0) {
         if (!is_master) {
-            data[size] = 1;
-            validator_send_frame(UP_LINK, data, size + 1);
+            last->data[last->size++] = 1;
+            validator_send_frame_parts(UP_LINK, parts, num_parts);
         }
     }
     else {
         if (is_master) {
-            data[size] = destination;
-            validator_send_frame(DOWN_LINK, data, size + 1);
+            last->data[last->size++] = destination;
+            validator_send_frame_parts(DOWN_LINK, parts, num_parts);
         }
     }
 }
@@ -27,12 +27,16 @@ SOFTWARE.
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "serial_link/protocol/byte_stuffer.h"
 
 #define UP_LINK 0
 #define DOWN_LINK 1
 
 void router_set_master(bool master);
 void route_incoming_frame(uint8_t link, uint8_t* data, uint16_t size);
+// The buffer pointed to by the data needs 5 additional bytes
 void router_send_frame(uint8_t destination, uint8_t* data, uint16_t size);
+// The last part needs 5 additional bytes
+void router_send_frame_parts(uint8_t destination, frame_part_t* parts, uint8_t num_parts);
 
 #endif
@@ -95,10 +95,15 @@ const uint32_t poly8_lookup[256] =
  0xB40BBE37, 0xC30C8EA1, 0x5A05DF1B, 0x2D02EF8D
 };
 
-static uint32_t crc32_byte(uint8_t *p, uint32_t bytelength)
+static uint32_t crc32_update(uint32_t crc, uint8_t *p, uint32_t bytelength)
 {
-    uint32_t crc = 0xffffffff;
     while (bytelength-- !=0) crc = poly8_lookup[((uint8_t) crc ^ *(p++))] ^ (crc >> 8);
+    return crc;
+}
+
+static uint32_t crc32_byte(uint8_t *p, uint32_t bytelength)
+{
+    uint32_t crc = crc32_update(0xffffffff, p, bytelength);
     // return (~crc); also works
     return (crc ^ 0xffffffff);
 }
@@ -119,3 +124,16 @@ void validator_send_frame(uint8_t link, uint8_t* data, uint16_t size) {
     memcpy(data + size, &crc, 4);
     byte_stuffer_send_frame(link, data, size + 4);
 }
+
+void validator_send_frame_parts(uint8_t link, frame_part_t* parts, uint8_t num_parts) {
+    uint32_t crc = 0xffffffff;
+    uint8_t i;
+    for (i=0;i<num_parts;i++) {
+        crc = crc32_update(crc, parts[i].data, parts[i].size);
+    }
+    crc ^= 0xffffffff;
+    frame_part_t* last = &parts[num_parts - 1];
+    memcpy(last->data + last->size, &crc, 4);
+    last->size += 4;
+    byte_stuffer_send_frame_parts(link, parts, num_parts);
+}
@@ -27,8 +27,12 @@ SOFTWARE.
 
 #include <stdint.h>
 
+#include "serial_link/protocol/byte_stuffer.h"
+
 void validator_recv_frame(uint8_t link, uint8_t* data, uint16_t size);
 // The buffer pointed to by the data needs 4 additional bytes
 void validator_send_frame(uint8_t link, uint8_t* data, uint16_t size);
+// The last part needs 4 additional bytes
+void validator_send_frame_parts(uint8_t link, frame_part_t* parts, uint8_t num_parts);
 
 #endif
@@ -31,6 +31,39 @@ SOFTWARE.
 static remote_object_t* remote_objects[MAX_REMOTE_OBJECTS];
 static uint32_t num_remote_objects = 0;
 
+// Set in the id of a frame with only some blocks of the object. The blocks
+// are followed by their mask, in as many bytes as the object needs.
+#define PARTIAL_FRAME 0x80
+// The runs of written blocks, and the mask and id
+#define MAX_FRAME_PARTS (32 / 2 + 1)
+// The router adds 1 byte, the validator 4
+#define TRAILER_SIZE (4 + 1 + 5)
+
+static uint8_t* object_buffer(remote_object_t* obj, uint8_t buffer) {
+    return REMOTE_OBJECT_BUFFER(obj) + buffer * OBJECT_BUFFER_SIZE(obj->object_size);
+}
+
+static triple_buffer_dirty_t* get_dirty(remote_object_t* obj, uint8_t buffer) {
+    return (triple_buffer_dirty_t*)object_buffer(obj, buffer);
+}
+
+static triple_buffer_object_t* get_triple_buffer(remote_object_t* obj, uint8_t buffer) {
+    return (triple_buffer_object_t*)(object_buffer(obj, buffer) + sizeof(triple_buffer_dirty_t));
+}
+
+static uint8_t num_buffers(remote_object_t* obj) {
+    return obj->object_type == MASTER_TO_ALL_SLAVES ? 2 : NUM_SLAVES + 1;
+}
+
+static uint32_t all_blocks(uint16_t object_size) {
+    uint8_t num_blocks = TRIPLE_BUFFER_NUM_BLOCKS(object_size);
+    return num_blocks == 32 ? TRIPLE_BUFFER_ALL_BLOCKS : ((uint32_t)1 << num_blocks) - 1;
+}
+
+static uint8_t mask_size(uint16_t object_size) {
+    return (TRIPLE_BUFFER_NUM_BLOCKS(object_size) + 7) / 8;
+}
+
 void reinitialize_serial_link_transport(void) {
     num_remote_objects = 0;
 }
@@ -40,61 +73,145 @@ void add_remote_objects(remote_object_t** _remote_objects, uint32_t _num_remote_
     for(i=0;i<_num_remote_objects;i++) {
         remote_object_t* obj = _remote_objects[i];
         remote_objects[num_remote_objects++] = obj;
-        if (obj->object_type == MASTER_TO_ALL_SLAVES) {
-            triple_buffer_object_t* tb = (triple_buffer_object_t*)obj->buffer;
-            triple_buffer_init(tb);
-            uint8_t* start = obj->buffer + LOCAL_OBJECT_SIZE(obj->object_size);
-            tb = (triple_buffer_object_t*)start;
-            triple_buffer_init(tb);
+        uint8_t j;
+        for (j=0;j<num_buffers(obj);j++) {
+            triple_buffer_dirty_init(get_dirty(obj, j));
+            triple_buffer_init(get_triple_buffer(obj, j));
         }
-        else if(obj->object_type == MASTER_TO_SINGLE_SLAVE) {
-            uint8_t* start = obj->buffer;
-            unsigned int j;
-            for (j=0;j<NUM_SLAVES;j++) {
-                triple_buffer_object_t* tb = (triple_buffer_object_t*)start;
-                triple_buffer_init(tb);
-                start += LOCAL_OBJECT_SIZE(obj->object_size);
-            }
-            triple_buffer_object_t* tb = (triple_buffer_object_t*)start;
-            triple_buffer_init(tb);
+    }
+}
+
+void* remote_object_begin_write(remote_object_t* obj, uint8_t buffer) {
+    return triple_buffer_begin_update_internal(obj->object_size, get_triple_buffer(obj, buffer), get_dirty(obj, buffer));
+}
+
+void remote_object_end_write(remote_object_t* obj, uint8_t buffer, uint32_t blocks) {
+    triple_buffer_end_update_internal(get_triple_buffer(obj, buffer), get_dirty(obj, buffer), blocks);
+    signal_data_written();
+}
+
+void* remote_object_read(remote_object_t* obj, uint8_t buffer) {
+    return triple_buffer_read_internal(obj->object_size, get_triple_buffer(obj, buffer));
+}
+
+static void recv_partial(remote_object_t* obj, uint8_t buffer, uint8_t* data, uint16_t size) {
+    uint16_t object_size = obj->object_size;
+    uint8_t num_mask_bytes = mask_size(object_size);
+    if (size < num_mask_bytes) {
+        return;
+    }
+    size -= num_mask_bytes;
+    uint32_t blocks = 0;
+    uint8_t i;
+    for (i=0;i<num_mask_bytes;i++) {
+        blocks |= (uint32_t)data[size + i] << (i * 8);
+    }
+    if (blocks == 0 || (blocks & ~all_blocks(object_size))) {
+        return;
+    }
+
+    // Check the size before touching the object
+    uint16_t block_size = TRIPLE_BUFFER_BLOCK_SIZE(object_size);
+    uint16_t expected = 0;
+    uint16_t offset;
+    uint32_t b;
+    for (offset=0,b=blocks;b;offset+=block_size,b>>=1) {
+        if (b & 1) {
+            expected += object_size - offset < block_size ? object_size - offset : block_size;
         }
-        else {
-            uint8_t* start = obj->buffer;
-            triple_buffer_object_t* tb = (triple_buffer_object_t*)start;
-            triple_buffer_init(tb);
-            start += LOCAL_OBJECT_SIZE(obj->object_size);
-            unsigned int j;
-            for (j=0;j<NUM_SLAVES;j++) {
-                tb = (triple_buffer_object_t*)start;
-                triple_buffer_init(tb);
-                start += REMOTE_OBJECT_SIZE(obj->object_size);
-            }
+    }
+    if (expected != size) {
+        return;
+    }
+
+    triple_buffer_object_t* tb = get_triple_buffer(obj, buffer);
+    triple_buffer_dirty_t* dirty = get_dirty(obj, buffer);
+    uint8_t* ptr = triple_buffer_begin_update_internal(object_size, tb, dirty);
+    for (offset=0,b=blocks;b;offset+=block_size,b>>=1) {
+        if (b & 1) {
+            uint16_t len = object_size - offset < block_size ? object_size - offset : block_size;
+            memcpy(ptr + offset, data, len);
+            data += len;
         }
     }
+    triple_buffer_end_update_internal(tb, dirty, blocks);
 }
 
 void transport_recv_frame(uint8_t from, uint8_t* data, uint16_t size) {
-    uint8_t id = data[size-1];
+    uint8_t id = data[size-1] & ~PARTIAL_FRAME;
     if (id < num_remote_objects) {
         remote_object_t* obj = remote_objects[id];
-        if (obj->object_size == size - 1) {
-            uint8_t* start;
-            if (obj->object_type == MASTER_TO_ALL_SLAVES) {
-                start = obj->buffer + LOCAL_OBJECT_SIZE(obj->object_size);
+        uint8_t buffer;
+        if (obj->object_type == MASTER_TO_ALL_SLAVES) {
+            buffer = 1;
+        }
+        else if(obj->object_type == SLAVE_TO_MASTER) {
+            if (from < 1 || from > NUM_SLAVES) {
+                return;
             }
-            else if(obj->object_type == SLAVE_TO_MASTER) {
-                start = obj->buffer + LOCAL_OBJECT_SIZE(obj->object_size);
-                start += (from - 1) * REMOTE_OBJECT_SIZE(obj->object_size);
+            buffer = from;
+        }
+        else {
+            buffer = NUM_SLAVES;
+        }
+        if (data[size-1] & PARTIAL_FRAME) {
+            recv_partial(obj, buffer, data, size - 1);
+        }
+        else if (obj->object_size == size - 1) {
+            triple_buffer_object_t* tb = get_triple_buffer(obj, buffer);
+            void* ptr = triple_buffer_begin_write_internal(obj->object_size, tb);
+            memcpy(ptr, data, size - 1);
+            triple_buffer_end_update_internal(tb, get_dirty(obj, buffer), TRIPLE_BUFFER_ALL_BLOCKS);
+        }
+    }
+}
+
+// Sends the blocks written since the last time, straight from the buffer
+static void send_object(uint8_t id, remote_object_t* obj, uint8_t buffer, uint8_t destination) {
+    uint16_t object_size = obj->object_size;
+    uint32_t blocks;
+    uint8_t* ptr = (uint8_t*)triple_buffer_read_dirty_internal(object_size,
+            get_triple_buffer(obj, buffer), get_dirty(obj, buffer), &blocks);
+    blocks &= all_blocks(object_size);
+    if (!ptr || !blocks) {
+        return;
+    }
+
+    frame_part_t parts[MAX_FRAME_PARTS];
+    uint8_t trailer[TRAILER_SIZE];
+    uint8_t num_parts = 0;
+    uint8_t trailer_size = 0;
+    if (blocks == all_blocks(object_size)) {
+        parts[num_parts++] = (frame_part_t){ptr, object_size};
+        trailer[trailer_size++] = id;
+    }
+    else {
+        uint16_t block_size = TRIPLE_BUFFER_BLOCK_SIZE(object_size);
+        uint16_t offset = 0;
+        uint32_t b = blocks;
+        while (b) {
+            if (b & 1) {
+                uint16_t start = offset;
+                while (b & 1) {
+                    offset += block_size;
+                    b >>= 1;
+                }
+                uint16_t end = offset < object_size ? offset : object_size;
+                parts[num_parts++] = (frame_part_t){ptr + start, end - start};
             }
             else {
-                start = obj->buffer + NUM_SLAVES * LOCAL_OBJECT_SIZE(obj->object_size);
+                offset += block_size;
+                b >>= 1;
             }
-            triple_buffer_object_t* tb = (triple_buffer_object_t*)start;
-            void* ptr = triple_buffer_begin_write_internal(obj->object_size, tb);
-            memcpy(ptr, data, size - 1);
-            triple_buffer_end_write_internal(tb);
         }
+        uint8_t i;
+        for (i=0;i<mask_size(object_size);i++) {
+            trailer[trailer_size++] = blocks >> (i * 8);
+        }
+        trailer[trailer_size++] = id | PARTIAL_FRAME;
     }
+    parts[num_parts++] = (frame_part_t){trailer, trailer_size};
+    router_send_frame_parts(destination, parts, num_parts);
 }
 
 void update_transport(void) {
@@ -102,26 +219,13 @@ void update_transport(void) {
     for(i=0;i<num_remote_objects;i++) {
         remote_object_t* obj = remote_objects[i];
         if (obj->object_type == MASTER_TO_ALL_SLAVES || obj->object_type == SLAVE_TO_MASTER) {
-            triple_buffer_object_t* tb = (triple_buffer_object_t*)obj->buffer;
-            uint8_t* ptr = (uint8_t*)triple_buffer_read_internal(obj->object_size + LOCAL_OBJECT_EXTRA, tb);
-            if (ptr) {
-                ptr[obj->object_size] = i;
-                uint8_t dest = obj->object_type == MASTER_TO_ALL_SLAVES ? 0xFF : 0;
-                router_send_frame(dest, ptr, obj->object_size + 1);
-            }
+            uint8_t dest = obj->object_type == MASTER_TO_ALL_SLAVES ? 0xFF : 0;
+            send_object(i, obj, 0, dest);
         }
         else {
-            uint8_t* start = obj->buffer;
             unsigned int j;
             for (j=0;j<NUM_SLAVES;j++) {
-                triple_buffer_object_t* tb = (triple_buffer_object_t*)start;
-                uint8_t* ptr = (uint8_t*)triple_buffer_read_internal(obj->object_size + LOCAL_OBJECT_EXTRA, tb);
-                if (ptr) {
-                    ptr[obj->object_size] = i;
-                    uint8_t dest = j + 1;
-                    router_send_frame(dest, ptr, obj->object_size + 1);
-                }
-                start += LOCAL_OBJECT_SIZE(obj->object_size);
+                send_object(i, obj, j, j + 1);
             }
         }
     }
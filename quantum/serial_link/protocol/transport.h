@@ -27,9 +27,9 @@ SOFTWARE.
 
 #include "serial_link/protocol/triple_buffered_object.h"
 #include "serial_link/system/serial_link.h"
+#include <stddef.h>
 
 #define NUM_SLAVES 8
-#define LOCAL_OBJECT_EXTRA 16
 
 // master -> slave = 1 local(target all), 1 remote object
 // slave -> master = 1 local(target 0), multiple remote objects
@@ -40,25 +40,32 @@ typedef enum {
     SLAVE_TO_MASTER,
 } remote_object_type;
 
+// The buffers of the object follow it, see REMOTE_OBJECT_HELPER
 typedef struct {
     remote_object_type object_type;
     uint16_t object_size;
-    uint8_t buffer[] __attribute__((aligned(4)));
-} remote_object_t;
+} __attribute__((aligned(4))) remote_object_t;
 
-#define REMOTE_OBJECT_SIZE(objectsize) \
-    (sizeof(triple_buffer_object_t) + objectsize * 3)
-#define LOCAL_OBJECT_SIZE(objectsize) \
-    (sizeof(triple_buffer_object_t) + (objectsize + LOCAL_OBJECT_EXTRA) * 3)
+#define REMOTE_OBJECT_BUFFER(obj) ((uint8_t*)(obj) + sizeof(remote_object_t))
+
+// Each local and remote copy is a triple buffer, which keeps track of the
+// blocks written
+#define OBJECT_BUFFER_SIZE(objectsize) \
+    ((sizeof(triple_buffer_dirty_t) + sizeof(triple_buffer_object_t) + (objectsize) * 3 + 3) & ~3)
 
 #define REMOTE_OBJECT_HELPER(name, type, num_local, num_remote) \
 typedef struct { \
     remote_object_t object; \
-    uint8_t buffer[ \
-        num_remote * REMOTE_OBJECT_SIZE(sizeof(type)) + \
-        num_local * LOCAL_OBJECT_SIZE(sizeof(type))]; \
+    uint8_t buffer[(num_local + num_remote) * OBJECT_BUFFER_SIZE(sizeof(type))] __attribute__((aligned(4))); \
 } remote_object_##name##_t;
 
+// Writes to local objects can change only some fields of the object, the
+// blocks they cover are passed to end_write_partial_<name>. Only those are
+// sent, straight from the triple buffer.
+#define REMOTE_OBJECT_RANGE(type, offset, size) TRIPLE_BUFFER_BLOCKS(sizeof(type), offset, size)
+#define REMOTE_OBJECT_FIELD(type, field) \
+    REMOTE_OBJECT_RANGE(type, offsetof(type, field), sizeof(((type*)0)->field))
+
 #define MASTER_TO_ALL_SLAVES_OBJECT(name, type) \
     REMOTE_OBJECT_HELPER(name, type, 1, 1) \
     remote_object_##name##_t remote_object_##name = { \
@@ -68,21 +75,16 @@ typedef struct { \
         } \
     }; \
     type* begin_write_##name(void) { \
-        remote_object_t* obj = (remote_object_t*)&remote_object_##name; \
-        triple_buffer_object_t* tb = (triple_buffer_object_t*)obj->buffer; \
-        return (type*)triple_buffer_begin_write_internal(sizeof(type) + LOCAL_OBJECT_EXTRA, tb); \
+        return (type*)remote_object_begin_write(REMOTE_OBJECT(name), 0); \
+    }\
+    void end_write_partial_##name(uint32_t blocks) { \
+        remote_object_end_write(REMOTE_OBJECT(name), 0, blocks); \
     }\
     void end_write_##name(void) { \
-        remote_object_t* obj = (remote_object_t*)&remote_object_##name; \
-        triple_buffer_object_t* tb = (triple_buffer_object_t*)obj->buffer; \
-        triple_buffer_end_write_internal(tb); \
-        signal_data_written(); \
+        end_write_partial_##name(TRIPLE_BUFFER_ALL_BLOCKS); \
     }\
     type* read_##name(void) { \
-        remote_object_t* obj = (remote_object_t*)&remote_object_##name; \
-        uint8_t* start = obj->buffer + LOCAL_OBJECT_SIZE(obj->object_size);\
-        triple_buffer_object_t* tb = (triple_buffer_object_t*)start; \
-        return (type*)triple_buffer_read_internal(obj->object_size, tb); \
+        return (type*)remote_object_read(REMOTE_OBJECT(name), 1); \
     }
 
 #define MASTER_TO_SINGLE_SLAVE_OBJECT(name, type) \
@@ -94,25 +96,16 @@ typedef struct { \
         } \
     }; \
     type* begin_write_##name(uint8_t slave) { \
-        remote_object_t* obj = (remote_object_t*)&remote_object_##name; \
-        uint8_t* start = obj->buffer;\
-        start += slave * LOCAL_OBJECT_SIZE(obj->object_size); \
-        triple_buffer_object_t* tb = (triple_buffer_object_t*)start; \
-        return (type*)triple_buffer_begin_write_internal(sizeof(type) + LOCAL_OBJECT_EXTRA, tb); \
+        return (type*)remote_object_begin_write(REMOTE_OBJECT(name), slave); \
+    }\
+    void end_write_partial_##name(uint8_t slave, uint32_t blocks) { \
+        remote_object_end_write(REMOTE_OBJECT(name), slave, blocks); \
     }\
     void end_write_##name(uint8_t slave) { \
-        remote_object_t* obj = (remote_object_t*)&remote_object_##name; \
-        uint8_t* start = obj->buffer;\
-        start += slave * LOCAL_OBJECT_SIZE(obj->object_size); \
-        triple_buffer_object_t* tb = (triple_buffer_object_t*)start; \
-        triple_buffer_end_write_internal(tb); \
-        signal_data_written(); \
+        end_write_partial_##name(slave, TRIPLE_BUFFER_ALL_BLOCKS); \
     }\
     type* read_##name() { \
-        remote_object_t* obj = (remote_object_t*)&remote_object_##name; \
-        uint8_t* start = obj->buffer + NUM_SLAVES * LOCAL_OBJECT_SIZE(obj->object_size);\
-        triple_buffer_object_t* tb = (triple_buffer_object_t*)start; \
-        return (type*)triple_buffer_read_internal(obj->object_size, tb); \
+        return (type*)remote_object_read(REMOTE_OBJECT(name), NUM_SLAVES); \
     }
 
 #define SLAVE_TO_MASTER_OBJECT(name, type) \
@@ -124,26 +117,25 @@ typedef struct { \
         } \
     }; \
     type* begin_write_##name(void) { \
-        remote_object_t* obj = (remote_object_t*)&remote_object_##name; \
-        triple_buffer_object_t* tb = (triple_buffer_object_t*)obj->buffer; \
-        return (type*)triple_buffer_begin_write_internal(sizeof(type) + LOCAL_OBJECT_EXTRA, tb); \
+        return (type*)remote_object_begin_write(REMOTE_OBJECT(name), 0); \
+    }\
+    void end_write_partial_##name(uint32_t blocks) { \
+        remote_object_end_write(REMOTE_OBJECT(name), 0, blocks); \
     }\
     void end_write_##name(void) { \
-        remote_object_t* obj = (remote_object_t*)&remote_object_##name; \
-        triple_buffer_object_t* tb = (triple_buffer_object_t*)obj->buffer; \
-        triple_buffer_end_write_internal(tb); \
-        signal_data_written(); \
+        end_write_partial_##name(TRIPLE_BUFFER_ALL_BLOCKS); \
     }\
     type* read_##name(uint8_t slave) { \
-        remote_object_t* obj = (remote_object_t*)&remote_object_##name; \
-        uint8_t* start = obj->buffer + LOCAL_OBJECT_SIZE(obj->object_size);\
-        start+=slave * REMOTE_OBJECT_SIZE(obj->object_size); \
-        triple_buffer_object_t* tb = (triple_buffer_object_t*)start; \
-        return (type*)triple_buffer_read_internal(obj->object_size, tb); \
+        return (type*)remote_object_read(REMOTE_OBJECT(name), 1 + slave); \
     }
 
 #define REMOTE_OBJECT(name) (remote_object_t*)&remote_object_##name
 
+// Used by the macros above, buffer is the index of the local or remote copy
+void* remote_object_begin_write(remote_object_t* obj, uint8_t buffer);
+void remote_object_end_write(remote_object_t* obj, uint8_t buffer, uint32_t blocks);
+void* remote_object_read(remote_object_t* obj, uint8_t buffer);
+
 void add_remote_objects(remote_object_t** remote_objects, uint32_t num_remote_objects);
 void reinitialize_serial_link_transport(void);
 void transport_recv_frame(uint8_t from, uint8_t* data, uint16_t size);
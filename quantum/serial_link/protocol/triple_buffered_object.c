@@ -26,6 +26,7 @@ SOFTWARE.
 #include "serial_link/system/serial_link.h"
 #include <stdbool.h>
 #include <stddef.h>
+#include <string.h>
 
 #define GET_READ_INDEX() object->state & 3
 #define GET_WRITE_INDEX() (object->state >> 2) & 3
@@ -45,23 +46,28 @@ void triple_buffer_init(triple_buffer_object_t* object) {
     SET_DATA_AVAILABLE(0);
 }
 
-void* triple_buffer_read_internal(uint16_t object_size, triple_buffer_object_t* object) {
-    serial_link_lock();
+// Call with the lock held
+static void* swap_read_buffer(uint16_t object_size, triple_buffer_object_t* object) {
     if (GET_DATA_AVAILABLE()) {
         uint8_t shared_index = GET_SHARED_INDEX();
         uint8_t read_index = GET_READ_INDEX();
         SET_READ_INDEX(shared_index);
         SET_SHARED_INDEX(read_index);
         SET_DATA_AVAILABLE(false);
-        serial_link_unlock();
         return object->buffer + object_size * shared_index;
     }
     else {
-        serial_link_unlock();
         return NULL;
     }
 }
 
+void* triple_buffer_read_internal(uint16_t object_size, triple_buffer_object_t* object) {
+    serial_link_lock();
+    void* ret = swap_read_buffer(object_size, object);
+    serial_link_unlock();
+    return ret;
+}
+
 void* triple_buffer_begin_write_internal(uint16_t object_size, triple_buffer_object_t* object) {
     uint8_t write_index = GET_WRITE_INDEX();
     return object->buffer + object_size * write_index;
@@ -76,3 +82,63 @@ void triple_buffer_end_write_internal(triple_buffer_object_t* object) {
     SET_DATA_AVAILABLE(true);
     serial_link_unlock();
 }
+
+void triple_buffer_dirty_init(triple_buffer_dirty_t* dirty) {
+    dirty->stale[0] = 0;
+    dirty->stale[1] = 0;
+    dirty->stale[2] = 0;
+    dirty->written = 0;
+    dirty->latest = 2;
+}
+
+void* triple_buffer_begin_update_internal(uint16_t object_size, triple_buffer_object_t* object,
+        triple_buffer_dirty_t* dirty) {
+    uint8_t write_index = GET_WRITE_INDEX();
+    uint8_t* buffer = object->buffer + object_size * write_index;
+    uint32_t stale = dirty->stale[write_index];
+    if (stale) {
+        // Only the writer changes the buffers, and the latest one can't be
+        // the write buffer, so it can be read without locking
+        const uint8_t* latest = object->buffer + object_size * dirty->latest;
+        uint16_t block_size = TRIPLE_BUFFER_BLOCK_SIZE(object_size);
+        uint16_t offset;
+        for (offset=0;stale && offset<object_size;offset+=block_size,stale>>=1) {
+            if (stale & 1) {
+                uint16_t size = object_size - offset < block_size ? object_size - offset : block_size;
+                memcpy(buffer + offset, latest + offset, size);
+            }
+        }
+        dirty->stale[write_index] = 0;
+    }
+    return buffer;
+}
+
+void triple_buffer_end_update_internal(triple_buffer_object_t* object, triple_buffer_dirty_t* dirty,
+        uint32_t blocks) {
+    uint8_t write_index = GET_WRITE_INDEX();
+    uint8_t i;
+    for (i=0;i<3;i++) {
+        if (i != write_index) {
+            dirty->stale[i] |= blocks;
+        }
+    }
+    dirty->stale[write_index] = 0;
+    dirty->latest = write_index;
+    serial_link_lock();
+    dirty->written |= blocks;
+    uint8_t shared_index = GET_SHARED_INDEX();
+    SET_SHARED_INDEX(write_index);
+    SET_WRITE_INDEX(shared_index);
+    SET_DATA_AVAILABLE(true);
+    serial_link_unlock();
+}
+
+void* triple_buffer_read_dirty_internal(uint16_t object_size, triple_buffer_object_t* object,
+        triple_buffer_dirty_t* dirty, uint32_t* blocks) {
+    serial_link_lock();
+    void* ret = swap_read_buffer(object_size, object);
+    *blocks = ret ? dirty->written : 0;
+    dirty->written = 0;
+    serial_link_unlock();
+    return ret;
+}
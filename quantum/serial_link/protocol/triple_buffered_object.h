@@ -47,5 +47,39 @@ void* triple_buffer_begin_write_internal(uint16_t object_size, triple_buffer_obj
 void triple_buffer_end_write_internal(triple_buffer_object_t* object);
 void* triple_buffer_read_internal(uint16_t object_size, triple_buffer_object_t* object);
 
+// Objects can also be written in parts. The object is divided into at most
+// 32 blocks, and a mask tells which blocks were written.
+#define TRIPLE_BUFFER_BLOCK_SIZE(object_size) (((object_size) + 31) / 32)
+#define TRIPLE_BUFFER_NUM_BLOCKS(object_size) \
+    (((object_size) + TRIPLE_BUFFER_BLOCK_SIZE(object_size) - 1) / TRIPLE_BUFFER_BLOCK_SIZE(object_size))
+// The blocks covering size bytes from offset
+#define TRIPLE_BUFFER_BLOCKS(object_size, offset, size) \
+    ((((uint32_t)2 << (((offset) + (size) - 1) / TRIPLE_BUFFER_BLOCK_SIZE(object_size))) - 1) & \
+     ~(((uint32_t)1 << ((offset) / TRIPLE_BUFFER_BLOCK_SIZE(object_size))) - 1))
+#define TRIPLE_BUFFER_ALL_BLOCKS 0xFFFFFFFF
+
+typedef struct {
+    // The blocks each buffer misses, they were written to another one
+    uint32_t stale[3];
+    // The blocks written since the last read
+    uint32_t written;
+    // The buffer written last
+    uint8_t latest;
+} triple_buffer_dirty_t;
+
+void triple_buffer_dirty_init(triple_buffer_dirty_t* dirty);
+// Returns the buffer to write like triple_buffer_begin_write_internal,
+// but with the latest data in it, so only some blocks can be written
+void* triple_buffer_begin_update_internal(uint16_t object_size, triple_buffer_object_t* object,
+        triple_buffer_dirty_t* dirty);
+// Ends a write of the blocks in the mask, either started with
+// triple_buffer_begin_update_internal or a write of the whole object
+void triple_buffer_end_update_internal(triple_buffer_object_t* object, triple_buffer_dirty_t* dirty,
+        uint32_t blocks);
+// Like triple_buffer_read_internal, also returns the blocks written since
+// the last read
+void* triple_buffer_read_dirty_internal(uint16_t object_size, triple_buffer_object_t* object,
+        triple_buffer_dirty_t* dirty, uint32_t* blocks);
+
 
 #endif
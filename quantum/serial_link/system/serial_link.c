@@ -174,8 +174,6 @@ typedef struct {
     matrix_row_t rows[MATRIX_ROWS];
 } matrix_object_t;
 
-static matrix_object_t last_matrix = {};
-
 SLAVE_TO_MASTER_OBJECT(keyboard_matrix, matrix_object_t);
 MASTER_TO_ALL_SLAVES_OBJECT(serial_link_connected, bool);
 
@@ -203,23 +201,23 @@ void serial_link_update(void) {
         serial_link_connected = true;
     }
 
-    matrix_object_t matrix;
-    bool changed = false;
+    systime_t current_time = chVTGetSystemTimeX();
+    systime_t delta = current_time - last_update;
+    // Send the whole matrix now and then, in case a frame got lost
+    uint32_t changed = delta > US2ST(5000) ? TRIPLE_BUFFER_ALL_BLOCKS : 0;
+    // The buffer has the last matrix written, only the changed rows are sent
+    matrix_object_t* m = begin_write_keyboard_matrix();
     for(uint8_t i=0;i<MATRIX_ROWS;i++) {
-        matrix.rows[i] = matrix_get_row(i);
-        changed |= matrix.rows[i] != last_matrix.rows[i];
+        matrix_row_t row = matrix_get_row(i);
+        if (row != m->rows[i]) {
+            m->rows[i] = row;
+            changed |= REMOTE_OBJECT_RANGE(matrix_object_t, i * sizeof(matrix_row_t), sizeof(matrix_row_t));
+        }
     }
 
-    systime_t current_time = chVTGetSystemTimeX();
-    systime_t delta = current_time - last_update;
-    if (changed || delta > US2ST(5000)) {
+    if (changed) {
         last_update = current_time;
-        last_matrix = matrix;
-        matrix_object_t* m = begin_write_keyboard_matrix();
-        for(uint8_t i=0;i<MATRIX_ROWS;i++) {
-            m->rows[i] = matrix.rows[i];
-        }
-        end_write_keyboard_matrix();
+        end_write_partial_keyboard_matrix(changed);
         *begin_write_serial_link_connected() = true;
         end_write_serial_link_connected();
     }
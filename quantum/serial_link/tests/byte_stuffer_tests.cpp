@@ -415,6 +415,30 @@ TEST_F(ByteStuffer, sends_frame_with_254_non_zeroes_followed_by_zero) {
     EXPECT_THAT(sent_data, ElementsAreArray(expected));
 }
 
+TEST_F(ByteStuffer, sends_frame_in_parts) {
+    uint8_t first[] = {9};
+    uint8_t second[] = {0, 0x68};
+    uint8_t third[] = {0, 0x55};
+    frame_part_t parts[] = {{first, 1}, {second, 2}, {NULL, 0}, {third, 2}};
+    byte_stuffer_send_frame_parts(0, parts, 4);
+    uint8_t expected[] = {2, 9, 2, 0x68, 2, 0x55, 0};
+    EXPECT_THAT(sent_data, ElementsAreArray(expected));
+}
+
+TEST_F(ByteStuffer, sends_long_block_over_parts_like_one_buffer) {
+    uint8_t data[300];
+    int i;
+    for(i=0;i<300;i++) {
+        data[i] = i % 255 + 1;
+    }
+    byte_stuffer_send_frame(0, data, 300);
+    std::vector<uint8_t> expected = sent_data;
+    sent_data.clear();
+    frame_part_t parts[] = {{data, 100}, {data + 100, 200}};
+    byte_stuffer_send_frame_parts(0, parts, 2);
+    EXPECT_THAT(sent_data, ElementsAreArray(expected));
+}
+
 TEST_F(ByteStuffer, sends_and_receives_full_roundtrip_small_packet) {
     uint8_t original_data[] = { 1, 2, 3};
     byte_stuffer_send_frame(0, original_data, sizeof(original_data));
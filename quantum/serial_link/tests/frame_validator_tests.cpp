@@ -45,6 +45,14 @@ public:
     MOCK_METHOD3(route_incoming_frame, void (uint8_t link, uint8_t* data, uint16_t size));
     MOCK_METHOD3(byte_stuffer_send_frame, void (uint8_t link, uint8_t* data, uint16_t size));
 
+    void byte_stuffer_send_frame_parts(uint8_t link, frame_part_t* parts, uint8_t num_parts) {
+        for (uint8_t i = 0; i < num_parts; i++) {
+            std::copy(parts[i].data, parts[i].data + parts[i].size, std::back_inserter(sent_data));
+        }
+    }
+
+    std::vector<uint8_t> sent_data;
+
     static FrameValidator* Instance;
 };
 
@@ -58,6 +66,10 @@ void route_incoming_frame(uint8_t link, uint8_t* data, uint16_t size) {
 void byte_stuffer_send_frame(uint8_t link, uint8_t* data, uint16_t size) {
     FrameValidator::Instance->byte_stuffer_send_frame(link, data, size);
 }
+
+void byte_stuffer_send_frame_parts(uint8_t link, frame_part_t* parts, uint8_t num_parts) {
+    FrameValidator::Instance->byte_stuffer_send_frame_parts(link, parts, num_parts);
+}
 }
 
 TEST_F(FrameValidator, doesnt_validate_frames_under_5_bytes) {
@@ -113,3 +125,14 @@ TEST_F(FrameValidator, sends_five_bytes_with_correct_crc) {
         .With(Args<1, 2>(ElementsAreArray(expected)));
     validator_send_frame(0, original, 5);
 }
+
+TEST_F(FrameValidator, sends_five_bytes_in_parts_with_correct_crc) {
+    uint8_t first[] = {1, 2};
+    uint8_t second[] = {3};
+    uint8_t last[] = {4, 5, 0, 0, 0, 0};
+    frame_part_t parts[] = {{first, 2}, {second, 1}, {last, 2}};
+    uint8_t expected[] = {1, 2, 3, 4, 5, 0xF4, 0x99, 0x0B, 0x47};
+    validator_send_frame_parts(0, parts, 3);
+    EXPECT_THAT(sent_data, ElementsAreArray(expected));
+    EXPECT_EQ(parts[2].size, 6);
+}
@@ -0,0 +1,145 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 QMK Firmware contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+#include <vector>
+extern "C" {
+#include "serial_link/protocol/transport.h"
+#include "serial_link/protocol/frame_router.h"
+#include "serial_link/protocol/byte_stuffer.h"
+#include "serial_link/protocol/physical.h"
+}
+
+using testing::ElementsAreArray;
+
+// The whole protocol stack, a slave sending a matrix to the master
+struct test_matrix {
+    uint8_t rows[14];
+};
+
+SLAVE_TO_MASTER_OBJECT(matrix, test_matrix);
+
+static remote_object_t* test_remote_objects[] = {
+    REMOTE_OBJECT(matrix),
+};
+
+class RemoteObject : public testing::Test {
+public:
+    RemoteObject() {
+        Instance = this;
+        add_remote_objects(test_remote_objects, sizeof(test_remote_objects) / sizeof(remote_object_t*));
+        init_byte_stuffer();
+    }
+
+    ~RemoteObject() {
+        Instance = nullptr;
+        reinitialize_serial_link_transport();
+    }
+
+    // Sends what the slave wrote and receives it on the master, returns the
+    // bytes on the wire
+    size_t transfer() {
+        wire.clear();
+        router_set_master(false);
+        update_transport();
+        router_set_master(true);
+        for (uint8_t data : wire) {
+            byte_stuffer_recv_byte(DOWN_LINK, data);
+        }
+        return wire.size();
+    }
+
+    void write_row(uint8_t row, uint8_t value) {
+        begin_write_matrix()->rows[row] = value;
+        end_write_partial_matrix(REMOTE_OBJECT_RANGE(test_matrix, row, 1));
+    }
+
+    std::vector<uint8_t> wire;
+
+    static RemoteObject* Instance;
+};
+
+RemoteObject* RemoteObject::Instance = nullptr;
+
+extern "C" {
+void send_data(uint8_t link, const uint8_t* data, uint16_t size) {
+    if (link == UP_LINK) {
+        std::copy(data, data + size, std::back_inserter(RemoteObject::Instance->wire));
+    }
+}
+
+void signal_data_written(void) {
+}
+}
+
+TEST_F(RemoteObject, sends_one_changed_row_in_half_the_bytes) {
+    test_matrix* m = begin_write_matrix();
+    for (int i = 0; i < 14; i++) {
+        m->rows[i] = i + 1;
+    }
+    end_write_matrix();
+    // 14 rows, id, destination, CRC and 2 bytes of byte stuffing
+    EXPECT_EQ(transfer(), 22);
+
+    write_row(5, 0x80);
+    // 1 row, 2 bytes of mask, id, destination, CRC and byte stuffing
+    EXPECT_EQ(transfer(), 11);
+
+    test_matrix* received = read_matrix(0);
+    ASSERT_NE(received, nullptr);
+    uint8_t expected[] = {1, 2, 3, 4, 5, 0x80, 7, 8, 9, 10, 11, 12, 13, 14};
+    EXPECT_THAT(received->rows, ElementsAreArray(expected));
+}
+
+TEST_F(RemoteObject, sends_nothing_without_writes) {
+    EXPECT_EQ(transfer(), 0);
+    write_row(0, 1);
+    EXPECT_NE(transfer(), 0);
+    EXPECT_EQ(transfer(), 0);
+}
+
+TEST_F(RemoteObject, whole_write_repairs_a_lost_row) {
+    write_row(3, 0x11);
+    transfer();
+    EXPECT_NE(read_matrix(0), nullptr);
+    write_row(3, 0x22);
+    // Damage the frame, the CRC drops it
+    wire.clear();
+    router_set_master(false);
+    update_transport();
+    wire[2] ^= 0x40;
+    router_set_master(true);
+    for (uint8_t data : wire) {
+        byte_stuffer_recv_byte(DOWN_LINK, data);
+    }
+    EXPECT_EQ(read_matrix(0), nullptr);
+
+    begin_write_matrix();
+    end_write_matrix();
+    transfer();
+    test_matrix* received = read_matrix(0);
+    ASSERT_NE(received, nullptr);
+    EXPECT_EQ(received->rows[3], 0x22);
+}
@@ -31,6 +31,7 @@ using testing::Args;
 
 extern "C" {
 #include "serial_link/protocol/transport.h"
+#include "serial_link/protocol/frame_router.h"
 }
 
 struct test_object1 {
@@ -45,11 +46,13 @@ struct test_object2 {
 MASTER_TO_ALL_SLAVES_OBJECT(master_to_slave, test_object1);
 MASTER_TO_SINGLE_SLAVE_OBJECT(master_to_single_slave, test_object1);
 SLAVE_TO_MASTER_OBJECT(slave_to_master, test_object1);
+SLAVE_TO_MASTER_OBJECT(slave_to_master_fields, test_object2);
 
 static remote_object_t* test_remote_objects[] = {
     REMOTE_OBJECT(master_to_slave),
     REMOTE_OBJECT(master_to_single_slave),
     REMOTE_OBJECT(slave_to_master),
+    REMOTE_OBJECT(slave_to_master_fields),
 };
 
 class Transport : public testing::Test {
@@ -67,9 +70,11 @@ public:
     MOCK_METHOD0(signal_data_written, void ());
     MOCK_METHOD1(router_send_frame, void (uint8_t destination));
 
-    void router_send_frame(uint8_t destination, uint8_t* data, uint16_t size) {
+    void router_send_frame_parts(uint8_t destination, frame_part_t* parts, uint8_t num_parts) {
         router_send_frame(destination);
-        std::copy(data, data + size, std::back_inserter(sent_data));
+        for (uint8_t i = 0; i < num_parts; i++) {
+            std::copy(parts[i].data, parts[i].data + parts[i].size, std::back_inserter(sent_data));
+        }
     }
 
     static Transport* Instance;
@@ -84,8 +89,8 @@ void signal_data_written(void) {
     Transport::Instance->signal_data_written();
 }
 
-void router_send_frame(uint8_t destination, uint8_t* data, uint16_t size) {
-    Transport::Instance->router_send_frame(destination, data, size);
+void router_send_frame_parts(uint8_t destination, frame_part_t* parts, uint8_t num_parts) {
+    Transport::Instance->router_send_frame_parts(destination, parts, num_parts);
 }
 }
 
@@ -186,3 +191,81 @@ TEST_F(Transport, ignores_object_with_size_too_big) {
     test_object1* obj2 = read_master_to_slave();
     EXPECT_EQ(obj2, nullptr);
 }
+
+TEST_F(Transport, sends_only_the_written_field) {
+    update_transport();
+    test_object2* obj = begin_write_slave_to_master_fields();
+    obj->test1 = 1;
+    obj->test2 = 2;
+    EXPECT_CALL(*this, signal_data_written()).Times(2);
+    end_write_slave_to_master_fields();
+    EXPECT_CALL(*this, router_send_frame(0)).Times(2);
+    update_transport();
+    // The whole object and the id
+    EXPECT_EQ(sent_data.size(), 9);
+    transport_recv_frame(1, sent_data.data(), sent_data.size());
+    sent_data.clear();
+
+    obj = begin_write_slave_to_master_fields();
+    // The buffer has the latest data
+    EXPECT_EQ(obj->test1, 1);
+    obj->test2 = 0x12345678;
+    end_write_partial_slave_to_master_fields(REMOTE_OBJECT_FIELD(test_object2, test2));
+    update_transport();
+    // The field, the mask of the bytes in it and the id
+    uint8_t expected[] = {0x78, 0x56, 0x34, 0x12, 0xF0, 0x83};
+    EXPECT_THAT(sent_data, ElementsAreArray(expected));
+    transport_recv_frame(1, sent_data.data(), sent_data.size());
+    test_object2* obj2 = read_slave_to_master_fields(0);
+    EXPECT_NE(obj2, nullptr);
+    EXPECT_EQ(obj2->test1, 1);
+    EXPECT_EQ(obj2->test2, 0x12345678);
+}
+
+TEST_F(Transport, sends_fields_written_before_the_update_together) {
+    update_transport();
+    EXPECT_CALL(*this, signal_data_written()).Times(3);
+    begin_write_slave_to_master_fields()->test1 = 0x0101;
+    end_write_partial_slave_to_master_fields(REMOTE_OBJECT_RANGE(test_object2, 0, 2));
+    begin_write_slave_to_master_fields()->test2 = 0x0303;
+    end_write_partial_slave_to_master_fields(REMOTE_OBJECT_RANGE(test_object2, 4, 2));
+    // Just the low byte of test2
+    ((uint8_t*)begin_write_slave_to_master_fields())[4] = 0x04;
+    end_write_partial_slave_to_master_fields(REMOTE_OBJECT_RANGE(test_object2, 4, 1));
+    EXPECT_CALL(*this, router_send_frame(0));
+    update_transport();
+    // Two runs of blocks in one frame, from the latest buffer
+    uint8_t expected[] = {0x01, 0x01, 0x04, 0x03, 0x33, 0x83};
+    EXPECT_THAT(sent_data, ElementsAreArray(expected));
+    transport_recv_frame(2, sent_data.data(), sent_data.size());
+    test_object2* obj2 = read_slave_to_master_fields(1);
+    EXPECT_NE(obj2, nullptr);
+    EXPECT_EQ(obj2->test1, 0x0101);
+    EXPECT_EQ(obj2->test2, 0x0304);
+}
+
+TEST_F(Transport, sends_the_whole_object_when_all_fields_are_written) {
+    update_transport();
+    EXPECT_CALL(*this, signal_data_written()).Times(2);
+    begin_write_slave_to_master_fields()->test1 = 5;
+    end_write_partial_slave_to_master_fields(REMOTE_OBJECT_FIELD(test_object2, test1));
+    begin_write_slave_to_master_fields()->test2 = 6;
+    end_write_partial_slave_to_master_fields(REMOTE_OBJECT_FIELD(test_object2, test2));
+    EXPECT_CALL(*this, router_send_frame(0));
+    update_transport();
+    EXPECT_EQ(sent_data.size(), 9);
+    EXPECT_EQ(sent_data[8], 3);
+}
+
+TEST_F(Transport, ignores_partial_object_with_wrong_size) {
+    update_transport();
+    EXPECT_CALL(*this, signal_data_written());
+    begin_write_slave_to_master_fields()->test2 = 7;
+    end_write_partial_slave_to_master_fields(REMOTE_OBJECT_FIELD(test_object2, test2));
+    EXPECT_CALL(*this, router_send_frame(0));
+    update_transport();
+    // Claim one more byte than sent
+    sent_data[4] |= 0x08;
+    transport_recv_frame(1, sent_data.data(), sent_data.size());
+    EXPECT_EQ(read_slave_to_master_fields(0), nullptr);
+}
@@ -23,6 +23,8 @@ SOFTWARE.
 */
 
 #include "gtest/gtest.h"
+#include "gmock/gmock.h"
+#include <vector>
 extern "C" {
 #include "serial_link/protocol/triple_buffered_object.h"
 }
@@ -82,3 +84,97 @@ TEST_F(TripleBufferedObject, performs_two_writes_in_the_middle_of_read) {
     EXPECT_EQ(*triple_buffer_read(&test_object), 3);
     EXPECT_EQ(triple_buffer_read(&test_object), nullptr);
 }
+
+struct test_dirty_object {
+    uint8_t state;
+    uint8_t buffer[3][8] __attribute__((aligned(4)));
+};
+
+class TripleBufferedObjectUpdate : public testing::Test {
+public:
+    TripleBufferedObjectUpdate() {
+        object = (triple_buffer_object_t*)&buffers;
+        triple_buffer_init(object);
+        triple_buffer_dirty_init(&dirty);
+    }
+
+    uint8_t* begin_update() {
+        return (uint8_t*)triple_buffer_begin_update_internal(8, object, &dirty);
+    }
+
+    void end_update(uint32_t blocks) {
+        triple_buffer_end_update_internal(object, &dirty, blocks);
+    }
+
+    uint8_t* read(uint32_t* blocks) {
+        return (uint8_t*)triple_buffer_read_dirty_internal(8, object, &dirty, blocks);
+    }
+
+    test_dirty_object buffers = {};
+    triple_buffer_object_t* object;
+    triple_buffer_dirty_t dirty;
+};
+
+TEST_F(TripleBufferedObjectUpdate, computes_blocks_of_a_range) {
+    EXPECT_EQ(TRIPLE_BUFFER_BLOCK_SIZE(8), 1);
+    EXPECT_EQ(TRIPLE_BUFFER_BLOCKS(8, 2, 3), 0x1Cu);
+    EXPECT_EQ(TRIPLE_BUFFER_BLOCK_SIZE(100), 4);
+    EXPECT_EQ(TRIPLE_BUFFER_NUM_BLOCKS(100), 25);
+    EXPECT_EQ(TRIPLE_BUFFER_BLOCKS(100, 6, 4), 0x6u);
+    EXPECT_EQ(TRIPLE_BUFFER_BLOCKS(128, 0, 128), 0xFFFFFFFFu);
+}
+
+TEST_F(TripleBufferedObjectUpdate, updates_keep_the_rest_of_the_object) {
+    uint8_t* data = begin_update();
+    for (int i = 0; i < 8; i++) {
+        data[i] = i + 1;
+    }
+    end_update(TRIPLE_BUFFER_ALL_BLOCKS);
+    // Go through all three buffers
+    for (int i = 0; i < 3; i++) {
+        data = begin_update();
+        data[i] = 0x10 + i;
+        end_update(1 << i);
+    }
+    uint32_t blocks;
+    data = read(&blocks);
+    uint8_t expected[] = {0x10, 0x11, 0x12, 4, 5, 6, 7, 8};
+    EXPECT_THAT(std::vector<uint8_t>(data, data + 8), testing::ElementsAreArray(expected));
+}
+
+TEST_F(TripleBufferedObjectUpdate, read_returns_the_blocks_written_since_the_last_read) {
+    uint32_t blocks;
+    begin_update()[1] = 1;
+    end_update(1 << 1);
+    EXPECT_NE(read(&blocks), nullptr);
+    EXPECT_EQ(blocks, 1u << 1);
+
+    begin_update()[2] = 2;
+    end_update(1 << 2);
+    begin_update()[5] = 5;
+    end_update(1 << 5);
+    uint8_t* data = read(&blocks);
+    EXPECT_EQ(blocks, (1u << 2) | (1u << 5));
+    EXPECT_EQ(data[1], 1);
+    EXPECT_EQ(data[2], 2);
+    EXPECT_EQ(data[5], 5);
+
+    EXPECT_EQ(read(&blocks), nullptr);
+    EXPECT_EQ(blocks, 0u);
+}
+
+TEST_F(TripleBufferedObjectUpdate, update_during_a_read_does_not_change_it) {
+    uint32_t blocks;
+    begin_update()[0] = 1;
+    end_update(1 << 0);
+    uint8_t* data = read(&blocks);
+    begin_update()[0] = 2;
+    end_update(1 << 0);
+    begin_update()[3] = 3;
+    end_update(1 << 3);
+    EXPECT_EQ(data[0], 1);
+    EXPECT_EQ(data[3], 0);
+    data = read(&blocks);
+    EXPECT_EQ(data[0], 2);
+    EXPECT_EQ(data[3], 3);
+}
@@ -31,6 +31,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "config.h"
 #include "timer.h"
 #include "split_flags.h"
+#include "debounce.h"
 
 #ifdef RGBLIGHT_ENABLE
 #   include "rgblight.h"
@@ -46,15 +47,6 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #  include "serial.h"
 #endif
 
-#ifndef DEBOUNCING_DELAY
-#   define DEBOUNCING_DELAY 5
-#endif
-
-#if (DEBOUNCING_DELAY > 0)
-    static uint16_t debouncing_time;
-    static bool debouncing = false;
-#endif
-
 #if (MATRIX_COLS <= 8)
 #    define print_matrix_header()  print("\nr/c 01234567\n")
 #    define print_matrix_row(row)  print_bin_reverse8(matrix_get_row(row))
@@ -63,7 +55,6 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #else
 #    error "Currently only supports 8 COLS"
 #endif
-static matrix_row_t matrix_debouncing[MATRIX_ROWS];
 
 #define ERROR_DISCONNECT_COUNT 5
 
@@ -75,8 +66,8 @@ static uint8_t row_pins[MATRIX_ROWS] = MATRIX_ROW_PINS;
 static uint8_t col_pins[MATRIX_COLS] = MATRIX_COL_PINS;
 
 /* matrix state(1:on, 0:off) */
-static matrix_row_t matrix[MATRIX_ROWS];
-static matrix_row_t matrix_debouncing[MATRIX_ROWS];
+static matrix_row_t raw_matrix[MATRIX_ROWS]; //raw values
+static matrix_row_t matrix[MATRIX_ROWS]; //debounced values
 
 #if (DIODE_DIRECTION == COL2ROW)
     static void init_cols(void);
@@ -157,10 +148,12 @@ void matrix_init(void)
 
     // initialize matrix state: all keys off
     for (uint8_t i=0; i < MATRIX_ROWS; i++) {
+        raw_matrix[i] = 0;
         matrix[i] = 0;
-        matrix_debouncing[i] = 0;
     }
-    
+
+    debounce_init(ROWS_PER_HAND);
+
     matrix_init_quantum();
     
 }
@@ -168,47 +161,21 @@ void matrix_init(void)
 uint8_t _matrix_scan(void)
 {
     int offset = isLeftHand ? 0 : (ROWS_PER_HAND);
+    bool changed = false;
+
 #if (DIODE_DIRECTION == COL2ROW)
     // Set row, read cols
     for (uint8_t current_row = 0; current_row < ROWS_PER_HAND; current_row++) {
-#       if (DEBOUNCING_DELAY > 0)
-            bool matrix_changed = read_cols_on_row(matrix_debouncing+offset, current_row);
-
-            if (matrix_changed) {
-                debouncing = true;
-                debouncing_time = timer_read();
-            }
-
-#       else
-            read_cols_on_row(matrix+offset, current_row);
-#       endif
-
+        changed |= read_cols_on_row(raw_matrix+offset, current_row);
     }
-
 #elif (DIODE_DIRECTION == ROW2COL)
     // Set col, read rows
     for (uint8_t current_col = 0; current_col < MATRIX_COLS; current_col++) {
-#       if (DEBOUNCING_DELAY > 0)
-            bool matrix_changed = read_rows_on_col(matrix_debouncing+offset, current_col);
-            if (matrix_changed) {
-                debouncing = true;
-                debouncing_time = timer_read();
-            }
-#       else
-             read_rows_on_col(matrix+offset, current_col);
-#       endif
-
+        changed |= read_rows_on_col(raw_matrix+offset, current_col);
     }
 #endif
 
-#   if (DEBOUNCING_DELAY > 0)
-        if (debouncing && (timer_elapsed(debouncing_time) > DEBOUNCING_DELAY)) {
-            for (uint8_t i = 0; i < ROWS_PER_HAND; i++) {
-                matrix[i+offset] = matrix_debouncing[i+offset];
-            }
-            debouncing = false;
-        }
-#   endif
+    debounce(raw_matrix+offset, matrix+offset, ROWS_PER_HAND, changed);
 
     return 1;
 }
@@ -286,25 +253,54 @@ i2c_error: // the cable is disconnceted, or something else went wrong
 
 #else // USE_SERIAL
 
+// Print the link error counters when they change, at most once a second,
+// so SERIAL_DELAY can be tuned while watching the console
+static void serial_print_stats(void) {
+    static uint16_t last_errors = 0;
+    static uint16_t last_print = 0;
+
+    const serial_stats_t *stats = serial_get_stats();
+    uint16_t errors = stats->corrupt + stats->timeouts;
+    if (errors != last_errors && timer_elapsed(last_print) >= 1000) {
+        dprintf("split: %lu transactions, %u corrupt, %u timeouts, %u retries, %u resends\n",
+                stats->transactions, stats->corrupt, stats->timeouts, stats->retries, stats->resends);
+        last_errors = errors;
+        last_print = timer_read();
+    }
+}
+
 int serial_transaction(void) {
     int slaveOffset = (isLeftHand) ? (ROWS_PER_HAND) : 0;
 
-    if (serial_update_buffers()) {
+    #ifdef BACKLIGHT_ENABLE
+        if (BACKLIT_DIRTY) {
+            // Write backlight level for slave to read
+            serial_master_buffer[SERIAL_BACKLIT_START] = backlight_config.enable ? backlight_config.level : 0;
+            serial_master_buffer_dirty |= SERIAL_BACKLIT_DIRTY;
+            BACKLIT_DIRTY = false;
+        }
+    #endif
+
+    #ifdef RGBLIGHT_ENABLE
+        if (RGB_DIRTY) {
+            uint32_t dword = eeconfig_read_rgblight();
+            for (int i = 0; i < 4; ++i) {
+                serial_master_buffer[SERIAL_RGBLIGHT_START+i] = dword >> (i * 8);
+            }
+            serial_master_buffer_dirty |= SERIAL_RGBLIGHT_DIRTY;
+            RGB_DIRTY = false;
+        }
+    #endif
+
+    int err = serial_update_buffers();
+    serial_print_stats();
+    if (err) {
         return 1;
     }
 
     for (int i = 0; i < ROWS_PER_HAND; ++i) {
         matrix[slaveOffset+i] = serial_slave_buffer[i];
     }
-    
-    #ifdef RGBLIGHT_ENABLE
-        // Code to send RGB over serial goes here (not implemented yet)
-    #endif
-    
-    #ifdef BACKLIGHT_ENABLE
-        // Write backlight level for slave to read
-        serial_master_buffer[SERIAL_BACKLIT_START] = backlight_config.enable ? backlight_config.level : 0;
-    #endif
 
     return 0;
 }
@@ -346,16 +342,18 @@ void matrix_slave_scan(void) {
         i2c_slave_buffer[I2C_KEYMAP_START+i] = matrix[offset+i];
     }   
 #else // USE_SERIAL
+    uint8_t rows[ROWS_PER_HAND];
     for (int i = 0; i < ROWS_PER_HAND; ++i) {
-        serial_slave_buffer[i] = matrix[offset+i];
+        rows[i] = matrix[offset+i];
     }
+    serial_slave_publish(rows);
 #endif
     matrix_slave_scan_user();
 }
 
 bool matrix_is_modified(void)
 {
-    if (debouncing) return false;
+    if (debounce_active()) return false;
     return true;
 }
 
@@ -1,228 +1,448 @@
 /*
- * WARNING: be careful changing this code, it is very timing dependent
+ * Split keyboard protocol, the bytes go over the link in transport.h
  */
 
-#ifndef F_CPU
-#define F_CPU 16000000
-#endif
-
-#include <avr/io.h>
-#include <avr/interrupt.h>
-#include <util/delay.h>
 #include <stdbool.h>
 #include "serial.h"
+#include "transport.h"
 
 #ifndef USE_I2C
 
-// Serial pulse period in microseconds. Its probably a bad idea to lower this
-// value.
-#define SERIAL_DELAY 24
+/* Only changes cross the line. Each side starts with a header byte, a 4 bit
+ * value and its complement so a damaged header is always noticed:
+ *
+ *   slave:  header(ROWS | STATE_OK | seq) [mask generation changed rows... crc]
+ *   master: header(STATE | ack) [parts changed parts... crc]
+ *
+ * The CRC covers the whole frame, header included.
+ *
+ * The slave scans on its own and publishes each complete scan as a
+ * snapshot. It sends the rows that changed since the master last
+ * acknowledged them, from the latest snapshot and numbered with a sequence
+ * number. The generation counts the snapshots, so the master can tell how
+ * fresh the rows are. The master answers with the
+ * number of the last rows it received intact and the slave sends the rows
+ * again until they are acknowledged. Backlight and RGB state go the other
+ * way only when they changed, and again until the slave reports them with
+ * STATE_OK. An idle board sends just the two headers.
+ *
+ * A damaged frame means the receiver doesn't know how long it is. It then
+ * stays off the line until the other side must be done. The master tries
+ * again up to SERIAL_RETRIES times in the same scan.
+ */
+#define HEADER_ROWS     0x08
+#define HEADER_STATE_OK 0x04
+#define HEADER_STATE    0x08
+#define HEADER_SEQ      0x03
+// sent by the master to ask for all rows, after a reset or an error
+#define SEQ_RESYNC      0
+
+#ifndef SERIAL_RETRIES
+#   define SERIAL_RETRIES 2
+#endif
+
+#define ROW_MASK_BYTES ((SERIAL_SLAVE_BUFFER_LENGTH + 7) / 8)
+
+#if SERIAL_SLAVE_BUFFER_LENGTH > 16
+#   error "Serial split supports up to 16 rows per half"
+#elif SERIAL_SLAVE_BUFFER_LENGTH > 8
+typedef uint16_t row_mask_t;
+#else
+typedef uint8_t row_mask_t;
+#endif
+
+#define ALL_ROWS ((row_mask_t)((1UL << SERIAL_SLAVE_BUFFER_LENGTH) - 1))
+
+/* CRC-8 (polynomial 0x07) by default, CRC-16/CCITT with SERIAL_CRC16 for
+ * links that still see errors. Computed a bit at a time, frames are a few
+ * bytes and a table would cost flash. */
+#ifdef SERIAL_CRC16
+typedef uint16_t crc_t;
+#   define CRC_INIT 0xFFFF
+#else
+typedef uint8_t crc_t;
+#   define CRC_INIT 0
+#endif
+#define CRC_BYTES sizeof(crc_t)
+
+// parts of serial_master_buffer in SERIAL_*_DIRTY bit order
+static const uint8_t master_buffer_parts[] = { SERIAL_BACKLIT_START, SERIAL_RGBLIGHT_START, SERIAL_MASTER_BUFFER_LENGTH };
+
+// Longest frames in bytes
+#define SERIAL_SLAVE_FRAME_MAX  (2 + ROW_MASK_BYTES + SERIAL_SLAVE_BUFFER_LENGTH + CRC_BYTES)
+#define SERIAL_MASTER_FRAME_MAX (2 + SERIAL_MASTER_BUFFER_LENGTH + CRC_BYTES)
+
+enum {
+  EXCHANGE_OK,
+  // no answer to the start of a transaction
+  EXCHANGE_ABSENT,
+  EXCHANGE_TIMEOUT,
+  EXCHANGE_CORRUPT,
+};
 
 uint8_t volatile serial_slave_buffer[SERIAL_SLAVE_BUFFER_LENGTH] = {0};
 uint8_t volatile serial_master_buffer[SERIAL_MASTER_BUFFER_LENGTH] = {0};
+uint8_t volatile serial_master_buffer_dirty = 0;
+// master: generation of the snapshot the rows came from
+uint8_t volatile serial_slave_generation = 0;
 
 #define SLAVE_DATA_CORRUPT (1<<0)
 volatile uint8_t status = 0;
 
-inline static
-void serial_delay(void) {
-  _delay_us(SERIAL_DELAY);
+/* slave: two snapshots of the debounced rows. The scan fills one while the
+ * transaction, which runs in an interrupt, sends from the other one, so
+ * the master never gets half of a scan. */
+static uint8_t snapshots[2][SERIAL_SLAVE_BUFFER_LENGTH];
+static volatile uint8_t front = 0;
+static volatile uint8_t generation = 0;
+// slave: rows not acknowledged by the master yet
+static volatile row_mask_t dirty_rows = ALL_ROWS;
+// slave: number of the last rows sent, master: of the last rows received
+static uint8_t sequence = SEQ_RESYNC;
+// slave: state came in intact in the last transaction
+static bool state_received = false;
+// master: parts of serial_master_buffer the slave hasn't confirmed yet
+static uint8_t state_in_flight = 0;
+
+static serial_stats_t stats;
+
+static
+crc_t crc_update(crc_t crc, uint8_t data) {
+#ifdef SERIAL_CRC16
+  crc ^= (uint16_t)data << 8;
+  for (uint8_t i = 0; i < 8; ++i) {
+    crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+#else
+  crc ^= data;
+  for (uint8_t i = 0; i < 8; ++i) {
+    crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+  }
+#endif
+  return crc;
 }
 
-inline static
-void serial_output(void) {
-  SERIAL_PIN_DDR |= SERIAL_PIN_MASK;
+static inline
+uint8_t header_encode(uint8_t value) {
+  return (value << 4) | (~value & 0x0F);
 }
 
-// make the serial pin an input with pull-up resistor
-inline static
-void serial_input(void) {
-  SERIAL_PIN_DDR  &= ~SERIAL_PIN_MASK;
-  SERIAL_PIN_PORT |= SERIAL_PIN_MASK;
+static inline
+bool header_valid(uint8_t header) {
+  return (header >> 4) == (~header & 0x0F);
 }
 
-inline static
-uint8_t serial_read_pin(void) {
-  return !!(SERIAL_PIN_INPUT & SERIAL_PIN_MASK);
+static
+void send(uint8_t data, crc_t *crc) {
+  transport_write(data);
+  *crc = crc_update(*crc, data);
 }
 
-inline static
-void serial_low(void) {
-  SERIAL_PIN_PORT &= ~SERIAL_PIN_MASK;
+static
+void send_crc(crc_t crc) {
+  for (uint8_t i = 0; i < CRC_BYTES; ++i) {
+    transport_write(crc >> (i * 8));
+  }
 }
 
-inline static
-void serial_high(void) {
-  SERIAL_PIN_PORT |= SERIAL_PIN_MASK;
+static
+uint8_t receive(uint8_t *data, crc_t *crc) {
+  if (!transport_read(data)) {
+    return EXCHANGE_TIMEOUT;
+  }
+  *crc = crc_update(*crc, *data);
+  return EXCHANGE_OK;
+}
+
+static
+uint8_t receive_crc(crc_t crc) {
+  crc_t received = 0;
+  for (uint8_t i = 0; i < CRC_BYTES; ++i) {
+    uint8_t data;
+    if (!transport_read(&data)) {
+      return EXCHANGE_TIMEOUT;
+    }
+    received |= (crc_t)data << (i * 8);
+  }
+  return received == crc ? EXCHANGE_OK : EXCHANGE_CORRUPT;
 }
 
 void serial_master_init(void) {
-  serial_output();
-  serial_high();
+  transport_master_init();
 }
 
 void serial_slave_init(void) {
-  serial_input();
-
-  // Enable INT0
-  EIMSK |= _BV(INT0);
-  // Trigger on falling edge of INT0
-  EICRA &= ~(_BV(ISC00) | _BV(ISC01));
+  transport_slave_init();
 }
 
-// Used by the master to synchronize timing with the slave.
-static
-void sync_recv(void) {
-  serial_input();
-  // This shouldn't hang if the slave disconnects because the
-  // serial line will float to high if the slave does disconnect.
-  while (!serial_read_pin());
-  serial_delay();
+void serial_slave_publish(const uint8_t *rows) {
+  uint8_t back = front ^ 1;
+  row_mask_t changed = 0;
+  for (uint8_t i = 0; i < SERIAL_SLAVE_BUFFER_LENGTH; ++i) {
+    snapshots[back][i] = rows[i];
+    if (rows[i] != snapshots[front][i]) {
+      changed |= (row_mask_t)1 << i;
+    }
+  }
+  generation++;
+  // Switch first: rows marked dirty before would go out with the old values
+  front = back;
+  dirty_rows |= changed;
 }
 
-// Used by the slave to send a synchronization signal to the master.
 static
-void sync_send(void) {
-  serial_output();
-
-  serial_low();
-  serial_delay();
-
-  serial_high();
+void slave_send_rows(uint8_t header, row_mask_t rows) {
+  const uint8_t *snapshot = snapshots[front];
+  crc_t crc = crc_update(CRC_INIT, header);
+  for (uint8_t i = 0; i < ROW_MASK_BYTES; ++i) {
+    send(rows >> (i * 8), &crc);
+  }
+  send(generation, &crc);
+  for (uint8_t i = 0; i < SERIAL_SLAVE_BUFFER_LENGTH; ++i) {
+    if (rows & ((row_mask_t)1 << i)) {
+      send(snapshot[i], &crc);
+    }
+  }
+  send_crc(crc);
 }
 
-// Reads a byte from the serial line
 static
-uint8_t serial_read_byte(void) {
-  uint8_t byte = 0;
-  serial_input();
-  for ( uint8_t i = 0; i < 8; ++i) {
-    byte = (byte << 1) | serial_read_pin();
-    serial_delay();
-    _delay_us(1);
+bool slave_receive_state(uint8_t header) {
+  crc_t crc = crc_update(CRC_INIT, header);
+  uint8_t parts;
+  if (receive(&parts, &crc)) {
+    return false;
   }
 
-  return byte;
-}
+  uint8_t buffer[SERIAL_MASTER_BUFFER_LENGTH];
+  for (uint8_t part = 0; part < sizeof(master_buffer_parts) - 1; ++part) {
+    if (parts & (1 << part)) {
+      for (uint8_t i = master_buffer_parts[part]; i < master_buffer_parts[part + 1]; ++i) {
+        if (receive(&buffer[i], &crc)) {
+          return false;
+        }
+      }
+    }
+  }
+  if (receive_crc(crc)) {
+    return false;
+  }
 
-// Sends a byte with MSB ordering
-static
-void serial_write_byte(uint8_t data) {
-  uint8_t b = 8;
-  serial_output();
-  while( b-- ) {
-    if(data & (1 << b)) {
-      serial_high();
-    } else {
-      serial_low();
+  for (uint8_t part = 0; part < sizeof(master_buffer_parts) - 1; ++part) {
+    if (parts & (1 << part)) {
+      for (uint8_t i = master_buffer_parts[part]; i < master_buffer_parts[part + 1]; ++i) {
+        serial_master_buffer[i] = buffer[i];
+      }
     }
-    serial_delay();
   }
+  serial_master_buffer_dirty |= parts;
+  return true;
 }
 
-// interrupt handle to be used by the slave device
-ISR(SERIAL_PIN_INTERRUPT) {
-  sync_send();
-
-  uint8_t checksum = 0;
-  for (int i = 0; i < SERIAL_SLAVE_BUFFER_LENGTH; ++i) {
-    serial_write_byte(serial_slave_buffer[i]);
-    sync_send();
-    checksum += serial_slave_buffer[i];
+static
+bool slave_exchange(void) {
+  row_mask_t rows = dirty_rows;
+  if (rows) {
+    sequence = sequence % HEADER_SEQ + 1;
+  }
+  uint8_t header = header_encode((rows ? HEADER_ROWS : 0) | (state_received ? HEADER_STATE_OK : 0) | sequence);
+  state_received = false;
+  transport_write(header);
+  if (rows) {
+    slave_send_rows(header, rows);
   }
-  serial_write_byte(checksum);
-  sync_send();
 
-  // wait for the sync to finish sending
-  serial_delay();
+  transport_turnaround();
 
-  // read the middle of pulses
-  _delay_us(SERIAL_DELAY/2);
+  if (!transport_read(&header) || !header_valid(header)) {
+    return false;
+  }
 
-  uint8_t checksum_computed = 0;
-  for (int i = 0; i < SERIAL_MASTER_BUFFER_LENGTH; ++i) {
-    serial_master_buffer[i] = serial_read_byte();
-    sync_send();
-    checksum_computed += serial_master_buffer[i];
+  uint8_t value = header >> 4;
+  uint8_t ack = value & HEADER_SEQ;
+  if (ack == SEQ_RESYNC) {
+    dirty_rows = ALL_ROWS;
+  } else if (rows && ack == sequence) {
+    dirty_rows &= ~rows;
   }
-  uint8_t checksum_received = serial_read_byte();
-  sync_send();
 
-  serial_input(); // end transaction
+  if (value & HEADER_STATE) {
+    state_received = slave_receive_state(header);
+    return state_received;
+  }
+  return true;
+}
 
-  if ( checksum_computed != checksum_received ) {
-    status |= SLAVE_DATA_CORRUPT;
-  } else {
+// Called by the transport on the slave, with the rest of the slave stopped
+void serial_slave_transaction(void) {
+  if (slave_exchange()) {
     status &= ~SLAVE_DATA_CORRUPT;
+  } else {
+    status |= SLAVE_DATA_CORRUPT;
+    // ignore the rest of what the master is sending
+    transport_idle(SERIAL_MASTER_FRAME_MAX);
   }
+  transport_slave_end();
 }
 
-inline
-bool serial_slave_DATA_CORRUPT(void) {
+bool serial_slave_data_corrupt(void) {
   return status & SLAVE_DATA_CORRUPT;
 }
 
-// Copies the serial_slave_buffer to the master and sends the
-// serial_master_buffer to the slave.
-//
-// Returns:
-// 0 => no error
-// 1 => slave did not respond
-int serial_update_buffers(void) {
-  // this code is very time dependent, so we need to disable interrupts
-  cli();
+// Master: leave the line to the slave until it finished the damaged
+// transaction, and ask for all rows next time
+static
+uint8_t master_abort(uint8_t result) {
+  sequence = SEQ_RESYNC;
+  transport_idle(SERIAL_SLAVE_FRAME_MAX + SERIAL_MASTER_FRAME_MAX);
+  transport_master_end();
+  return result;
+}
 
-  // signal to the slave that we want to start a transaction
-  serial_output();
-  serial_low();
-  _delay_us(1);
+static
+uint8_t master_receive_rows(uint8_t header, row_mask_t *received) {
+  crc_t crc = crc_update(CRC_INIT, header);
+  row_mask_t rows = 0;
+  for (uint8_t i = 0; i < ROW_MASK_BYTES; ++i) {
+    uint8_t mask;
+    if (receive(&mask, &crc)) {
+      return EXCHANGE_TIMEOUT;
+    }
+    rows |= (row_mask_t)mask << (i * 8);
+  }
+  if (rows & ~ALL_ROWS) {
+    // can't be right, and the length would be wrong too
+    return EXCHANGE_CORRUPT;
+  }
+  uint8_t snapshot;
+  if (receive(&snapshot, &crc)) {
+    return EXCHANGE_TIMEOUT;
+  }
 
-  // wait for the slaves response
-  serial_input();
-  serial_high();
-  _delay_us(SERIAL_DELAY);
+  uint8_t buffer[SERIAL_SLAVE_BUFFER_LENGTH];
+  for (uint8_t i = 0; i < SERIAL_SLAVE_BUFFER_LENGTH; ++i) {
+    if (rows & ((row_mask_t)1 << i)) {
+      if (receive(&buffer[i], &crc)) {
+        return EXCHANGE_TIMEOUT;
+      }
+    }
+  }
+  uint8_t result = receive_crc(crc);
+  if (result) {
+    return result;
+  }
 
-  // check if the slave is present
-  if (serial_read_pin()) {
-    // slave failed to pull the line low, assume not present
-    sei();
-    return 1;
+  for (uint8_t i = 0; i < SERIAL_SLAVE_BUFFER_LENGTH; ++i) {
+    if (rows & ((row_mask_t)1 << i)) {
+      serial_slave_buffer[i] = buffer[i];
+    }
   }
+  serial_slave_generation = snapshot;
+  *received = rows;
+  return EXCHANGE_OK;
+}
 
-  // if the slave is present syncronize with it
-  sync_recv();
+static
+void master_send_state(uint8_t header, uint8_t parts) {
+  crc_t crc = crc_update(CRC_INIT, header);
+  send(parts, &crc);
+  for (uint8_t part = 0; part < sizeof(master_buffer_parts) - 1; ++part) {
+    if (parts & (1 << part)) {
+      for (uint8_t i = master_buffer_parts[part]; i < master_buffer_parts[part + 1]; ++i) {
+        send(serial_master_buffer[i], &crc);
+      }
+    }
+  }
+  send_crc(crc);
+}
+
+static
+uint8_t master_exchange(void) {
+  if (!transport_master_start()) {
+    return EXCHANGE_ABSENT;
+  }
+
+  uint8_t header;
+  if (!transport_read(&header)) {
+    // nothing came back, assume the slave is not present
+    transport_master_end();
+    return EXCHANGE_ABSENT;
+  }
+  if (!header_valid(header)) {
+    return master_abort(EXCHANGE_CORRUPT);
+  }
 
-  uint8_t checksum_computed = 0;
-  // receive data from the slave
-  for (int i = 0; i < SERIAL_SLAVE_BUFFER_LENGTH; ++i) {
-    serial_slave_buffer[i] = serial_read_byte();
-    sync_recv();
-    checksum_computed += serial_slave_buffer[i];
+  uint8_t value = header >> 4;
+  if (state_in_flight && !(value & HEADER_STATE_OK)) {
+    // the slave didn't get it, send it again
+    serial_master_buffer_dirty |= state_in_flight;
+    stats.resends++;
   }
-  uint8_t checksum_received = serial_read_byte();
-  sync_recv();
+  state_in_flight = 0;
 
-  if (checksum_computed != checksum_received) {
-    sei();
-    return 1;
+  if (value & HEADER_ROWS) {
+    row_mask_t rows;
+    uint8_t result = master_receive_rows(header, &rows);
+    if (result) {
+      return master_abort(result);
+    }
+    // keep asking until all rows came in after a resync
+    if (sequence != SEQ_RESYNC || rows == ALL_ROWS) {
+      sequence = value & HEADER_SEQ;
+    }
   }
 
-  uint8_t checksum = 0;
-  // send data to the slave
-  for (int i = 0; i < SERIAL_MASTER_BUFFER_LENGTH; ++i) {
-    serial_write_byte(serial_master_buffer[i]);
-    sync_recv();
-    checksum += serial_master_buffer[i];
+  transport_turnaround();
+
+  uint8_t parts = serial_master_buffer_dirty;
+  header = header_encode((parts ? HEADER_STATE : 0) | sequence);
+  transport_write(header);
+  if (parts) {
+    master_send_state(header, parts);
+    serial_master_buffer_dirty &= ~parts;
+    state_in_flight = parts;
   }
-  serial_write_byte(checksum);
-  sync_recv();
 
-  // always, release the line when not in use
-  serial_output();
-  serial_high();
+  transport_master_end();
+  return EXCHANGE_OK;
+}
+
+// Receives the rows the slave changed into serial_slave_buffer and sends
+// the changed parts of serial_master_buffer to the slave.
+//
+// Returns:
+// 0 => no error
+// 1 => slave did not respond
+int serial_update_buffers(void) {
+  for (uint8_t attempt = 0; ; ++attempt) {
+    stats.transactions++;
+    switch (master_exchange()) {
+      case EXCHANGE_OK:
+        return 0;
+      case EXCHANGE_ABSENT:
+        // not worth retrying, the cable is out
+        stats.timeouts++;
+        return 1;
+      case EXCHANGE_TIMEOUT:
+        stats.timeouts++;
+        break;
+      case EXCHANGE_CORRUPT:
+        stats.corrupt++;
+        break;
+    }
+    if (attempt == SERIAL_RETRIES) {
+      return 1;
+    }
+    stats.retries++;
+  }
+}
+
+const serial_stats_t *serial_get_stats(void) {
+  return &stats;
+}
 
-  sei();
-  return 0;
+void serial_clear_stats(void) {
+  stats = (serial_stats_t){0};
 }
 
 #endif
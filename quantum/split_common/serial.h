@@ -3,6 +3,7 @@
 
 #include "config.h"
 #include <stdbool.h>
+#include <stdint.h>
 
 /* TODO:  some defines for interrupt setup */
 #define SERIAL_PIN_DDR DDRD
@@ -12,18 +13,42 @@
 #define SERIAL_PIN_INTERRUPT INT0_vect
 
 #define SERIAL_SLAVE_BUFFER_LENGTH MATRIX_ROWS/2
-#define SERIAL_MASTER_BUFFER_LENGTH 1
+#define SERIAL_MASTER_BUFFER_LENGTH 5
 
 // Address location defines 
 #define SERIAL_BACKLIT_START   0x00
+#define SERIAL_RGBLIGHT_START  0x01
+
+// Parts of serial_master_buffer that changed
+#define SERIAL_BACKLIT_DIRTY   (1<<0)
+#define SERIAL_RGBLIGHT_DIRTY  (1<<1)
 
 // Buffers for master - slave communication
 extern volatile uint8_t serial_slave_buffer[SERIAL_SLAVE_BUFFER_LENGTH];
 extern volatile uint8_t serial_master_buffer[SERIAL_MASTER_BUFFER_LENGTH];
+// The master sets these after changing serial_master_buffer, only the
+// changed parts are sent. The slave sets them when they were received.
+extern volatile uint8_t serial_master_buffer_dirty;
+// Master: counts the slave's scans, as of the last rows received
+extern volatile uint8_t serial_slave_generation;
+
+// Master side error counters, printed to the console with debug enabled
+typedef struct {
+    uint32_t transactions;
+    uint16_t corrupt;     // damaged frames from the slave
+    uint16_t timeouts;    // no answer, or the slave stopped mid-frame
+    uint16_t retries;     // transactions run again after an error
+    uint16_t resends;     // master state the slave missed, sent again
+} serial_stats_t;
 
 void serial_master_init(void);
 void serial_slave_init(void);
+// Slave: publish the debounced rows of a complete scan, the rows that
+// changed are sent to the master on its next transaction
+void serial_slave_publish(const uint8_t *rows);
 int serial_update_buffers(void);
 bool serial_slave_data_corrupt(void);
+const serial_stats_t *serial_get_stats(void);
+void serial_clear_stats(void);
 
 #endif
@@ -64,6 +64,10 @@ static void keyboard_master_setup(void) {
     // For master the Backlight info needs to be sent on startup
     // Otherwise the salve won't start with the proper info until an update
     BACKLIT_DIRTY = true;
+#if defined(RGBLIGHT_ENABLE) && !(defined(USE_I2C) || defined(EH))
+    // Same for the RGB state over serial
+    RGB_DIRTY = true;
+#endif
 }
 
 static void keyboard_slave_setup(void) {
@@ -112,7 +116,13 @@ void keyboard_slave_loop(void) {
                 BACKLIT_DIRTY = false;
             }
         #else // USE_SERIAL
-            backlight_set(serial_master_buffer[SERIAL_BACKLIT_START]);
+            if (serial_master_buffer_dirty & SERIAL_BACKLIT_DIRTY) {
+                cli();
+                serial_master_buffer_dirty &= ~SERIAL_BACKLIT_DIRTY;
+                uint8_t level = serial_master_buffer[SERIAL_BACKLIT_START];
+                sei();
+                backlight_set(level);
+            }
         #endif
     #endif
     // Read RGB Info
@@ -137,7 +147,16 @@ void keyboard_slave_loop(void) {
                 sei();
             }
         #else // USE_SERIAL
-            // Add serial implementation for RGB here
+            if (serial_master_buffer_dirty & SERIAL_RGBLIGHT_DIRTY) {
+                cli();
+                serial_master_buffer_dirty &= ~SERIAL_RGBLIGHT_DIRTY;
+                uint32_t dword = 0;
+                for (int i = 0; i < 4; i++) {
+                    dword |= (uint32_t)serial_master_buffer[SERIAL_RGBLIGHT_START+i] << (i * 8);
+                }
+                sei();
+                rgblight_update_dword(dword);
+            }
         #endif
     #endif
    }
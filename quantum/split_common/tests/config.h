@@ -0,0 +1,7 @@
+#ifndef SPLIT_SERIAL_TEST_CONFIG_H
+#define SPLIT_SERIAL_TEST_CONFIG_H
+
+// Four rows per half
+#define MATRIX_ROWS 8
+
+#endif
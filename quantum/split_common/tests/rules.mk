@@ -0,0 +1,9 @@
+SPLIT_TESTS_PATH := $(QUANTUM_PATH)/split_common/tests
+
+split_serial_SRC :=\
+	$(SPLIT_TESTS_PATH)/split_serial_tests.cpp \
+	$(SPLIT_TESTS_PATH)/serial_master.c \
+	$(SPLIT_TESTS_PATH)/serial_slave.c
+
+# The test config.h has to be found before any other one
+split_serial_INC := $(SPLIT_TESTS_PATH) $(QUANTUM_PATH)/split_common
@@ -0,0 +1,7 @@
+/*
+ * serial.c as it runs on the master half
+ */
+
+#define SERIAL_NAME(name) master_##name
+#include "serial_names.h"
+#include "serial.c"
@@ -0,0 +1,18 @@
+/*
+ * The tests link serial.c twice, once for each half. SERIAL_NAME gives the
+ * public names of each copy a prefix.
+ */
+
+#define serial_slave_buffer        SERIAL_NAME(serial_slave_buffer)
+#define serial_master_buffer       SERIAL_NAME(serial_master_buffer)
+#define serial_master_buffer_dirty SERIAL_NAME(serial_master_buffer_dirty)
+#define serial_slave_generation    SERIAL_NAME(serial_slave_generation)
+#define status                     SERIAL_NAME(status)
+#define serial_master_init         SERIAL_NAME(serial_master_init)
+#define serial_slave_init          SERIAL_NAME(serial_slave_init)
+#define serial_slave_publish       SERIAL_NAME(serial_slave_publish)
+#define serial_slave_transaction   SERIAL_NAME(serial_slave_transaction)
+#define serial_slave_data_corrupt  SERIAL_NAME(serial_slave_data_corrupt)
+#define serial_update_buffers      SERIAL_NAME(serial_update_buffers)
+#define serial_get_stats           SERIAL_NAME(serial_get_stats)
+#define serial_clear_stats         SERIAL_NAME(serial_clear_stats)
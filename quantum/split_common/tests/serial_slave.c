@@ -0,0 +1,7 @@
+/*
+ * serial.c as it runs on the slave half
+ */
+
+#define SERIAL_NAME(name) slave_##name
+#include "serial_names.h"
+#include "serial.c"
@@ -0,0 +1,323 @@
+/*
+Copyright 2018 QMK Firmware contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gtest/gtest.h"
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+extern "C" {
+#include "serial.h"
+#include "transport.h"
+
+// The two copies of serial.c, see serial_names.h
+extern volatile uint8_t master_serial_slave_buffer[SERIAL_SLAVE_BUFFER_LENGTH];
+extern volatile uint8_t master_serial_slave_generation;
+extern volatile uint8_t master_serial_master_buffer[SERIAL_MASTER_BUFFER_LENGTH];
+extern volatile uint8_t master_serial_master_buffer_dirty;
+extern volatile uint8_t slave_serial_master_buffer[SERIAL_MASTER_BUFFER_LENGTH];
+int master_serial_update_buffers(void);
+const serial_stats_t *master_serial_get_stats(void);
+void master_serial_clear_stats(void);
+void slave_serial_slave_publish(const uint8_t *rows);
+void slave_serial_slave_transaction(void);
+}
+
+#define ROWS SERIAL_SLAVE_BUFFER_LENGTH
+#define DEBOUNCE 5
+
+/* A fake transport: the slave runs its transactions on a thread of its own,
+ * like the interrupt on the real board, and the bytes go through two
+ * queues. A side reads nothing once the other one is done sending. */
+namespace {
+
+enum class Role { master, slave };
+thread_local Role role = Role::master;
+
+struct Channel {
+    std::deque<uint8_t> bytes;
+    // the writer won't send any more
+    bool closed = false;
+};
+
+struct Line {
+    std::mutex mutex;
+    std::condition_variable changed;
+    Channel to_slave;
+    Channel to_master;
+    bool start = false;
+    bool stop = false;
+    bool done = true;
+    // bytes sent both ways
+    unsigned bytes = 0;
+    // bytes sent by the slave in this transaction
+    unsigned slave_bytes = 0;
+    // damage this byte from the slave, -1 for none
+    int corrupt_at = -1;
+    // damage every nth byte both ways, 0 for none
+    unsigned lossy_every = 0;
+} line;
+
+}
+
+extern "C" {
+
+void transport_master_init(void) {}
+void transport_slave_init(void) {}
+void transport_turnaround(void) {}
+
+bool transport_master_start(void) {
+    std::lock_guard<std::mutex> lock(line.mutex);
+    line.to_slave = Channel();
+    line.to_master = Channel();
+    line.slave_bytes = 0;
+    line.done = false;
+    line.start = true;
+    line.changed.notify_all();
+    return true;
+}
+
+void transport_master_end(void) {
+    std::unique_lock<std::mutex> lock(line.mutex);
+    line.to_slave.closed = true;
+    line.changed.notify_all();
+    line.changed.wait(lock, [] { return line.done; });
+}
+
+void transport_slave_end(void) {
+    std::lock_guard<std::mutex> lock(line.mutex);
+    line.to_master.closed = true;
+    line.done = true;
+    line.changed.notify_all();
+}
+
+void transport_write(uint8_t data) {
+    std::lock_guard<std::mutex> lock(line.mutex);
+    line.bytes++;
+    if (line.lossy_every && line.bytes % line.lossy_every == 0) {
+        data ^= 0x10;
+    }
+    if (role == Role::slave) {
+        if ((int)line.slave_bytes++ == line.corrupt_at) {
+            data ^= 0x10;
+            line.corrupt_at = -1;
+        }
+        line.to_master.bytes.push_back(data);
+    } else {
+        line.to_slave.bytes.push_back(data);
+    }
+    line.changed.notify_all();
+}
+
+bool transport_read(uint8_t *data) {
+    std::unique_lock<std::mutex> lock(line.mutex);
+    Channel &channel = role == Role::slave ? line.to_slave : line.to_master;
+    line.changed.wait_for(lock, std::chrono::seconds(1), [&] { return !channel.bytes.empty() || channel.closed; });
+    if (channel.bytes.empty()) {
+        return false;
+    }
+    *data = channel.bytes.front();
+    channel.bytes.pop_front();
+    return true;
+}
+
+void transport_idle(uint8_t bytes) {
+    (void)bytes;
+    if (role == Role::master) {
+        // the slave gives up reading and finishes its side
+        std::lock_guard<std::mutex> lock(line.mutex);
+        line.to_slave.closed = true;
+        line.changed.notify_all();
+    }
+}
+
+}
+
+// One half of the keyboard, debounced like quantum/matrix.c
+class Half {
+public:
+    void press(uint8_t row, uint8_t col) { raw[row] |= 1 << col; }
+    void release(uint8_t row, uint8_t col) { raw[row] &= ~(1 << col); }
+
+    void scan() {
+        if (memcmp(raw, last_raw, ROWS) != 0) {
+            memcpy(last_raw, raw, ROWS);
+            debouncing = DEBOUNCE;
+        } else if (debouncing && --debouncing == 0) {
+            memcpy(debounced, raw, ROWS);
+        }
+    }
+
+    uint8_t raw[ROWS] = {0};
+    uint8_t last_raw[ROWS] = {0};
+    uint8_t debounced[ROWS] = {0};
+    uint8_t debouncing = 0;
+};
+
+class SplitSerial : public testing::Test {
+protected:
+    SplitSerial() : slave_thread([] {
+        role = Role::slave;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(line.mutex);
+                line.changed.wait(lock, [] { return line.start || line.stop; });
+                if (line.stop) {
+                    return;
+                }
+                line.start = false;
+            }
+            slave_serial_slave_transaction();
+        }
+    }) {
+        // leave nothing over from the last test
+        uint8_t rows[ROWS] = {0};
+        slave_serial_slave_publish(rows);
+        for (int i = 0; i < 3; i++) {
+            master_serial_update_buffers();
+        }
+        master_serial_clear_stats();
+        line.bytes = 0;
+    }
+
+    ~SplitSerial() {
+        {
+            std::lock_guard<std::mutex> lock(line.mutex);
+            line.stop = true;
+            line.changed.notify_all();
+        }
+        slave_thread.join();
+        line.stop = false;
+        line.lossy_every = 0;
+    }
+
+    // One millisecond on both halves, the slave scans before or after the
+    // master's transaction. Returns the master's view of the slave half.
+    const volatile uint8_t *scan(bool slave_first) {
+        slave.scan();
+        if (slave_first) {
+            slave_serial_slave_publish(slave.debounced);
+        }
+        master.scan();
+        EXPECT_EQ(master_serial_update_buffers(), 0);
+        if (!slave_first) {
+            slave_serial_slave_publish(slave.debounced);
+        }
+        return master_serial_slave_buffer;
+    }
+
+    // Scans until the master sees both keys, returns the scans it took for each
+    void chord(bool slave_first, int *master_scans, int *slave_scans) {
+        master.press(0, 0);
+        slave.press(0, 0);
+        *master_scans = *slave_scans = 0;
+        for (int i = 1; i <= 20; i++) {
+            const volatile uint8_t *remote = scan(slave_first);
+            if (!*master_scans && master.debounced[0]) {
+                *master_scans = i;
+            }
+            if (!*slave_scans && remote[0]) {
+                *slave_scans = i;
+            }
+        }
+    }
+
+    std::thread slave_thread;
+    Half master;
+    Half slave;
+};
+
+TEST_F(SplitSerial, ChordReachesTheMasterInOneScan) {
+    int master_scans, slave_scans;
+    chord(true, &master_scans, &slave_scans);
+    EXPECT_EQ(master_scans, DEBOUNCE + 1);
+    EXPECT_EQ(slave_scans, master_scans);
+}
+
+TEST_F(SplitSerial, SlaveScanAfterTheTransactionIsOneScanLate) {
+    int master_scans, slave_scans;
+    chord(false, &master_scans, &slave_scans);
+    EXPECT_EQ(master_scans, DEBOUNCE + 1);
+    EXPECT_EQ(slave_scans, master_scans + 1);
+}
+
+TEST_F(SplitSerial, SendsTheLatestScanOnly) {
+    uint8_t generation = master_serial_slave_generation;
+    uint8_t rows[ROWS] = {0x01, 0x02};
+    slave_serial_slave_publish(rows);
+    rows[1] = 0;
+    rows[2] = 0x04;
+    slave_serial_slave_publish(rows);
+    EXPECT_EQ(master_serial_update_buffers(), 0);
+    EXPECT_EQ(master_serial_slave_buffer[0], 0x01);
+    EXPECT_EQ(master_serial_slave_buffer[1], 0x00);
+    EXPECT_EQ(master_serial_slave_buffer[2], 0x04);
+    EXPECT_EQ(master_serial_slave_generation, (uint8_t)(generation + 2));
+}
+
+TEST_F(SplitSerial, RetriesADamagedFrameInTheSameScan) {
+    uint8_t rows[ROWS] = {0x08};
+    slave_serial_slave_publish(rows);
+    // the row, after the header, mask and generation
+    line.corrupt_at = 3;
+    EXPECT_EQ(master_serial_update_buffers(), 0);
+    EXPECT_EQ(master_serial_slave_buffer[0], 0x08);
+    EXPECT_EQ(master_serial_get_stats()->corrupt, 1);
+    EXPECT_EQ(master_serial_get_stats()->retries, 1);
+    EXPECT_EQ(master_serial_get_stats()->resends, 0);
+}
+
+TEST_F(SplitSerial, BytesOnTheWire) {
+    EXPECT_EQ(master_serial_update_buffers(), 0);
+    // just the two headers
+    EXPECT_EQ(line.bytes, 2u);
+
+    uint8_t rows[ROWS] = {0, 0x20};
+    slave_serial_slave_publish(rows);
+    line.bytes = 0;
+    EXPECT_EQ(master_serial_update_buffers(), 0);
+    // headers, mask, generation, one row and the CRC
+    EXPECT_EQ(line.bytes, 6u);
+}
+
+TEST_F(SplitSerial, LossyLinkStillDeliversTheLatestState) {
+    uint8_t rows[ROWS] = {0};
+    line.lossy_every = 7;
+    for (int i = 1; i <= 200; i++) {
+        rows[i % ROWS] = i;
+        slave_serial_slave_publish(rows);
+        master_serial_master_buffer[SERIAL_BACKLIT_START] = i;
+        master_serial_master_buffer_dirty |= SERIAL_BACKLIT_DIRTY;
+        // may give up after SERIAL_RETRIES, the next scan carries on
+        master_serial_update_buffers();
+    }
+    line.lossy_every = 0;
+    for (int i = 0; i < 3; i++) {
+        EXPECT_EQ(master_serial_update_buffers(), 0);
+    }
+
+    for (int i = 0; i < ROWS; i++) {
+        EXPECT_EQ(master_serial_slave_buffer[i], rows[i]) << "row " << i;
+    }
+    EXPECT_EQ(slave_serial_master_buffer[SERIAL_BACKLIT_START], 200);
+    const serial_stats_t *stats = master_serial_get_stats();
+    EXPECT_GT(stats->corrupt + stats->timeouts, 0);
+    EXPECT_GT(stats->retries, 0);
+    EXPECT_GT(stats->resends, 0);
+}
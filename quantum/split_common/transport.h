@@ -0,0 +1,39 @@
+#ifndef SPLIT_TRANSPORT_H
+#define SPLIT_TRANSPORT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* The byte level link under the split protocol in serial.c, picked with
+ * SPLIT_TRANSPORT in rules.mk:
+ *
+ *   bitbang: one wire on SERIAL_PIN, clocked in software (the default)
+ *   usart:   the hardware USART1 in half duplex
+ *
+ * The master starts every transaction. The slave backend calls
+ * serial_slave_transaction() when that happens, then the slave sends its
+ * frame and the master answers with its own.
+ */
+
+void transport_master_init(void);
+void transport_slave_init(void);
+
+// Master: start a transaction, false if the slave didn't answer
+bool transport_master_start(void);
+// Master: finish a transaction and release the line
+void transport_master_end(void);
+// Slave: finish a transaction and wait for the next one
+void transport_slave_end(void);
+
+void transport_write(uint8_t data);
+// Returns false if nothing came in time
+bool transport_read(uint8_t *data);
+// Called by both sides when the slave has sent its frame
+void transport_turnaround(void);
+// Stay off the line while the other side may still send this many bytes
+void transport_idle(uint8_t bytes);
+
+// Run by the slave backend when the master starts a transaction
+void serial_slave_transaction(void);
+
+#endif
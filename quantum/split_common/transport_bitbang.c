@@ -0,0 +1,212 @@
+/*
+ * WARNING: be careful changing this code, it is very timing dependent
+ */
+
+#ifndef F_CPU
+#define F_CPU 16000000
+#endif
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/delay.h>
+#include <stdbool.h>
+#include "serial.h"
+#include "transport.h"
+
+#ifndef USE_I2C
+
+// Serial pulse period in microseconds. Its probably a bad idea to lower this
+// value, check the error counters in the console if you do.
+#ifndef SERIAL_DELAY
+#define SERIAL_DELAY 24
+#endif
+
+// time to send a byte with its sync pulse
+#define SERIAL_BYTE_TIME (9 * SERIAL_DELAY + 8)
+
+// Every byte is followed by a sync pulse from the slave, whichever way
+// the byte went
+static bool is_master = false;
+
+inline static
+void serial_delay(void) {
+  _delay_us(SERIAL_DELAY);
+}
+
+inline static
+void serial_output(void) {
+  SERIAL_PIN_DDR |= SERIAL_PIN_MASK;
+}
+
+// make the serial pin an input with pull-up resistor
+inline static
+void serial_input(void) {
+  SERIAL_PIN_DDR  &= ~SERIAL_PIN_MASK;
+  SERIAL_PIN_PORT |= SERIAL_PIN_MASK;
+}
+
+inline static
+uint8_t serial_read_pin(void) {
+  return !!(SERIAL_PIN_INPUT & SERIAL_PIN_MASK);
+}
+
+inline static
+void serial_low(void) {
+  SERIAL_PIN_PORT &= ~SERIAL_PIN_MASK;
+}
+
+inline static
+void serial_high(void) {
+  SERIAL_PIN_PORT |= SERIAL_PIN_MASK;
+}
+
+void transport_master_init(void) {
+  is_master = true;
+  serial_output();
+  serial_high();
+}
+
+void transport_slave_init(void) {
+  serial_input();
+
+  // Enable INT0
+  EIMSK |= _BV(INT0);
+  // Trigger on falling edge of INT0
+  EICRA &= ~(_BV(ISC00) | _BV(ISC01));
+}
+
+// Used by the master to synchronize timing with the slave.
+static
+void sync_recv(void) {
+  serial_input();
+  // This shouldn't hang if the slave disconnects because the
+  // serial line will float to high if the slave does disconnect.
+  while (!serial_read_pin());
+  serial_delay();
+}
+
+// Used by the slave to send a synchronization signal to the master.
+static
+void sync_send(void) {
+  serial_output();
+
+  serial_low();
+  serial_delay();
+
+  serial_high();
+}
+
+// Reads a byte from the serial line
+static
+uint8_t serial_read_byte(void) {
+  uint8_t byte = 0;
+  serial_input();
+  for ( uint8_t i = 0; i < 8; ++i) {
+    byte = (byte << 1) | serial_read_pin();
+    serial_delay();
+    _delay_us(1);
+  }
+
+  return byte;
+}
+
+// Sends a byte with MSB ordering
+static
+void serial_write_byte(uint8_t data) {
+  uint8_t b = 8;
+  serial_output();
+  while( b-- ) {
+    if(data & (1 << b)) {
+      serial_high();
+    } else {
+      serial_low();
+    }
+    serial_delay();
+  }
+}
+
+void transport_write(uint8_t data) {
+  serial_write_byte(data);
+  if (is_master) {
+    sync_recv();
+  } else {
+    sync_send();
+  }
+}
+
+bool transport_read(uint8_t *data) {
+  *data = serial_read_byte();
+  if (is_master) {
+    sync_recv();
+  } else {
+    sync_send();
+  }
+  return true;
+}
+
+void transport_turnaround(void) {
+  if (!is_master) {
+    // wait for the sync to finish sending
+    serial_delay();
+
+    // read the middle of pulses
+    _delay_us(SERIAL_DELAY/2);
+  }
+}
+
+void transport_idle(uint8_t bytes) {
+  serial_input();
+  if (is_master) {
+    // The slave can wait in its interrupt, the master has USB to serve
+    sei();
+  }
+  while (bytes--) {
+    _delay_us(SERIAL_BYTE_TIME);
+  }
+}
+
+// interrupt handle to be used by the slave device
+ISR(SERIAL_PIN_INTERRUPT) {
+  sync_send();
+  serial_slave_transaction();
+}
+
+bool transport_master_start(void) {
+  // this code is very time dependent, so we need to disable interrupts
+  cli();
+
+  // signal to the slave that we want to start a transaction
+  serial_output();
+  serial_low();
+  _delay_us(1);
+
+  // wait for the slaves response
+  serial_input();
+  serial_high();
+  _delay_us(SERIAL_DELAY);
+
+  // check if the slave is present
+  if (serial_read_pin()) {
+    // slave failed to pull the line low, assume not present
+    sei();
+    return false;
+  }
+
+  // if the slave is present syncronize with it
+  sync_recv();
+  return true;
+}
+
+void transport_master_end(void) {
+  // always, release the line when not in use
+  serial_output();
+  serial_high();
+
+  sei();
+}
+
+void transport_slave_end(void) {
+  serial_input(); // end transaction
+}
+
+#endif
@@ -0,0 +1,188 @@
+/*
+ * Split transport over the hardware USART1, in half duplex
+ *
+ * Connect TXD1 (D3) and RXD1 (D2) on both halves to the one data wire of
+ * the cable. Only one side drives the wire at a time: the transmitter is
+ * switched on just while sending, otherwise D3 is an input with pull-up.
+ * The receiver is switched off while sending, so nobody hears their own
+ * bytes.
+ *
+ * The master gets its bytes from the receive interrupt and waits for them
+ * with interrupts on, so USB keeps running during a transaction. The
+ * slave runs the whole transaction from its receive interrupt when the
+ * master's start byte arrives.
+ */
+
+#ifndef F_CPU
+#define F_CPU 16000000
+#endif
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/delay.h>
+#include <stdbool.h>
+#include "serial.h"
+#include "transport.h"
+
+#ifndef USE_I2C
+
+#ifndef SPLIT_USART_BAUD
+#   define SPLIT_USART_BAUD 250000
+#endif
+// Longest wait for a byte from the other side, in microseconds
+#ifndef SPLIT_USART_TIMEOUT
+#   define SPLIT_USART_TIMEOUT 500
+#endif
+
+// start byte of a transaction
+#define SPLIT_USART_START 0xA5
+
+// double speed mode
+#define SPLIT_USART_UBRR ((F_CPU / 8 + SPLIT_USART_BAUD / 2) / SPLIT_USART_BAUD - 1)
+
+// microseconds per byte with start and stop bit, rounded up
+#define SPLIT_USART_BYTE_TIME ((10000000UL + SPLIT_USART_BAUD - 1) / SPLIT_USART_BAUD)
+// The receiver has a byte half a bit before the sender is done with it.
+// Wait this long before answering so the other side is listening.
+#define SPLIT_USART_GUARD_TIME ((2000000UL + SPLIT_USART_BAUD - 1) / SPLIT_USART_BAUD)
+
+#define TXD1_MASK _BV(PD3)
+#define RXD1_MASK _BV(PD2)
+
+// the master's receive buffer, filled in the interrupt
+#define RX_BUFFER_SIZE 16
+#define RX_BUFFER_MASK (RX_BUFFER_SIZE - 1)
+static volatile uint8_t rx_buffer[RX_BUFFER_SIZE];
+static volatile uint8_t rx_head = 0;
+static uint8_t rx_tail = 0;
+
+static bool is_master = false;
+static bool sending = false;
+
+static
+void usart_transmit(void) {
+  UCSR1B = (UCSR1B & ~_BV(RXEN1)) | _BV(TXEN1);
+  sending = true;
+}
+
+static
+void usart_receive(void) {
+  // the transmitter only lets go of the pin once the last byte is out
+  if (sending) {
+    while (!(UCSR1A & _BV(TXC1)));
+  }
+  UCSR1B = (UCSR1B & ~_BV(TXEN1)) | _BV(RXEN1);
+  sending = false;
+  rx_tail = rx_head;
+}
+
+static
+void usart_init(void) {
+  DDRD  &= ~(TXD1_MASK | RXD1_MASK);
+  PORTD |=  (TXD1_MASK | RXD1_MASK);
+
+  UBRR1  = SPLIT_USART_UBRR;
+  UCSR1A = _BV(U2X1);
+  // 8N1
+  UCSR1C = _BV(UCSZ11) | _BV(UCSZ10);
+  UCSR1B = _BV(RXCIE1);
+  usart_receive();
+}
+
+void transport_master_init(void) {
+  is_master = true;
+  usart_init();
+}
+
+void transport_slave_init(void) {
+  usart_init();
+}
+
+void transport_write(uint8_t data) {
+  while (!(UCSR1A & _BV(UDRE1)));
+  // clear the transmit complete flag, set again after this byte
+  UCSR1A = _BV(U2X1) | _BV(TXC1);
+  UDR1 = data;
+}
+
+bool transport_read(uint8_t *data) {
+  uint16_t timeout = SPLIT_USART_TIMEOUT;
+  if (is_master) {
+    while (rx_tail == rx_head) {
+      if (!timeout--) {
+        return false;
+      }
+      _delay_us(1);
+    }
+    *data = rx_buffer[rx_tail++ & RX_BUFFER_MASK];
+  } else {
+    // in the receive interrupt already, wait for the flag
+    while (!(UCSR1A & _BV(RXC1))) {
+      if (!timeout--) {
+        return false;
+      }
+      _delay_us(1);
+    }
+    *data = UDR1;
+  }
+  return true;
+}
+
+void transport_turnaround(void) {
+  if (is_master) {
+    _delay_us(SPLIT_USART_GUARD_TIME);
+    usart_transmit();
+  } else {
+    usart_receive();
+  }
+}
+
+void transport_idle(uint8_t bytes) {
+  if (sending) {
+    usart_receive();
+  }
+  while (bytes--) {
+    _delay_us(SPLIT_USART_BYTE_TIME);
+  }
+  // drop whatever came in meanwhile
+  while (UCSR1A & _BV(RXC1)) {
+    (void)UDR1;
+  }
+  rx_tail = rx_head;
+}
+
+bool transport_master_start(void) {
+  usart_transmit();
+  transport_write(SPLIT_USART_START);
+  usart_receive();
+  return true;
+}
+
+void transport_master_end(void) {
+  if (sending) {
+    usart_receive();
+  }
+}
+
+void transport_slave_end(void) {
+  if (sending) {
+    usart_receive();
+  }
+}
+
+ISR(USART1_RX_vect) {
+  uint8_t data = UDR1;
+  if (is_master) {
+    uint8_t head = rx_head;
+    if ((uint8_t)(head - rx_tail) < RX_BUFFER_SIZE) {
+      rx_buffer[head & RX_BUFFER_MASK] = data;
+      rx_head = head + 1;
+    }
+  } else if (data == SPLIT_USART_START) {
+    _delay_us(SPLIT_USART_GUARD_TIME);
+    usart_transmit();
+    serial_slave_transaction();
+  }
+}
+
+#endif
@@ -0,0 +1,63 @@
+/*
+Copyright 2018 QMK Firmware contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gtest/gtest.h"
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+extern "C" {
+#include "color.h"
+}
+
+// Prints the throughput of the per pixel and the batch conversion
+TEST(ColorBench, SinglePixelAgainstBatch) {
+    const unsigned frames = 2000;
+    for (unsigned leds = 64; leds <= 512; leds *= 2) {
+        std::vector<HSV> hsv(leds);
+        std::vector<RGB> single(leds), batch(leds);
+        for (unsigned i = 0; i < leds; i++) {
+            hsv[i] = (HSV){ .h = (uint8_t)(i * 7), .s = (uint8_t)(255 - i), .v = (uint8_t)(i * 3 + 40) };
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned f = 0; f < frames; f++) {
+            hsv[f % leds].h++;
+            for (unsigned i = 0; i < leds; i++) {
+                single[i] = hsv_to_rgb(hsv[i]);
+            }
+        }
+        auto middle = std::chrono::steady_clock::now();
+        for (unsigned f = 0; f < frames; f++) {
+            hsv[f % leds].h--;
+            hsv_to_rgb_batch(hsv.data(), batch.data(), leds, true);
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        double single_ns = std::chrono::duration<double, std::nano>(middle - start).count() / (frames * leds);
+        double batch_ns = std::chrono::duration<double, std::nano>(end - middle).count() / (frames * leds);
+        printf("%3u LEDs: hsv_to_rgb %.2f ns/pixel, hsv_to_rgb_batch %.2f ns/pixel\n", leds, single_ns, batch_ns);
+
+        // Keeps the results alive, the unit tests check them properly
+        for (unsigned i = 0; i < leds; i++) {
+            RGB expected = hsv_to_rgb(hsv[i]);
+            EXPECT_EQ(expected.r, batch[i].r);
+            EXPECT_EQ(expected.g, batch[i].g);
+            EXPECT_EQ(expected.b, batch[i].b);
+        }
+    }
+}
@@ -0,0 +1,88 @@
+/*
+Copyright 2018 QMK Firmware contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gtest/gtest.h"
+#include <vector>
+
+extern "C" {
+#include "color.h"
+#include "led_tables.h"
+}
+
+// The division based conversion hsv_to_rgb() used before the hue table,
+// kept as an independent reference
+static RGB reference_hsv_to_rgb(HSV hsv) {
+    RGB rgb;
+    if (hsv.s == 0) {
+        rgb.r = rgb.g = rgb.b = hsv.v;
+        return rgb;
+    }
+
+    uint16_t h = hsv.h, s = hsv.s, v = hsv.v;
+    uint8_t region = h / 43;
+    uint16_t remainder = (h - (region * 43)) * 6;
+    uint8_t p = (v * (255 - s)) >> 8;
+    uint8_t q = (v * (255 - ((s * remainder) >> 8))) >> 8;
+    uint8_t t = (v * (255 - ((s * (255 - remainder)) >> 8))) >> 8;
+
+    switch (region) {
+        case 0:  rgb.r = v; rgb.g = t; rgb.b = p; break;
+        case 1:  rgb.r = q; rgb.g = v; rgb.b = p; break;
+        case 2:  rgb.r = p; rgb.g = v; rgb.b = t; break;
+        case 3:  rgb.r = p; rgb.g = q; rgb.b = v; break;
+        case 4:  rgb.r = t; rgb.g = p; rgb.b = v; break;
+        default: rgb.r = v; rgb.g = p; rgb.b = q; break;
+    }
+
+    rgb.r = CIE1931_CURVE[rgb.r];
+    rgb.g = CIE1931_CURVE[rgb.g];
+    rgb.b = CIE1931_CURVE[rgb.b];
+    return rgb;
+}
+
+TEST(Color, SinglePixelAndBatchMatchTheReferenceForEveryColor) {
+    std::vector<HSV> hsv(256);
+    std::vector<RGB> rgb(256);
+    for (unsigned s = 0; s < 256; s++) {
+        for (unsigned v = 0; v < 256; v++) {
+            for (unsigned h = 0; h < 256; h++) {
+                hsv[h] = (HSV){ .h = (uint8_t)h, .s = (uint8_t)s, .v = (uint8_t)v };
+            }
+            hsv_to_rgb_batch(hsv.data(), rgb.data(), 256, true);
+            for (unsigned h = 0; h < 256; h++) {
+                RGB expected = reference_hsv_to_rgb(hsv[h]);
+                RGB single = hsv_to_rgb(hsv[h]);
+                ASSERT_EQ(expected.r, single.r) << "h=" << h << " s=" << s << " v=" << v;
+                ASSERT_EQ(expected.g, single.g) << "h=" << h << " s=" << s << " v=" << v;
+                ASSERT_EQ(expected.b, single.b) << "h=" << h << " s=" << s << " v=" << v;
+                ASSERT_EQ(expected.r, rgb[h].r) << "h=" << h << " s=" << s << " v=" << v;
+                ASSERT_EQ(expected.g, rgb[h].g) << "h=" << h << " s=" << s << " v=" << v;
+                ASSERT_EQ(expected.b, rgb[h].b) << "h=" << h << " s=" << s << " v=" << v;
+            }
+        }
+    }
+}
+
+TEST(Color, BatchWithoutCieCorrectionKeepsLinearValues) {
+    HSV hsv[] = { { 0, 255, 255 }, { 86, 255, 128 }, { 172, 255, 64 }, { 10, 0, 77 } };
+    RGB rgb[4];
+    hsv_to_rgb_batch(hsv, rgb, 4, false);
+    EXPECT_EQ(rgb[0].r, 255); EXPECT_EQ(rgb[0].g, 0);   EXPECT_EQ(rgb[0].b, 0);
+    EXPECT_EQ(rgb[1].r, 0);   EXPECT_EQ(rgb[1].g, 128); EXPECT_EQ(rgb[1].b, 0);
+    EXPECT_EQ(rgb[2].r, 0);   EXPECT_EQ(rgb[2].g, 0);   EXPECT_EQ(rgb[2].b, 64);
+    EXPECT_EQ(rgb[3].r, 77);  EXPECT_EQ(rgb[3].g, 77);  EXPECT_EQ(rgb[3].b, 77);
+}
@@ -0,0 +1,90 @@
+/*
+Copyright 2018 QMK Firmware contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gtest/gtest.h"
+#include <vector>
+
+extern "C" {
+#include "debounce.h"
+void set_time(uint32_t t);
+void advance_time(uint32_t ms);
+}
+
+/* Built once for every DEBOUNCE_TYPE, see rules.mk. Each scan is 1 ms and
+ * only key 0 of row 0 is used. */
+class Debounce : public testing::Test {
+protected:
+    Debounce() {
+        set_time(0);
+        debounce_init(MATRIX_ROWS);
+    }
+
+    // Scans each raw state in turn, returns the debounced key after each
+    std::vector<int> scan(std::vector<int> states) {
+        std::vector<int> result;
+        for (int state : states) {
+            matrix_row_t row = state ? 1 : 0;
+            bool changed = raw[0] != row;
+            raw[0] = row;
+            advance_time(1);
+            debounce(raw, cooked, MATRIX_ROWS, changed);
+            result.push_back(cooked[0] & 1);
+        }
+        return result;
+    }
+
+    matrix_row_t raw[MATRIX_ROWS] = {0};
+    matrix_row_t cooked[MATRIX_ROWS] = {0};
+};
+
+#if defined(DEBOUNCE_TEST_SYM_G)
+
+TEST_F(Debounce, PressIsReportedOnceTheMatrixSettles) {
+    EXPECT_EQ(scan({1, 0, 1, 1, 1, 1, 1, 1, 1}),
+              std::vector<int>({0, 0, 0, 0, 0, 0, 0, 0, 1}));
+}
+
+TEST_F(Debounce, BounceShorterThanDebounceIsNoPress) {
+    EXPECT_EQ(scan({1, 0, 0, 0, 0, 0, 0, 0}),
+              std::vector<int>({0, 0, 0, 0, 0, 0, 0, 0}));
+}
+
+#elif defined(DEBOUNCE_TEST_EAGER)
+
+TEST_F(Debounce, PressIsReportedAtOnceAndBouncesAreIgnored) {
+    EXPECT_EQ(scan({1, 0, 1, 0, 1, 1, 1, 1}),
+              std::vector<int>({1, 1, 1, 1, 1, 1, 1, 1}));
+}
+
+TEST_F(Debounce, ReleaseAfterTheLockIsReportedAtOnce) {
+    EXPECT_EQ(scan({1, 1, 1, 1, 1, 1, 0, 1, 0, 0, 0, 0, 0}),
+              std::vector<int>({1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0}));
+}
+
+#elif defined(DEBOUNCE_TEST_ASYM_EAGER_DEFER)
+
+TEST_F(Debounce, PressIsReportedAtOnce) {
+    EXPECT_EQ(scan({1, 0, 1, 1}),
+              std::vector<int>({1, 1, 1, 1}));
+}
+
+TEST_F(Debounce, ReleaseWaitsUntilTheKeyStaysUp) {
+    EXPECT_EQ(scan({1, 1, 0, 1, 0, 0, 0, 0, 0, 0, 0}),
+              std::vector<int>({1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0}));
+}
+
+#endif
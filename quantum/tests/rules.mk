@@ -0,0 +1,44 @@
+quantum_color_SRC :=\
+	$(QUANTUM_PATH)/tests/color_tests.cpp \
+	$(QUANTUM_PATH)/color.c \
+	$(QUANTUM_PATH)/led_tables.c
+
+quantum_color_DEFS := -DUSE_CIE1931_CURVE
+
+quantum_color_bench_SRC :=\
+	$(QUANTUM_PATH)/tests/color_bench.cpp \
+	$(QUANTUM_PATH)/color.c \
+	$(QUANTUM_PATH)/led_tables.c
+
+quantum_color_bench_DEFS := -DUSE_CIE1931_CURVE
+
+# The debounce tests are built once for each DEBOUNCE_TYPE
+DEBOUNCE_TEST_DEFS := -DMATRIX_ROWS=2 -DMATRIX_COLS=8 -DDEBOUNCE=5
+
+debounce_sym_g_SRC :=\
+	$(QUANTUM_PATH)/tests/debounce_tests.cpp \
+	$(QUANTUM_PATH)/debounce/sym_g.c \
+	$(TMK_PATH)/common/test/timer.c
+
+debounce_sym_g_DEFS := $(DEBOUNCE_TEST_DEFS) -DDEBOUNCE_TEST_SYM_G
+
+debounce_eager_pk_SRC :=\
+	$(QUANTUM_PATH)/tests/debounce_tests.cpp \
+	$(QUANTUM_PATH)/debounce/eager_pk.c \
+	$(TMK_PATH)/common/test/timer.c
+
+debounce_eager_pk_DEFS := $(DEBOUNCE_TEST_DEFS) -DDEBOUNCE_TEST_EAGER
+
+debounce_eager_pr_SRC :=\
+	$(QUANTUM_PATH)/tests/debounce_tests.cpp \
+	$(QUANTUM_PATH)/debounce/eager_pr.c \
+	$(TMK_PATH)/common/test/timer.c
+
+debounce_eager_pr_DEFS := $(DEBOUNCE_TEST_DEFS) -DDEBOUNCE_TEST_EAGER
+
+debounce_asym_eager_defer_pk_SRC :=\
+	$(QUANTUM_PATH)/tests/debounce_tests.cpp \
+	$(QUANTUM_PATH)/debounce/asym_eager_defer_pk.c \
+	$(TMK_PATH)/common/test/timer.c
+
+debounce_asym_eager_defer_pk_DEFS := $(DEBOUNCE_TEST_DEFS) -DDEBOUNCE_TEST_ASYM_EAGER_DEFER
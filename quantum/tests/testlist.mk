@@ -0,0 +1,9 @@
+TEST_LIST +=\
+	quantum_color \
+	debounce_sym_g \
+	debounce_eager_pk \
+	debounce_eager_pr \
+	debounce_asym_eager_defer_pk
+
+BENCH_LIST +=\
+	quantum_color_bench
@@ -20,4 +20,6 @@
 #define MATRIX_ROWS 4
 #define MATRIX_COLS 10
 
+#define COMBO_COUNT 2
+
 #endif /* TESTS_BASIC_CONFIG_H_ */
@@ -26,11 +26,27 @@ const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
         // 0    1      2      3        4        5        6       7            8      9
         {KC_A,  KC_B,  KC_NO, KC_LSFT, KC_RSFT, KC_LCTL, COMBO1, SFT_T(KC_P), M(0),  KC_NO},
         {KC_NO, KC_NO, KC_NO, KC_NO,   KC_NO,   KC_NO,   KC_NO,  KC_NO,       KC_NO, KC_NO},
-        {KC_NO, KC_NO, KC_NO, KC_NO,   KC_NO,   KC_NO,   KC_NO,  KC_NO,       KC_NO, KC_NO},
-        {KC_C,  KC_D,  KC_NO, KC_NO,   KC_NO,   KC_NO,   KC_NO,  KC_NO,       KC_NO, KC_NO},
+        {LT(1, KC_F), KC_G, KC_H, KC_I, KC_J,   KC_K,    KC_L,   KC_M,        KC_N,  KC_O},
+        {KC_C,  KC_D,  KC_X,  KC_Y,    KC_V,    KC_W,    KC_NO,  KC_NO,       KC_NO, KC_NO},
+    },
+    [1] = {
+        // 0     1        2        3        4        5        6        7        8        9
+        {KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS},
+        {KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS},
+        {KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS},
+        {KC_TRNS, KC_E,    KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS, KC_TRNS},
     },
 };
 
+// Declared out of keycode order, so the combo index has to sort them
+const uint16_t PROGMEM xy_combo[] = {KC_X, KC_Y, COMBO_END};
+const uint16_t PROGMEM vw_combo[] = {KC_V, KC_W, COMBO_END};
+
+combo_t key_combos[COMBO_COUNT] = {
+    COMBO(xy_combo, KC_ESC),
+    COMBO(vw_combo, KC_TAB),
+};
+
 const macro_t *action_get_macro(keyrecord_t *record, uint8_t id, uint8_t opt) {
     if (record->event.pressed) {
         switch(id) {
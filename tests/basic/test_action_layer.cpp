@@ -90,3 +90,32 @@ TEST_F(ActionLayer, LayerStateCmp) {
 //     layer_off(2);
 //     EXPECT_EQ(layer_state, 0b1000);
 // }
+
+TEST_F(ActionLayer, ResolvedLayerFollowsLayerChanges) {
+    TestDriver driver;
+    keypos_t overridden = { .col = 1, .row = 3 };
+    keypos_t transparent = { .col = 0, .row = 3 };
+
+    // Resolve once so the layer cache holds entries for layer 0
+    EXPECT_EQ(layer_switch_get_layer(overridden), 0);
+    EXPECT_EQ(layer_switch_get_layer(transparent), 0);
+
+    layer_on(1);
+    EXPECT_EQ(layer_switch_get_layer(overridden), 1);
+    EXPECT_EQ(layer_switch_get_layer(transparent), 0);
+
+    // Writing the state directly must not leave stale entries behind either
+    layer_state = 0;
+    EXPECT_EQ(layer_switch_get_layer(overridden), 0);
+
+    default_layer_set(1UL << 1);
+    EXPECT_EQ(layer_switch_get_layer(overridden), 1);
+    default_layer_set(1UL << 0);
+
+    press_key(1, 3);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_D)));
+    run_one_scan_loop();
+    release_key(1, 3);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
@@ -0,0 +1,114 @@
+/* Copyright 2018 QMK Firmware contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+#include "action_tapping.h"
+
+extern "C" {
+#include "keyevent_queue.h"
+    void advance_time(uint32_t ms);
+}
+
+using testing::_;
+
+// Row 1 is all KC_NO, so the chord reaches process_record without sending reports
+#define CHORD_ROW 1
+#define CHORD_SIZE 10
+
+static bool recording = false;
+static uint8_t delivered = 0;
+static uint16_t last_event_time = 0;
+static uint16_t last_delivery_time = 0;
+
+extern "C" bool process_record_user(uint16_t keycode, keyrecord_t *record) {
+    if (recording && record->event.pressed) {
+        delivered++;
+        last_event_time = record->event.time;
+        // Stamped the same way as scanned events, which are never 0
+        last_delivery_time = timer_read() | 1;
+    }
+    return true;
+}
+
+class ChordLatency : public TestFixture {
+protected:
+    void press_chord() {
+        for (uint8_t c = 0; c < CHORD_SIZE; c++) {
+            press_key(c, CHORD_ROW);
+        }
+        delivered = 0;
+        recording = true;
+    }
+
+    ~ChordLatency() {
+        recording = false;
+    }
+
+    // Runs scan loops until the whole chord has been delivered, dispatching
+    // at most max events per loop. Returns the number of loops needed.
+    unsigned deliver_chord(uint8_t max) {
+        unsigned loops = 0;
+        while (delivered < CHORD_SIZE && loops < 100) {
+            matrix_scan();
+            keyboard_collect_events();
+            keyboard_dispatch_events(max);
+            advance_time(1);
+            loops++;
+        }
+        return loops;
+    }
+};
+
+TEST_F(ChordLatency, WholeChordIsDeliveredInTheScanThatFoundIt) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    press_chord();
+    uint16_t scan_time = timer_read() | 1;
+    run_one_scan_loop();
+    EXPECT_EQ(delivered, CHORD_SIZE);
+    EXPECT_EQ(last_event_time, scan_time);
+}
+
+TEST_F(ChordLatency, LastChordKeyLatencyComparedWithOneKeyPerScan) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+
+    // One key per task call reproduces the dispatch schedule of the old scan loop
+    press_chord();
+    uint16_t scan_time = timer_read() | 1;
+    unsigned one_per_scan_loops = deliver_chord(1);
+    uint16_t one_per_scan_lag = last_delivery_time - last_event_time;
+    EXPECT_EQ(one_per_scan_loops, (unsigned)CHORD_SIZE);
+    // The last key waited one loop, 1 ms here, for each key before it, plus
+    // up to 1 ms from stamping the times with | 1
+    EXPECT_GE(one_per_scan_lag, CHORD_SIZE - 1);
+    EXPECT_LE(one_per_scan_lag, CHORD_SIZE);
+    // The scan time travels with the event even when it is dispatched late
+    EXPECT_EQ(last_event_time, scan_time);
+    for (uint8_t c = 0; c < CHORD_SIZE; c++) {
+        release_key(c, CHORD_ROW);
+    }
+    recording = false;
+    idle_for(TAPPING_TERM + 1);
+
+    press_chord();
+    unsigned queued_loops = deliver_chord(KEYEVENT_QUEUE_SIZE);
+    uint16_t queued_lag = last_delivery_time - last_event_time;
+    EXPECT_EQ(queued_loops, 1u);
+    EXPECT_EQ(queued_lag, 0);
+    EXPECT_LT(queued_lag, one_per_scan_lag);
+}
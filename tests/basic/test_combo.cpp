@@ -0,0 +1,95 @@
+/* Copyright 2017 Fred Sundvik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+using testing::_;
+using testing::InSequence;
+
+class Combo : public TestFixture {};
+
+TEST_F(Combo, BothKeysPressedSendTheComboKeycode) {
+    TestDriver driver;
+    InSequence s;
+
+    press_key(2, 3);
+    // The first key is held back until the combo completes or times out
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    run_one_scan_loop();
+    press_key(3, 3);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_ESC)));
+    run_one_scan_loop();
+    release_key(2, 3);
+    release_key(3, 3);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(Combo, ALaterComboIsFoundByItsKeys) {
+    TestDriver driver;
+    InSequence s;
+
+    press_key(4, 3);
+    press_key(5, 3);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_TAB)));
+    run_one_scan_loop();
+    release_key(4, 3);
+    release_key(5, 3);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(Combo, AComboKeyTappedAloneSendsItsOwnKey) {
+    TestDriver driver;
+    InSequence s;
+
+    press_key(2, 3);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    run_one_scan_loop();
+    release_key(2, 3);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_X)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(Combo, AComboKeyHeldPastTheTermSendsItsOwnKey) {
+    TestDriver driver;
+    InSequence s;
+
+    press_key(3, 3);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    run_one_scan_loop();
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_Y)));
+    idle_for(COMBO_TERM + 1);
+    release_key(3, 3);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(Combo, AnInvalidatedIndexIsRebuiltByTheScan) {
+    TestDriver driver;
+    InSequence s;
+
+    combo_index_invalidate();
+    press_key(4, 3);
+    press_key(5, 3);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_TAB)));
+    run_one_scan_loop();
+    release_key(4, 3);
+    release_key(5, 3);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
@@ -0,0 +1,69 @@
+/* Copyright 2018 QMK Firmware contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "test_common.hpp"
+
+extern "C" {
+#include "keymap_actions.h"
+}
+
+// The generated table has to agree with the runtime conversion for every
+// keycode it stores, and leave everything else to the runtime conversion
+class KeymapActions : public TestFixture {
+protected:
+    ~KeymapActions() {
+        keymap_config.raw = 0;
+    }
+};
+
+TEST_F(KeymapActions, StaticActionMatchesRuntimeConversionForEveryKeycode) {
+    keymap_config.raw = 0;
+    unsigned dynamic = 0;
+    for (uint32_t kc = 0; kc <= 0xFFFF; kc++) {
+        uint16_t code = KEYMAP_STATIC_ACTION(kc);
+        if (code == KEYMAP_ACTION_DYNAMIC) {
+            dynamic++;
+            continue;
+        }
+        ASSERT_EQ(code, action_for_keycode(kc).code) << "keycode 0x" << std::hex << kc;
+    }
+    // Mostly QK_FUNCTION and mod taps on alt or gui, which mod_config() can swap
+    EXPECT_LT(dynamic, 0x3000u);
+}
+
+TEST_F(KeymapActions, TableCoversEveryLayerOfTheKeymap) {
+    keymap_config.raw = 0;
+    EXPECT_EQ(keymap_actions_layers, 2);
+    for (uint8_t layer = 0; layer < keymap_actions_layers; layer++) {
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                keypos_t key = { .col = col, .row = row };
+                uint16_t keycode = keymap_key_to_keycode(layer, key);
+                EXPECT_EQ(action_for_key(layer, key).code, action_for_keycode(keycode).code)
+                    << "layer " << (int)layer << " row " << (int)row << " col " << (int)col;
+            }
+        }
+    }
+}
+
+TEST_F(KeymapActions, RemappedKeysStillFollowMagicSettings) {
+    keypos_t lctl = { .col = 5, .row = 0 };
+    keymap_config.raw = 0;
+    EXPECT_EQ(action_for_key(0, lctl).code, ACTION_KEY(KC_LCTL));
+    keymap_config.swap_control_capslock = true;
+    EXPECT_EQ(action_for_key(0, lctl).code, ACTION_KEY(KC_CAPSLOCK));
+}
@@ -0,0 +1,168 @@
+/* Copyright 2018 QMK Firmware contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+using testing::_;
+using testing::InSequence;
+using testing::InvokeWithoutArgs;
+
+class SendString : public TestFixture {};
+
+#define AT_TIME(t) WillOnce(InvokeWithoutArgs([current_time]() {EXPECT_EQ(timer_elapsed32(current_time), t);}))
+
+TEST_F(SendString, DoesNotTypeUntilTheScanLoopRuns) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    send_string("abc");
+    EXPECT_TRUE(send_string_pending());
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(4);
+    idle_for(100);
+    EXPECT_FALSE(send_string_pending());
+}
+
+TEST_F(SendString, MergesShiftAndReleases) {
+    TestDriver driver;
+    InSequence s;
+    uint32_t current_time = timer_read32();
+    // The old implementation sent 14 reports for this
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_A)))
+        .AT_TIME(0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_B)))
+        .AT_TIME(10);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()))
+        .AT_TIME(20);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_C)))
+        .AT_TIME(30);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()))
+        .AT_TIME(40);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_C)))
+        .AT_TIME(50);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_D)))
+        .AT_TIME(60);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()))
+        .AT_TIME(70);
+    SEND_STRING("ABccd");
+    idle_for(100);
+}
+
+TEST_F(SendString, DelayReleasesEveryKey) {
+    TestDriver driver;
+    InSequence s;
+    uint32_t current_time = timer_read32();
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)))
+        .AT_TIME(0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()))
+        .AT_TIME(10);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)))
+        .AT_TIME(70);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()))
+        .AT_TIME(80);
+    send_string_with_delay_P(PSTR("ab"), 50);
+    idle_for(200);
+}
+
+TEST_F(SendString, ModifierCodesGoThroughTheKeyboardReport) {
+    TestDriver driver;
+    InSequence s;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LCTL)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LCTL, KC_C)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LCTL)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_ENTER)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    SEND_STRING(SS_LCTRL("c") SS_TAP(X_ENTER));
+    idle_for(100);
+}
+
+TEST_F(SendString, CopiesStringsInRam) {
+    TestDriver driver;
+    InSequence s;
+    char str[] = "ab";
+    send_string(str);
+    str[0] = 'x';
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    idle_for(100);
+}
+
+TEST_F(SendString, QueuedStringsKeepTheirOrder) {
+    TestDriver driver;
+    InSequence s;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_C)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    send_string("ab");
+    SEND_STRING("c");
+    idle_for(100);
+}
+
+TEST_F(SendString, RegisterCodeWaitsForTheString) {
+    TestDriver driver;
+    InSequence s;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_ENTER)));
+    SEND_STRING("ab");
+    register_code(KC_ENTER);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    unregister_code(KC_ENTER);
+}
+
+TEST_F(SendString, ShiftedKeycodeWaitsForTheString) {
+    TestDriver driver;
+    InSequence s;
+    // The shift of the keycode must not reach the string
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_B)));
+    SEND_STRING("a");
+    register_code16(S(KC_B));
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    unregister_code16(S(KC_B));
+}
+
+TEST_F(SendString, KeyPressIsQueuedBehindTheString) {
+    TestDriver driver;
+    InSequence s;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_C)));
+    SEND_STRING("c");
+    press_key(0, 0);
+    run_one_scan_loop();
+    // The scan loop goes on, the key press waits for the string
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    idle_for(20);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    release_key(0, 0);
+    run_one_scan_loop();
+}
@@ -0,0 +1,150 @@
+/* Copyright 2018 QMK Firmware contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+#include "action_tapping.h"
+
+using testing::_;
+using testing::InSequence;
+
+#define SFT_T_COL 7
+#define SHORT_TERM 50
+
+static bool override_config = false;
+static tapping_config_t sft_t_config;
+
+extern "C" tapping_config_t get_tapping_config(keyrecord_t *record) {
+    if (override_config && record->event.key.row == 0 && record->event.key.col == SFT_T_COL) {
+        return sft_t_config;
+    }
+    return get_tapping_config_default(record);
+}
+
+class TappingConfig : public TestFixture {
+protected:
+    void use_config(uint16_t term, uint8_t strategy) {
+        sft_t_config = (tapping_config_t){ .term = term, .strategy = strategy };
+        override_config = true;
+    }
+
+    ~TappingConfig() {
+        override_config = false;
+    }
+};
+
+TEST_F(TappingConfig, DefaultConfigComesFromTheKindOfKey) {
+    keyrecord_t record = {};
+    record.event.key = (keypos_t){ .col = SFT_T_COL, .row = 0 };
+    tapping_config_t config = get_tapping_config_default(&record);
+    EXPECT_EQ(config.term, TAPPING_TERM_MOD_TAP);
+    EXPECT_EQ(config.strategy, TAPPING_STRATEGY_MOD_TAP);
+}
+
+TEST_F(TappingConfig, KeyWithShortTermIsHeldEarly) {
+    TestDriver driver;
+    InSequence s;
+    use_config(SHORT_TERM, 0);
+
+    press_key(SFT_T_COL, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    idle_for(SHORT_TERM);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    run_one_scan_loop();
+    release_key(SFT_T_COL, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(TappingConfig, KeyWithShortTermCanStillBeTapped) {
+    TestDriver driver;
+    InSequence s;
+    use_config(SHORT_TERM, 0);
+
+    press_key(SFT_T_COL, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    idle_for(SHORT_TERM - 1);
+    release_key(SFT_T_COL, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_P)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(TappingConfig, HoldOnOtherKeyPressSettlesOnThePress) {
+    TestDriver driver;
+    InSequence s;
+    use_config(TAPPING_TERM, TAPPING_HOLD_ON_OTHER_KEY_PRESS);
+
+    press_key(SFT_T_COL, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    run_one_scan_loop();
+    press_key(0, 0);
+    // No need to wait for the term or for the other key to be released
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_A)));
+    run_one_scan_loop();
+    release_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    run_one_scan_loop();
+    release_key(SFT_T_COL, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(TappingConfig, PermissiveHoldSettlesWhenTheOtherKeyIsReleased) {
+    TestDriver driver;
+    InSequence s;
+    use_config(TAPPING_TERM, TAPPING_PERMISSIVE_HOLD);
+
+    press_key(SFT_T_COL, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    run_one_scan_loop();
+    press_key(0, 0);
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+    release_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    run_one_scan_loop();
+    release_key(SFT_T_COL, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(TappingConfig, WithoutAStrategyARollWaitsForTheTerm) {
+    TestDriver driver;
+    InSequence s;
+    use_config(TAPPING_TERM, 0);
+
+    press_key(SFT_T_COL, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    run_one_scan_loop();
+    press_key(0, 0);
+    run_one_scan_loop();
+    release_key(0, 0);
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+    // The interrupted mod tap ends up as shift when it is released...
+    release_key(SFT_T_COL, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+    // ...but the rolled key is held back until the term runs out
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    idle_for(TAPPING_TERM);
+}
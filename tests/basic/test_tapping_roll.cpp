@@ -0,0 +1,100 @@
+/* Copyright 2018 QMK Firmware contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+#include <vector>
+
+#include "action_tapping.h"
+
+using testing::_;
+using testing::AnyNumber;
+using testing::Invoke;
+
+#define ROLL_ROW 2
+#define LAYER_TAP_COL 0
+#define ROLL_KEYS 20
+#define ROLL_STEP 20
+
+// The row next to the layer tap key, layer 1 is transparent there
+static const uint8_t roll_keycodes[] = { KC_G, KC_H, KC_I, KC_J, KC_K, KC_L, KC_M, KC_N, KC_O };
+#define ROLL_COLS (sizeof(roll_keycodes) / sizeof(roll_keycodes[0]))
+
+class TappingRoll : public TestFixture {
+protected:
+    std::vector<report_keyboard_t> reports;
+
+    TappingRoll() {
+        action_tapping_clear_stats();
+    }
+
+    void record_reports(TestDriver &driver) {
+        EXPECT_CALL(driver, send_keyboard_mock(_))
+            .Times(AnyNumber())
+            .WillRepeatedly(Invoke([this](report_keyboard_t &report) { reports.push_back(report); }));
+    }
+
+    // Number of times keycode went from released to pressed over the reports
+    unsigned presses_of(uint8_t keycode) {
+        unsigned presses = 0;
+        bool was_pressed = false;
+        for (auto &report : reports) {
+            bool pressed = false;
+            for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
+                pressed |= report.keys[i] == keycode;
+            }
+            presses += pressed && !was_pressed;
+            was_pressed = pressed;
+        }
+        return presses;
+    }
+};
+
+TEST_F(TappingRoll, RollOverLayerTapLosesNoKeys) {
+    TestDriver driver;
+    record_reports(driver);
+
+    // Each key goes down ROLL_STEP ms after the previous one and comes up
+    // after the next one went down. About 20 events arrive while the layer
+    // tap is undecided, more than the waiting buffer holds, so the rest has
+    // to wait in the event queue.
+    press_key(LAYER_TAP_COL, ROLL_ROW);
+    run_one_scan_loop();
+    for (uint8_t k = 0; k < ROLL_KEYS; k++) {
+        press_key(1 + k % ROLL_COLS, ROLL_ROW);
+        idle_for(ROLL_STEP / 2);
+        if (k > 0) {
+            release_key(1 + (k - 1) % ROLL_COLS, ROLL_ROW);
+        }
+        idle_for(ROLL_STEP / 2);
+    }
+    release_key(1 + (ROLL_KEYS - 1) % ROLL_COLS, ROLL_ROW);
+    idle_for(TAPPING_TERM);
+    release_key(LAYER_TAP_COL, ROLL_ROW);
+    idle_for(TAPPING_TERM);
+
+    for (uint8_t c = 0; c < ROLL_COLS; c++) {
+        unsigned strokes = ROLL_KEYS / ROLL_COLS + (c < ROLL_KEYS % ROLL_COLS ? 1 : 0);
+        EXPECT_EQ(presses_of(roll_keycodes[c]), strokes) << "key " << (int)c;
+    }
+    ASSERT_FALSE(reports.empty());
+    report_keyboard_t empty = {};
+    EXPECT_TRUE(reports.back() == empty);
+
+    waiting_buffer_stats_t stats = action_tapping_get_stats();
+    // The roll did not fit, but nothing was dropped
+    EXPECT_EQ(stats.high_water, WAITING_BUFFER_SIZE);
+    EXPECT_EQ(stats.overflows, 0);
+}
@@ -0,0 +1,120 @@
+/* Copyright 2018 QMK Firmware contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+using testing::_;
+using testing::AnyNumber;
+using testing::InSequence;
+
+extern "C" {
+    uint8_t dynamic_macro_encode_delay(uint16_t ms);
+    uint16_t dynamic_macro_decode_delay(uint8_t delay);
+}
+
+class DynamicMacro : public TestFixture {
+protected:
+    void tap_key(uint8_t col, uint8_t row) {
+        press_key(col, row);
+        run_one_scan_loop();
+        release_key(col, row);
+        run_one_scan_loop();
+    }
+
+    void record(std::initializer_list<uint8_t> cols) {
+        TestDriver driver;
+        EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+        tap_key(0, 1);
+        for (uint8_t col : cols) {
+            tap_key(col, 0);
+        }
+        tap_key(1, 1);
+        idle_for(10);
+    }
+
+    void play() {
+        press_key(2, 1);
+        run_one_scan_loop();
+        release_key(2, 1);
+        run_one_scan_loop();
+    }
+};
+
+TEST_F(DynamicMacro, ReplaysOneEventPerScan) {
+    record({0, 1});
+
+    TestDriver driver;
+    InSequence s;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    play();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    idle_for(10);
+}
+
+TEST_F(DynamicMacro, KeyPressCancelsPlayback) {
+    record({0, 1, 2});
+
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    play();
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    // Neither the rest of the macro nor the shift goes out
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AnyNumber());
+    press_key(3, 1);
+    idle_for(10);
+    release_key(3, 1);
+    idle_for(10);
+}
+
+TEST_F(DynamicMacro, LayerReleasedDuringPlaybackStaysOff) {
+    record({0, 1, 2});
+
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    press_key(3, 0);
+    run_one_scan_loop();
+    tap_key(2, 0);
+    release_key(3, 0);
+    run_one_scan_loop();
+    EXPECT_EQ(layer_state, 0u);
+    idle_for(10);
+    EXPECT_EQ(layer_state, 0u);
+}
+
+TEST_F(DynamicMacro, DelayEncoding) {
+    for (uint16_t ms = 0; ms < 128; ms++) {
+        EXPECT_EQ(dynamic_macro_decode_delay(dynamic_macro_encode_delay(ms)), ms);
+    }
+    EXPECT_EQ(dynamic_macro_decode_delay(dynamic_macro_encode_delay(1000)), 992);
+    EXPECT_EQ(dynamic_macro_decode_delay(dynamic_macro_encode_delay(60000)), 2160);
+}
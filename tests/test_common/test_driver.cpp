@@ -55,3 +55,7 @@ void TestDriver::send_system(uint16_t data) {
 void TestDriver::send_consumer(uint16_t data) {
     m_this->send_consumer(data);
 }
+
+extern "C" bool host_keyboard_busy(void) {
+    return TestDriver::is_busy();
+}
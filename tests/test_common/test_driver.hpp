@@ -28,6 +28,8 @@ public:
     TestDriver();
     ~TestDriver();
     void set_leds(uint8_t leds) { m_leds = leds; }
+    void set_busy(bool busy) { m_busy = busy; }
+    static bool is_busy(void) { return m_this && m_this->m_busy; }
     
     MOCK_METHOD1(send_keyboard_mock, void (report_keyboard_t&));
     MOCK_METHOD1(send_mouse_mock, void (report_mouse_t&));
@@ -41,6 +43,7 @@ private:
     static void send_consumer(uint16_t data);
     host_driver_t m_driver;
     uint8_t m_leds = 0;
+    bool m_busy = false;
     static TestDriver* m_this;
 };
 
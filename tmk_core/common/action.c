@@ -27,6 +27,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "action_util.h"
 #include "action.h"
 #include "wait.h"
+#include "pipeline_trace.h"
 
 #ifdef DEBUG_ACTION
 #include "debug.h"
@@ -56,6 +57,7 @@ void action_exec(keyevent_t event)
 #ifdef RETRO_TAPPING
         retro_tapping_counter++;
 #endif
+        PIPELINE_TRACE_BEGIN(PIPELINE_TRACE_ACTION_EXEC);
     }
 
 #ifdef FAUXCLICKY_ENABLE
@@ -93,6 +95,10 @@ void action_exec(keyevent_t event)
         dprint("processed: "); debug_record(record); dprintln();
     }
 #endif
+
+    if (!IS_NOEVENT(event)) {
+        PIPELINE_TRACE_END(PIPELINE_TRACE_ACTION_EXEC);
+    }
 }
 
 #ifdef SWAP_HANDS_ENABLE
@@ -141,6 +147,19 @@ bool process_record_quantum(keyrecord_t *record) {
     return true;
 }
 
+__attribute__ ((weak))
+void action_flush_output(void) {
+}
+
+__attribute__ ((weak))
+bool action_output_pending(void) {
+    return false;
+}
+
+__attribute__ ((weak))
+void action_output_task(void) {
+}
+
 #ifndef NO_ACTION_TAPPING
 /** \brief Allows for handling tap-hold actions immediately instead of waiting for TAPPING_TERM or another keypress.
  *
@@ -173,18 +192,19 @@ void process_record(keyrecord_t *record)
 {
     if (IS_NOEVENT(record->event)) { return; }
 
-    if(!process_record_quantum(record))
-        return;
-
-    action_t action = store_or_get_action(record->event.pressed, record->event.key);
-    dprint("ACTION: "); debug_action(action);
+    PIPELINE_TRACE_BEGIN(PIPELINE_TRACE_PROCESS_RECORD);
+    if (process_record_quantum(record)) {
+        action_t action = store_or_get_action(record->event.pressed, record->event.key);
+        dprint("ACTION: "); debug_action(action);
 #ifndef NO_ACTION_LAYER
-    dprint(" layer_state: "); layer_debug();
-    dprint(" default_layer_state: "); default_layer_debug();
+        dprint(" layer_state: "); layer_debug();
+        dprint(" default_layer_state: "); default_layer_debug();
 #endif
-    dprintln();
+        dprintln();
 
-    process_action(record, action);
+        process_action(record, action);
+    }
+    PIPELINE_TRACE_END(PIPELINE_TRACE_PROCESS_RECORD);
 }
 
 /** \brief Take an action and processes it.
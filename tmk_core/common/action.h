@@ -61,6 +61,14 @@ void action_function(keyrecord_t *record, uint8_t id, uint8_t opt);
 /* keyboard-specific key event (pre)processing */
 bool process_record_quantum(keyrecord_t *record);
 
+/* called before the keys or mods of the keyboard report change, so output
+ * that is still being streamed goes out first */
+void action_flush_output(void);
+/* true while output is still being streamed, key events wait for it */
+bool action_output_pending(void);
+/* streams queued output, called from keyboard_task() */
+void action_output_task(void);
+
 /* Utilities for actions.  */
 #if !defined(NO_ACTION_LAYER) && !defined(STRICT_LAYER_RELEASE)
 extern bool disable_action_cache;
@@ -44,6 +44,7 @@ static void default_layer_state_set(uint32_t state)
     default_layer_debug(); debug(" to ");
     default_layer_state = state;
     default_layer_debug(); debug("\n");
+    layer_cache_invalidate();
     clear_keyboard_but_mods(); // To avoid stuck keys
 }
 
@@ -127,6 +128,7 @@ void layer_state_set(uint32_t state)
     layer_debug(); dprint(" to ");
     layer_state = state;
     layer_debug(); dprintln();
+    layer_cache_invalidate();
     clear_keyboard_but_mods(); // To avoid stuck keys
 }
 
@@ -263,6 +265,79 @@ uint8_t read_source_layers_cache(keypos_t key)
 }
 #endif
 
+#ifdef LAYER_CACHE_ENABLE
+#define LAYER_CACHE_EMPTY 0xFF
+
+#ifdef LAYER_CACHE_SIZE
+#if (LAYER_CACHE_SIZE & (LAYER_CACHE_SIZE - 1)) != 0
+#error "LAYER_CACHE_SIZE must be a power of two"
+#endif
+/* direct mapped, each entry remembers which key it holds */
+static struct {
+    uint16_t key_number;
+    uint8_t layer;
+} layer_cache[LAYER_CACHE_SIZE];
+#else
+static uint8_t layer_cache[MATRIX_ROWS * MATRIX_COLS];
+#endif
+
+/* layer_state | default_layer_state the cache entries were resolved for */
+static uint32_t layer_cache_layers = 0;
+static bool layer_cache_valid = false;
+
+/** \brief Drop every cached layer
+ *
+ * Layer state changes are picked up automatically; call this when the
+ * keymap itself changes, e.g. dynamic keymap writes.
+ */
+void layer_cache_invalidate(void)
+{
+    layer_cache_valid = false;
+}
+
+static void layer_cache_prepare(uint32_t layers)
+{
+    if (layer_cache_valid && layer_cache_layers == layers) {
+        return;
+    }
+#ifdef LAYER_CACHE_SIZE
+    for (uint8_t i = 0; i < LAYER_CACHE_SIZE; i++) {
+        layer_cache[i].layer = LAYER_CACHE_EMPTY;
+    }
+#else
+    for (uint16_t i = 0; i < MATRIX_ROWS * MATRIX_COLS; i++) {
+        layer_cache[i] = LAYER_CACHE_EMPTY;
+    }
+#endif
+    layer_cache_layers = layers;
+    layer_cache_valid = true;
+}
+
+static uint8_t layer_cache_read(uint16_t key_number)
+{
+#ifdef LAYER_CACHE_SIZE
+    uint8_t slot = key_number & (LAYER_CACHE_SIZE - 1);
+    if (layer_cache[slot].key_number != key_number) {
+        return LAYER_CACHE_EMPTY;
+    }
+    return layer_cache[slot].layer;
+#else
+    return layer_cache[key_number];
+#endif
+}
+
+static void layer_cache_write(uint16_t key_number, uint8_t layer)
+{
+#ifdef LAYER_CACHE_SIZE
+    uint8_t slot = key_number & (LAYER_CACHE_SIZE - 1);
+    layer_cache[slot].key_number = key_number;
+    layer_cache[slot].layer = layer;
+#else
+    layer_cache[key_number] = layer;
+#endif
+}
+#endif
+
 /** \brief Store or get action (FIXME: Needs better summary)
  *
  * Make sure the action triggered when the key is released is the same
@@ -304,16 +379,34 @@ int8_t layer_switch_get_layer(keypos_t key)
     action.code = ACTION_TRANSPARENT;
 
     uint32_t layers = layer_state | default_layer_state;
+#ifdef LAYER_CACHE_ENABLE
+    /* keys outside the matrix (e.g. virtual positions) are never cached */
+    bool cacheable = key.row < MATRIX_ROWS && key.col < MATRIX_COLS;
+    uint16_t key_number = key.row * MATRIX_COLS + key.col;
+    if (cacheable) {
+        layer_cache_prepare(layers);
+        uint8_t layer = layer_cache_read(key_number);
+        if (layer != LAYER_CACHE_EMPTY) {
+            return layer;
+        }
+    }
+#endif
     /* check top layer first */
     for (int8_t i = 31; i >= 0; i--) {
         if (layers & (1UL<<i)) {
             action = action_for_key(i, key);
             if (action.code != ACTION_TRANSPARENT) {
+#ifdef LAYER_CACHE_ENABLE
+                if (cacheable) layer_cache_write(key_number, i);
+#endif
                 return i;
             }
         }
     }
     /* fall back to layer 0 */
+#ifdef LAYER_CACHE_ENABLE
+    if (cacheable) layer_cache_write(key_number, 0);
+#endif
     return 0;
 #else
     return biton32(default_layer_state);
@@ -96,6 +96,26 @@ uint32_t layer_state_set_kb(uint32_t state);
 void update_source_layers_cache(keypos_t key, uint8_t layer);
 uint8_t read_source_layers_cache(keypos_t key);
 #endif
+/* effective layer cache
+ *
+ * Remembers which layer each key resolved to for the current
+ * layer_state | default_layer_state, so a press does not have to walk the
+ * layer stack through action_for_key() again. One byte per key by default;
+ * AVR boards opt in by defining LAYER_CACHE_SIZE, which bounds the cache to
+ * that many entries (a power of two, at most 128). Define NO_LAYER_CACHE to
+ * disable it.
+ */
+#if defined(LAYER_CACHE_SIZE) && (LAYER_CACHE_SIZE < 1 || LAYER_CACHE_SIZE > 128)
+#error "LAYER_CACHE_SIZE must be between 1 and 128"
+#endif
+#if !defined(NO_ACTION_LAYER) && !defined(NO_LAYER_CACHE) && (!defined(__AVR__) || defined(LAYER_CACHE_SIZE))
+#define LAYER_CACHE_ENABLE
+/* call when keymap contents change behind the cache's back */
+void layer_cache_invalidate(void);
+#else
+#define layer_cache_invalidate()
+#endif
+
 action_t store_or_get_action(bool pressed, keypos_t key);
 
 /* return the topmost non-transparent layer currently associated with key */
@@ -5,6 +5,7 @@
 #include "action_tapping.h"
 #include "keycode.h"
 #include "timer.h"
+#include "progmem.h"
 
 #ifdef DEBUG_ACTION
 #include "debug.h"
@@ -18,13 +19,19 @@
 #define IS_TAPPING_PRESSED()    (IS_TAPPING() && tapping_key.event.pressed)
 #define IS_TAPPING_RELEASED()   (IS_TAPPING() && !tapping_key.event.pressed)
 #define IS_TAPPING_KEY(k)       (IS_TAPPING() && KEYEQ(tapping_key.event.key, (k)))
-#define WITHIN_TAPPING_TERM(e)  (TIMER_DIFF_16(e.time, tapping_key.event.time) < TAPPING_TERM)
+#define WITHIN_TAPPING_TERM(e)  (TIMER_DIFF_16(e.time, tapping_key.event.time) < tapping_key_config()->term)
 
 
 static keyrecord_t tapping_key = {};
+#define WAITING_BUFFER_MASK     (WAITING_BUFFER_SIZE - 1)
+#define WAITING_BUFFER_COUNT()  ((uint8_t)(waiting_buffer_head - waiting_buffer_tail))
+
+/* head and tail run freely and are masked on access, so every slot can be
+ * used and a full buffer can still be told apart from an empty one. */
 static keyrecord_t waiting_buffer[WAITING_BUFFER_SIZE] = {};
 static uint8_t waiting_buffer_head = 0;
 static uint8_t waiting_buffer_tail = 0;
+static waiting_buffer_stats_t waiting_buffer_stats = {};
 
 static bool process_tapping(keyrecord_t *record);
 static bool waiting_buffer_enq(keyrecord_t record);
@@ -35,6 +42,72 @@ static void waiting_buffer_scan_tap(void);
 static void debug_tapping_key(void);
 static void debug_waiting_buffer(void);
 
+/* Term and decisions by action kind, this is what a key gets unless
+ * get_tapping_config() is overridden */
+#define TAPPING_CLASS_MOD_TAP   { TAPPING_TERM_MOD_TAP, TAPPING_STRATEGY_MOD_TAP }
+#define TAPPING_CLASS_LAYER_TAP { TAPPING_TERM_LAYER_TAP, TAPPING_STRATEGY_LAYER_TAP }
+#define TAPPING_CLASS_OTHER     { TAPPING_TERM, TAPPING_STRATEGY }
+
+static const tapping_config_t tapping_class_config[16] PROGMEM = {
+    [ACT_LMODS]         = TAPPING_CLASS_OTHER,
+    [ACT_RMODS]         = TAPPING_CLASS_OTHER,
+    [ACT_LMODS_TAP]     = TAPPING_CLASS_MOD_TAP,
+    [ACT_RMODS_TAP]     = TAPPING_CLASS_MOD_TAP,
+    [ACT_USAGE]         = TAPPING_CLASS_OTHER,
+    [ACT_MOUSEKEY]      = TAPPING_CLASS_OTHER,
+    [ACT_SWAP_HANDS]    = TAPPING_CLASS_OTHER,
+    [0b0111]            = TAPPING_CLASS_OTHER,
+    [ACT_LAYER]         = TAPPING_CLASS_OTHER,
+    [0b1001]            = TAPPING_CLASS_OTHER,
+    [ACT_LAYER_TAP]     = TAPPING_CLASS_LAYER_TAP,
+    [ACT_LAYER_TAP_EXT] = TAPPING_CLASS_LAYER_TAP,
+    [ACT_MACRO]         = TAPPING_CLASS_OTHER,
+    [ACT_BACKLIGHT]     = TAPPING_CLASS_OTHER,
+    [ACT_COMMAND]       = TAPPING_CLASS_OTHER,
+    [ACT_FUNCTION]      = TAPPING_CLASS_OTHER,
+};
+
+/** \brief Default tapping config
+ *
+ * Looks the key up by the kind of its action.
+ */
+tapping_config_t get_tapping_config_default(keyrecord_t *record)
+{
+    action_t action = layer_switch_get_action(record->event.key);
+    const tapping_config_t *entry = &tapping_class_config[action.kind.id];
+    return (tapping_config_t){
+        .term = pgm_read_word(&entry->term),
+        .strategy = pgm_read_byte(&entry->strategy)
+    };
+}
+
+/** \brief Tapping config of a tap key
+ *
+ * Override to give single keys their own term or decisions, by keycode or
+ * matrix position. Called once each time a key starts tapping.
+ */
+__attribute__ ((weak))
+tapping_config_t get_tapping_config(keyrecord_t *record)
+{
+    return get_tapping_config_default(record);
+}
+
+/* The config is resolved once for each tapping key and kept until a
+ * different key (or a new press) starts tapping */
+static tapping_config_t tapping_config;
+static keyevent_t tapping_config_event = {};
+
+static const tapping_config_t *tapping_key_config(void)
+{
+    if (!KEYEQ(tapping_config_event.key, tapping_key.event.key) ||
+        tapping_config_event.time != tapping_key.event.time ||
+        IS_NOEVENT(tapping_config_event)) {
+        tapping_config = get_tapping_config(&tapping_key);
+        tapping_config_event = tapping_key.event;
+    }
+    return &tapping_config;
+}
+
 
 /** \brief Action Tapping Process
  *
@@ -60,10 +133,10 @@ void action_tapping_process(keyrecord_t record)
     if (!IS_NOEVENT(record.event) && waiting_buffer_head != waiting_buffer_tail) {
         debug("---- action_exec: process waiting_buffer -----\n");
     }
-    for (; waiting_buffer_tail != waiting_buffer_head; waiting_buffer_tail = (waiting_buffer_tail + 1) % WAITING_BUFFER_SIZE) {
-        if (process_tapping(&waiting_buffer[waiting_buffer_tail])) {
-            debug("processed: waiting_buffer["); debug_dec(waiting_buffer_tail); debug("] = ");
-            debug_record(waiting_buffer[waiting_buffer_tail]); debug("\n\n");
+    for (; waiting_buffer_tail != waiting_buffer_head; waiting_buffer_tail++) {
+        if (process_tapping(&waiting_buffer[waiting_buffer_tail & WAITING_BUFFER_MASK])) {
+            debug("processed: waiting_buffer["); debug_dec(waiting_buffer_tail & WAITING_BUFFER_MASK); debug("] = ");
+            debug_record(waiting_buffer[waiting_buffer_tail & WAITING_BUFFER_MASK]); debug("\n\n");
         } else {
             break;
         }
@@ -74,6 +147,30 @@ void action_tapping_process(keyrecord_t record)
 }
 
 
+/** \brief Is the waiting buffer full
+ *
+ * The next event could be dropped now, so the caller should hold on to it
+ * until the tapping key has been settled and the buffer drained.
+ */
+bool action_tapping_is_full(void)
+{
+    return WAITING_BUFFER_COUNT() >= WAITING_BUFFER_SIZE;
+}
+
+/** \brief Waiting buffer counters
+ */
+waiting_buffer_stats_t action_tapping_get_stats(void)
+{
+    return waiting_buffer_stats;
+}
+
+/** \brief Reset the waiting buffer counters
+ */
+void action_tapping_clear_stats(void)
+{
+    waiting_buffer_stats = (waiting_buffer_stats_t){};
+}
+
 /** \brief Tapping
  *
  * Rule: Tap key is typed(pressed and released) within TAPPING_TERM.
@@ -100,12 +197,12 @@ bool process_tapping(keyrecord_t *keyp)
                     // enqueue
                     return false;
                 }
-#if TAPPING_TERM >= 500 || defined PERMISSIVE_HOLD
                 /* Process a key typed within TAPPING_TERM
                  * This can register the key before settlement of tapping,
                  * useful for long TAPPING_TERM but may prevent fast typing.
                  */
-                else if (IS_RELEASED(event) && waiting_buffer_typed(event)) {
+                else if ((tapping_key_config()->strategy & TAPPING_PERMISSIVE_HOLD) &&
+                         IS_RELEASED(event) && waiting_buffer_typed(event)) {
                     debug("Tapping: End. No tap. Interfered by typing key\n");
                     process_record(&tapping_key);
                     tapping_key = (keyrecord_t){};
@@ -113,7 +210,6 @@ bool process_tapping(keyrecord_t *keyp)
                     // enqueue
                     return false;
                 }
-#endif
                 /* Process release event of a key pressed before tapping starts
                  * Without this unexpected repeating will occur with having fast repeating setting
                  * https://github.com/tmk/tmk_keyboard/issues/60
@@ -142,6 +238,13 @@ bool process_tapping(keyrecord_t *keyp)
                     // set interrupted flag when other key preesed during tapping
                     if (event.pressed) {
                         tapping_key.tap.interrupted = true;
+                        /* Settle as hold without waiting for the term */
+                        if (tapping_key_config()->strategy & TAPPING_HOLD_ON_OTHER_KEY_PRESS) {
+                            debug("Tapping: End. No tap. Interfered by pressed key\n");
+                            process_record(&tapping_key);
+                            tapping_key = (keyrecord_t){};
+                            debug_tapping_key();
+                        }
                     }
                     // enqueue
                     return false;
@@ -303,13 +406,17 @@ bool waiting_buffer_enq(keyrecord_t record)
         return true;
     }
 
-    if ((waiting_buffer_head + 1) % WAITING_BUFFER_SIZE == waiting_buffer_tail) {
+    if (WAITING_BUFFER_COUNT() >= WAITING_BUFFER_SIZE) {
         debug("waiting_buffer_enq: Over flow.\n");
+        if (waiting_buffer_stats.overflows < UINT16_MAX) waiting_buffer_stats.overflows++;
         return false;
     }
 
-    waiting_buffer[waiting_buffer_head] = record;
-    waiting_buffer_head = (waiting_buffer_head + 1) % WAITING_BUFFER_SIZE;
+    waiting_buffer[waiting_buffer_head & WAITING_BUFFER_MASK] = record;
+    waiting_buffer_head++;
+    if (WAITING_BUFFER_COUNT() > waiting_buffer_stats.high_water) {
+        waiting_buffer_stats.high_water = WAITING_BUFFER_COUNT();
+    }
 
     debug("waiting_buffer_enq: "); debug_waiting_buffer();
     return true;
@@ -331,8 +438,9 @@ void waiting_buffer_clear(void)
  */
 bool waiting_buffer_typed(keyevent_t event)
 {
-    for (uint8_t i = waiting_buffer_tail; i != waiting_buffer_head; i = (i + 1) % WAITING_BUFFER_SIZE) {
-        if (KEYEQ(event.key, waiting_buffer[i].event.key) && event.pressed !=  waiting_buffer[i].event.pressed) {
+    for (uint8_t i = waiting_buffer_tail; i != waiting_buffer_head; i++) {
+        keyrecord_t *waiting = &waiting_buffer[i & WAITING_BUFFER_MASK];
+        if (KEYEQ(event.key, waiting->event.key) && event.pressed != waiting->event.pressed) {
             return true;
         }
     }
@@ -346,8 +454,8 @@ bool waiting_buffer_typed(keyevent_t event)
 __attribute__((unused))
 bool waiting_buffer_has_anykey_pressed(void)
 {
-    for (uint8_t i = waiting_buffer_tail; i != waiting_buffer_head; i = (i + 1) % WAITING_BUFFER_SIZE) {
-        if (waiting_buffer[i].event.pressed) return true;
+    for (uint8_t i = waiting_buffer_tail; i != waiting_buffer_head; i++) {
+        if (waiting_buffer[i & WAITING_BUFFER_MASK].event.pressed) return true;
     }
     return false;
 }
@@ -363,15 +471,16 @@ void waiting_buffer_scan_tap(void)
     // invalid state: tapping_key released && tap.count == 0
     if (!tapping_key.event.pressed) return;
 
-    for (uint8_t i = waiting_buffer_tail; i != waiting_buffer_head; i = (i + 1) % WAITING_BUFFER_SIZE) {
-        if (IS_TAPPING_KEY(waiting_buffer[i].event.key) &&
-                !waiting_buffer[i].event.pressed &&
-                WITHIN_TAPPING_TERM(waiting_buffer[i].event)) {
+    for (uint8_t i = waiting_buffer_tail; i != waiting_buffer_head; i++) {
+        keyrecord_t *waiting = &waiting_buffer[i & WAITING_BUFFER_MASK];
+        if (IS_TAPPING_KEY(waiting->event.key) &&
+                !waiting->event.pressed &&
+                WITHIN_TAPPING_TERM(waiting->event)) {
             tapping_key.tap.count = 1;
-            waiting_buffer[i].tap.count = 1;
+            waiting->tap.count = 1;
             process_record(&tapping_key);
 
-            debug("waiting_buffer_scan_tap: found at ["); debug_dec(i); debug("]\n");
+            debug("waiting_buffer_scan_tap: found at ["); debug_dec(i & WAITING_BUFFER_MASK); debug("]\n");
             debug_waiting_buffer();
             return;
         }
@@ -395,8 +504,8 @@ static void debug_tapping_key(void)
 static void debug_waiting_buffer(void)
 {
     debug("{ ");
-    for (uint8_t i = waiting_buffer_tail; i != waiting_buffer_head; i = (i + 1) % WAITING_BUFFER_SIZE) {
-        debug("["); debug_dec(i); debug("]="); debug_record(waiting_buffer[i]); debug(" ");
+    for (uint8_t i = waiting_buffer_tail; i != waiting_buffer_head; i++) {
+        debug("["); debug_dec(i & WAITING_BUFFER_MASK); debug("]="); debug_record(waiting_buffer[i & WAITING_BUFFER_MASK]); debug(" ");
     }
     debug("}\n");
 }
@@ -17,6 +17,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef ACTION_TAPPING_H
 #define ACTION_TAPPING_H
 
+#include <stdint.h>
+#include "action.h"
 
 
 /* period of tapping(ms) */
@@ -31,11 +33,84 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define TAPPING_TOGGLE  5
 #endif
 
+/* Number of key records that can wait for a tapping key to be settled.
+ * Key events are held back in the event queue, and from there in the
+ * matrix, while it is full, so a small buffer only delays a fast roll.
+ * Must be a power of two.
+ */
+#ifndef WAITING_BUFFER_SIZE
 #define WAITING_BUFFER_SIZE 8
+#endif
+
+#if (WAITING_BUFFER_SIZE & (WAITING_BUFFER_SIZE - 1)) != 0 || WAITING_BUFFER_SIZE > 128
+#error "WAITING_BUFFER_SIZE must be a power of two and no larger than 128"
+#endif
+
+/* Per key tapping decisions
+ *
+ * TAPPING_PERMISSIVE_HOLD: a key typed (pressed and released) while the
+ * tap key is held turns it into a hold before the term is up.
+ * TAPPING_HOLD_ON_OTHER_KEY_PRESS: pressing any other key while the tap key
+ * is held turns it into a hold right away.
+ */
+#define TAPPING_PERMISSIVE_HOLD          0x01
+#define TAPPING_HOLD_ON_OTHER_KEY_PRESS  0x02
+
+/* default decisions for every tap key */
+#ifndef TAPPING_STRATEGY
+#   if TAPPING_TERM >= 500 || defined PERMISSIVE_HOLD
+#       define TAPPING_STRATEGY TAPPING_PERMISSIVE_HOLD
+#   else
+#       define TAPPING_STRATEGY 0
+#   endif
+#endif
+
+/* term and decisions for mod tap keys (MT, LCTL_T, ...) */
+#ifndef TAPPING_TERM_MOD_TAP
+#define TAPPING_TERM_MOD_TAP        TAPPING_TERM
+#endif
+#ifndef TAPPING_STRATEGY_MOD_TAP
+#define TAPPING_STRATEGY_MOD_TAP    TAPPING_STRATEGY
+#endif
+
+/* term and decisions for layer tap keys (LT, TT, ...) */
+#ifndef TAPPING_TERM_LAYER_TAP
+#define TAPPING_TERM_LAYER_TAP      TAPPING_TERM
+#endif
+#ifndef TAPPING_STRATEGY_LAYER_TAP
+#define TAPPING_STRATEGY_LAYER_TAP  TAPPING_STRATEGY
+#endif
+
+typedef struct {
+    uint8_t  high_water;    /* most records that were waiting at once */
+    uint16_t overflows;     /* records dropped because the buffer was full */
+} waiting_buffer_stats_t;
+
+typedef struct {
+    uint16_t term;      /* ms */
+    uint8_t  strategy;  /* TAPPING_PERMISSIVE_HOLD, TAPPING_HOLD_ON_OTHER_KEY_PRESS */
+} tapping_config_t;
 
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #ifndef NO_ACTION_TAPPING
 void action_tapping_process(keyrecord_t record);
+bool action_tapping_is_full(void);
+waiting_buffer_stats_t action_tapping_get_stats(void);
+void action_tapping_clear_stats(void);
+/* term and decisions for the tap key of record, override to set them per key */
+tapping_config_t get_tapping_config(keyrecord_t *record);
+/* the defaults by kind of key, from the TAPPING_TERM_* and TAPPING_STRATEGY_* settings */
+tapping_config_t get_tapping_config_default(keyrecord_t *record);
+#else
+static inline bool action_tapping_is_full(void) { return false; }
+#endif
+
+#ifdef __cplusplus
+}
 #endif
 
 #endif
@@ -17,6 +17,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "host.h"
 #include "report.h"
 #include "debug.h"
+#include "action.h"
 #include "action_util.h"
 #include "action_layer.h"
 #include "timer.h"
@@ -29,23 +30,42 @@ static uint8_t real_mods = 0;
 static uint8_t weak_mods = 0;
 static uint8_t macro_mods = 0;
 
-#ifdef USB_6KRO_ENABLE
-#define RO_ADD(a, b) ((a + b) % KEYBOARD_REPORT_KEYS)
-#define RO_SUB(a, b) ((a - b + KEYBOARD_REPORT_KEYS) % KEYBOARD_REPORT_KEYS)
-#define RO_INC(a) RO_ADD(a, 1)
-#define RO_DEC(a) RO_SUB(a, 1)
-static int8_t cb_head = 0;
-static int8_t cb_tail = 0;
-static int8_t cb_count = 0;
-#endif
+static report_builder_t keyboard_report_builder;
 
 // TODO: pointer variable is not needed
-//report_keyboard_t keyboard_report = {};
-report_keyboard_t *keyboard_report = &(report_keyboard_t){};
+report_keyboard_t *keyboard_report = &keyboard_report_builder.report;
 
-extern inline void add_key(uint8_t key);
-extern inline void del_key(uint8_t key);
-extern inline void clear_keys(void);
+/** \brief Follow the report layout the host asked for
+ *
+ * Converts the held keys in place when the protocol or the NKRO setting
+ * changed since the last edit.
+ */
+static void sync_keyboard_report_layout(void) {
+#ifdef NKRO_ENABLE
+    report_builder_set_nkro(&keyboard_report_builder, keyboard_protocol && keymap_config.nkro);
+#endif
+}
+
+/** \brief Add key to the keyboard report */
+void add_key(uint8_t key) {
+    action_flush_output();
+    sync_keyboard_report_layout();
+    report_builder_add_key(&keyboard_report_builder, key);
+}
+
+/** \brief Remove key from the keyboard report */
+void del_key(uint8_t key) {
+    action_flush_output();
+    sync_keyboard_report_layout();
+    report_builder_del_key(&keyboard_report_builder, key);
+}
+
+/** \brief Remove all keys from the keyboard report */
+void clear_keys(void) {
+    action_flush_output();
+    sync_keyboard_report_layout();
+    report_builder_clear_keys(&keyboard_report_builder);
+}
 
 #ifndef NO_ACTION_ONESHOT
 static int8_t oneshot_mods = 0;
@@ -133,11 +153,50 @@ bool is_oneshot_layer_active(void)
 }
 #endif
 
+static uint8_t report_transaction_depth = 0;
+static bool report_transaction_pending = false;
+
+/** \brief Begin a keyboard report transaction
+ *
+ * Until the matching commit_keyboard_report(), send_keyboard_report() only
+ * notes that the report changed, so a run of register/unregister calls goes
+ * out as a single report. Transactions can be nested. Streamed output goes
+ * out before the first one opens, its reports can't be held back.
+ */
+void begin_keyboard_report(void) {
+    if (report_transaction_depth == 0) {
+        action_flush_output();
+    }
+    report_transaction_depth++;
+}
+
+/** \brief Commit a keyboard report transaction
+ *
+ * Sends the report once the outermost transaction ends, if anything asked
+ * for it to be sent in between.
+ */
+void commit_keyboard_report(void) {
+    if (report_transaction_depth == 0 || --report_transaction_depth > 0) {
+        return;
+    }
+    if (report_transaction_pending) {
+        report_transaction_pending = false;
+        send_keyboard_report();
+    }
+}
+
 /** \brief Send keyboard report
  *
- * FIXME: needs doc
+ * Builds the mods from all sources and hands the report to the host driver,
+ * which drops it if it matches the last one sent. Deferred while a report
+ * transaction is open.
  */
 void send_keyboard_report(void) {
+    if (report_transaction_depth) {
+        report_transaction_pending = true;
+        return;
+    }
+    sync_keyboard_report_layout();
     keyboard_report->mods  = real_mods;
     keyboard_report->mods |= weak_mods;
     keyboard_report->mods |= macro_mods;
@@ -150,7 +209,7 @@ void send_keyboard_report(void) {
         }
 #endif
         keyboard_report->mods |= oneshot_mods;
-        if (has_anykey(keyboard_report)) {
+        if (report_builder_key_count(&keyboard_report_builder)) {
             clear_oneshot_mods();
         }
     }
@@ -168,22 +227,22 @@ uint8_t get_mods(void) { return real_mods; }
  *
  * FIXME: needs doc
  */
-void add_mods(uint8_t mods) { real_mods |= mods; }
+void add_mods(uint8_t mods) { action_flush_output(); real_mods |= mods; }
 /** \brief del mods
  *
  * FIXME: needs doc
  */
-void del_mods(uint8_t mods) { real_mods &= ~mods; }
+void del_mods(uint8_t mods) { action_flush_output(); real_mods &= ~mods; }
 /** \brief set mods
  *
  * FIXME: needs doc
  */
-void set_mods(uint8_t mods) { real_mods = mods; }
+void set_mods(uint8_t mods) { action_flush_output(); real_mods = mods; }
 /** \brief clear mods
  *
  * FIXME: needs doc
  */
-void clear_mods(void) { real_mods = 0; }
+void clear_mods(void) { action_flush_output(); real_mods = 0; }
 
 /** \brief get weak mods
  *
@@ -194,22 +253,22 @@ uint8_t get_weak_mods(void) { return weak_mods; }
  *
  * FIXME: needs doc
  */
-void add_weak_mods(uint8_t mods) { weak_mods |= mods; }
+void add_weak_mods(uint8_t mods) { action_flush_output(); weak_mods |= mods; }
 /** \brief del weak mods
  *
  * FIXME: needs doc
  */
-void del_weak_mods(uint8_t mods) { weak_mods &= ~mods; }
+void del_weak_mods(uint8_t mods) { action_flush_output(); weak_mods &= ~mods; }
 /** \brief set weak mods
  *
  * FIXME: needs doc
  */
-void set_weak_mods(uint8_t mods) { weak_mods = mods; }
+void set_weak_mods(uint8_t mods) { action_flush_output(); weak_mods = mods; }
 /** \brief clear weak mods
  *
  * FIXME: needs doc
  */
-void clear_weak_mods(void) { weak_mods = 0; }
+void clear_weak_mods(void) { action_flush_output(); weak_mods = 0; }
 
 /* macro modifier */
 /** \brief get macro mods
@@ -221,22 +280,22 @@ uint8_t get_macro_mods(void) { return macro_mods; }
  *
  * FIXME: needs doc
  */
-void add_macro_mods(uint8_t mods) { macro_mods |= mods; }
+void add_macro_mods(uint8_t mods) { action_flush_output(); macro_mods |= mods; }
 /** \brief del macro mods
  *
  * FIXME: needs doc
  */
-void del_macro_mods(uint8_t mods) { macro_mods &= ~mods; }
+void del_macro_mods(uint8_t mods) { action_flush_output(); macro_mods &= ~mods; }
 /** \brief set macro mods
  *
  * FIXME: needs doc
  */
-void set_macro_mods(uint8_t mods) { macro_mods = mods; }
+void set_macro_mods(uint8_t mods) { action_flush_output(); macro_mods = mods; }
 /** \brief clear macro mods
  *
  * FIXME: needs doc
  */
-void clear_macro_mods(void) { macro_mods = 0; }
+void clear_macro_mods(void) { action_flush_output(); macro_mods = 0; }
 
 #ifndef NO_ACTION_ONESHOT
 /** \brief set oneshot mods
@@ -28,6 +28,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "bootloader.h"
 #include "action_layer.h"
 #include "action_util.h"
+#include "action_tapping.h"
 #include "eeconfig.h"
 #include "sleep_led.h"
 #include "led.h"
@@ -51,6 +52,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 	#include "usbdrv.h"
 #endif
 
+#ifdef PROTOCOL_CHIBIOS
+	#include "usb_main.h"
+#endif
+
 #ifdef AUDIO_ENABLE
     #include "audio.h"
 #endif /* AUDIO_ENABLE */
@@ -257,6 +262,26 @@ static void print_status(void)
 #   if USB_COUNT_SOF
     print_val_hex8(usbSofCount);
 #   endif
+#endif
+
+#ifndef NO_ACTION_TAPPING
+    waiting_buffer_stats_t waiting_buffer = action_tapping_get_stats();
+    print_val_dec(waiting_buffer.high_water);
+    print_val_dec(waiting_buffer.overflows);
+#endif
+
+#ifdef PROTOCOL_CHIBIOS
+    keyboard_latency_t latency;
+    keyboard_latency_get(&latency);
+    print("\n\t- Scan to host latency (ms) -\n");
+    uint16_t average = latency.reports ? latency.total / latency.reports : 0;
+    print_val_hex32(latency.reports);
+    print_val_dec(latency.last);
+    print_val_dec(latency.max);
+    print_val_dec(average);
+    print_val_hex32(latency.untimed);
+    print_val_hex32(latency.overflows);
+    keyboard_latency_clear();
 #endif
 	return;
 }
@@ -0,0 +1,208 @@
+/*
+Copyright 2018 QMK Firmware contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <stdarg.h>
+#include <stddef.h>
+#include "console_buffer.h"
+#include "progmem.h"
+
+#define CONSOLE_BUFFER_MASK (CONSOLE_BUFFER_SIZE - 1)
+
+/* head is only moved by the writer and tail only by the reader, each after
+ * the bytes it hands over are in place, so neither side has to block
+ * interrupts. They run freely and are masked on access. */
+static volatile uint8_t buffer[CONSOLE_BUFFER_SIZE];
+static volatile uint8_t buffer_head = 0;
+static volatile uint8_t buffer_tail = 0;
+
+static uint16_t dropped = 0;
+static uint16_t dropped_reported = 0;
+
+/* Worst case of drop_notice() */
+#define DROP_NOTICE_SIZE 20
+
+static uint8_t drop_notice(uint8_t *notice, uint16_t count)
+{
+    uint8_t length = 0;
+#ifdef CONSOLE_BINARY_LOG
+    notice[length++] = CONSOLE_LOG_SYNC;
+    notice[length++] = sizeof(const char *) + 2;
+    for (uint8_t i = 0; i < sizeof(const char *); i++) {
+        notice[length++] = 0;
+    }
+    notice[length++] = count & 0xFF;
+    notice[length++] = count >> 8;
+#else
+    static const char prefix[] PROGMEM = "\r\n[dropped ";
+    for (uint8_t i = 0; i < sizeof(prefix) - 1; i++) {
+        notice[length++] = pgm_read_byte(&prefix[i]);
+    }
+    uint8_t digits = 0;
+    for (uint16_t n = count; n; n /= 10) {
+        digits++;
+    }
+    length += digits;
+    for (uint8_t i = 1; i <= digits; i++) {
+        notice[length - i] = '0' + count % 10;
+        count /= 10;
+    }
+    notice[length++] = ']';
+    notice[length++] = '\r';
+    notice[length++] = '\n';
+#endif
+    return length;
+}
+
+uint8_t console_buffer_used(void)
+{
+    return buffer_head - buffer_tail;
+}
+
+uint16_t console_buffer_dropped(void)
+{
+    return dropped;
+}
+
+void console_buffer_clear(void)
+{
+    buffer_tail = buffer_head;
+}
+
+bool console_buffer_write(const uint8_t *data, uint8_t length)
+{
+    uint8_t head = buffer_head;
+    uint8_t space = CONSOLE_BUFFER_SIZE - (uint8_t)(head - buffer_tail);
+    uint8_t notice[DROP_NOTICE_SIZE];
+    uint8_t notice_length = 0;
+
+    if (dropped != dropped_reported) {
+        notice_length = drop_notice(notice, dropped - dropped_reported);
+    }
+    if ((uint16_t)notice_length + length > space) {
+        dropped++;
+        return false;
+    }
+    for (uint8_t i = 0; i < notice_length; i++) {
+        buffer[head++ & CONSOLE_BUFFER_MASK] = notice[i];
+    }
+    for (uint8_t i = 0; i < length; i++) {
+        buffer[head++ & CONSOLE_BUFFER_MASK] = data[i];
+    }
+    dropped_reported = dropped;
+    buffer_head = head;
+    return true;
+}
+
+uint8_t console_buffer_peek(uint8_t *data, uint8_t size)
+{
+    uint8_t tail = buffer_tail;
+    uint8_t length = buffer_head - tail;
+    if (length > size) {
+        length = size;
+    }
+    for (uint8_t i = 0; i < length; i++) {
+        data[i] = buffer[tail++ & CONSOLE_BUFFER_MASK];
+    }
+    return length;
+}
+
+void console_buffer_consume(uint8_t length)
+{
+    buffer_tail += length;
+}
+
+typedef struct {
+    uint8_t data[CONSOLE_LOG_MESSAGE_SIZE];
+    uint8_t length;
+    bool    overflow;
+} log_message_t;
+
+static void log_append(log_message_t *message, uint32_t value, uint8_t size)
+{
+    if (message->length + size > CONSOLE_LOG_MESSAGE_SIZE) {
+        message->overflow = true;
+        return;
+    }
+    for (uint8_t i = 0; i < size; i++) {
+        message->data[message->length++] = value & 0xFF;
+        value >>= 8;
+    }
+}
+
+/** \brief Queue a binary log message
+ *
+ * Only the argument sizes are taken from the format: an int, or 4 bytes
+ * with 'l', the characters of a RAM string with its terminator for %s, and
+ * a pointer for %S. Messages that don't fit in CONSOLE_LOG_MESSAGE_SIZE
+ * are counted as dropped.
+ */
+void console_log(const char *format, ...)
+{
+    log_message_t message = { .length = 0, .overflow = false };
+    va_list args;
+
+    log_append(&message, CONSOLE_LOG_SYNC, 1);
+    log_append(&message, 0, 1);
+    log_append(&message, (uintptr_t)format, sizeof(format));
+
+    va_start(args, format);
+    const char *p = format;
+    char c;
+    while ((c = pgm_read_byte(p++))) {
+        if (c != '%') {
+            continue;
+        }
+        c = pgm_read_byte(p++);
+        while (c == '-' || (c >= '0' && c <= '9')) {
+            c = pgm_read_byte(p++);
+        }
+        bool is_long = false;
+        if (c == 'l' || c == 'L') {
+            is_long = true;
+            c = pgm_read_byte(p++);
+        }
+        switch (c) {
+        case '\0':
+            p--;
+            break;
+        case 's': {
+            const char *s = va_arg(args, const char *);
+            do {
+                log_append(&message, *s, 1);
+            } while (*s++ && !message.overflow);
+            break;
+        }
+        case 'S':
+            log_append(&message, (uintptr_t)va_arg(args, const char *), sizeof(const char *));
+            break;
+        case 'c': case 'd': case 'i': case 'u': case 'x': case 'X': case 'b': case 'o':
+            if (is_long) {
+                log_append(&message, va_arg(args, long), 4);
+            } else {
+                log_append(&message, va_arg(args, int), sizeof(int));
+            }
+            break;
+        }
+    }
+    va_end(args);
+
+    if (message.overflow) {
+        dropped++;
+        return;
+    }
+    message.data[1] = message.length - 2;
+    console_buffer_write(message.data, message.length);
+}
@@ -0,0 +1,74 @@
+/*
+Copyright 2018 QMK Firmware contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef CONSOLE_BUFFER_H
+#define CONSOLE_BUFFER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Console output is queued here by sendchar() and sent by the USB stack
+ * when the host polls the console endpoint, so printing never waits for
+ * USB. Output that does not fit is dropped and counted, the count is put in
+ * the stream once there is room again.
+ *
+ * Written from the main loop only, read from the main loop or from an
+ * interrupt. Must be a power of two.
+ */
+#ifndef CONSOLE_BUFFER_SIZE
+#define CONSOLE_BUFFER_SIZE 128
+#endif
+
+#if (CONSOLE_BUFFER_SIZE & (CONSOLE_BUFFER_SIZE - 1)) != 0 || CONSOLE_BUFFER_SIZE > 128
+#error "CONSOLE_BUFFER_SIZE must be a power of two and no larger than 128"
+#endif
+
+/* Largest binary log message, see console_log() */
+#ifndef CONSOLE_LOG_MESSAGE_SIZE
+#define CONSOLE_LOG_MESSAGE_SIZE 24
+#endif
+
+/* Binary log messages start with this byte, followed by the length of the
+ * rest of the message, the format string address and the arguments. A
+ * message with a NULL format carries the number of messages dropped. */
+#define CONSOLE_LOG_SYNC 0xFE
+
+/* Queue all of data, or nothing if it doesn't fit */
+bool console_buffer_write(const uint8_t *data, uint8_t length);
+/* Copy up to size queued bytes without removing them */
+uint8_t console_buffer_peek(uint8_t *data, uint8_t size);
+/* Remove length bytes after they were sent */
+void console_buffer_consume(uint8_t length);
+uint8_t console_buffer_used(void);
+/* Writes dropped since startup */
+uint16_t console_buffer_dropped(void);
+void console_buffer_clear(void);
+
+/* Queue a binary log message: the address of the format string and the
+ * raw arguments instead of the formatted text. util/console_log_decode.py
+ * formats them with the strings from the firmware's ELF file. The format
+ * is read from PROGMEM on AVR. */
+void console_log(const char *format, ...);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -16,11 +16,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include <stdint.h>
+#include <string.h>
 //#include <avr/interrupt.h>
 #include "keycode.h"
 #include "host.h"
 #include "util.h"
 #include "debug.h"
+#include "pipeline_trace.h"
 
 #ifdef NKRO_ENABLE
   #include "keycode_config.h"
@@ -30,6 +32,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 static host_driver_t *driver;
 static uint16_t last_system_report = 0;
 static uint16_t last_consumer_report = 0;
+/* Shadows of what the host was sent last, identical reports are dropped */
+static report_keyboard_t last_keyboard_report;
+static bool last_keyboard_report_valid = false;
+static report_mouse_t last_mouse_report;
+static bool last_mouse_report_valid = false;
 
 
 void host_set_driver(host_driver_t *d)
@@ -65,7 +72,13 @@ void host_keyboard_send(report_keyboard_t *report)
         report->report_id = REPORT_ID_KEYBOARD;
 #endif
     }
+    if (last_keyboard_report_valid && memcmp(report, &last_keyboard_report, sizeof(report_keyboard_t)) == 0) return;
+    last_keyboard_report = *report;
+    last_keyboard_report_valid = true;
+
+    PIPELINE_TRACE_BEGIN(PIPELINE_TRACE_REPORT_SEND);
     (*driver->send_keyboard)(report);
+    PIPELINE_TRACE_END(PIPELINE_TRACE_REPORT_SEND);
 
     if (debug_keyboard) {
         dprint("keyboard_report: ");
@@ -82,6 +95,12 @@ void host_mouse_send(report_mouse_t *report)
 #ifdef MOUSE_SHARED_EP
     report->report_id = REPORT_ID_MOUSE;
 #endif
+    /* Movement is relative, so only a repeated report without any is redundant */
+    if (last_mouse_report_valid && !report->x && !report->y && !report->v && !report->h &&
+        memcmp(report, &last_mouse_report, sizeof(report_mouse_t)) == 0) return;
+    last_mouse_report = *report;
+    last_mouse_report_valid = true;
+
     (*driver->send_mouse)(report);
 }
 
@@ -103,6 +122,13 @@ void host_consumer_send(uint16_t report)
     (*driver->send_consumer)(report);
 }
 
+/* Drivers that queue reports override this to hold key events back */
+__attribute__ ((weak))
+bool host_keyboard_busy(void)
+{
+    return false;
+}
+
 uint16_t host_last_system_report(void)
 {
     return last_system_report;
@@ -112,3 +138,13 @@ uint16_t host_last_consumer_report(void)
 {
     return last_consumer_report;
 }
+
+/* Forget what was sent last so the next reports always go out,
+ * for when the host may have lost track of them */
+void host_clear_last_reports(void)
+{
+    last_keyboard_report_valid = false;
+    last_mouse_report_valid = false;
+    last_system_report = 0;
+    last_consumer_report = 0;
+}
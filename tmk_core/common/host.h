@@ -42,9 +42,12 @@ void host_keyboard_send(report_keyboard_t *report);
 void host_mouse_send(report_mouse_t *report);
 void host_system_send(uint16_t data);
 void host_consumer_send(uint16_t data);
+/* true while the driver can't take the reports of another key event */
+bool host_keyboard_busy(void);
 
 uint16_t host_last_system_report(void);
 uint16_t host_last_consumer_report(void);
+void host_clear_last_reports(void);
 
 #ifdef __cplusplus
 }
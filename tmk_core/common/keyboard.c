@@ -31,6 +31,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "eeconfig.h"
 #include "backlight.h"
 #include "action_layer.h"
+#include "action_tapping.h"
+#include "keyevent_queue.h"
+#include "pipeline_trace.h"
 #ifdef BOOTMAGIC_ENABLE
 #   include "bootmagic.h"
 #else
@@ -120,6 +123,13 @@ static inline bool has_ghost_in_row(uint8_t row, matrix_row_t rowdata)
 
 #endif
 
+/* Upper bound on queued events handed to the action pipeline per task call.
+ * By default every change found by a scan is dispatched in the same call.
+ */
+#ifndef QMK_KEYS_PER_SCAN
+#   define QMK_KEYS_PER_SCAN KEYEVENT_QUEUE_SIZE
+#endif
+
 void disable_jtag(void) {
 // To use PORTF disable JTAG with writing JTD bit twice within four cycles.
 #if (defined(__AVR_AT90USB1286__) || defined(__AVR_AT90USB1287__) || defined(__AVR_ATmega32U4__))
@@ -159,6 +169,8 @@ bool is_keyboard_master(void) {
  * FIXME: needs doc
  */
 void keyboard_init(void) {
+    // The host has not seen any report from us yet
+    host_clear_last_reports();
     timer_init();
     matrix_init();
 #ifdef PS2_MOUSE_ENABLE
@@ -195,6 +207,105 @@ void keyboard_init(void) {
 #endif
 }
 
+/** \brief Collect matrix changes
+ *
+ * Compare the current matrix with the state already handed to the event
+ * queue and queue one event per changed key, in matrix order. All events
+ * found in one call share the time of the scan that produced them, so a
+ * key keeps the time it was actually scanned no matter how late it gets
+ * dispatched. If the queue fills up the remaining changes are left in
+ * place and get collected on a later call.
+ */
+void keyboard_collect_events(void)
+{
+    static matrix_row_t matrix_prev[MATRIX_ROWS];
+#ifdef MATRIX_HAS_GHOST
+  //  static matrix_row_t matrix_ghost[MATRIX_ROWS];
+#endif
+    matrix_row_t matrix_row = 0;
+    matrix_row_t matrix_change = 0;
+    uint16_t scan_time = timer_read() | 1; /* time should not be 0 */
+
+    for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
+        matrix_row = matrix_get_row(r);
+        matrix_change = matrix_row ^ matrix_prev[r];
+        if (matrix_change) {
+#ifdef MATRIX_HAS_GHOST
+            if (has_ghost_in_row(r, matrix_row)) {
+                /* Keep track of whether ghosted status has changed for
+                * debugging. But don't update matrix_prev until un-ghosted, or
+                * the last key would be lost.
+                */
+                //if (debug_matrix && matrix_ghost[r] != matrix_row) {
+                //    matrix_print();
+                //}
+                //matrix_ghost[r] = matrix_row;
+                continue;
+            }
+            //matrix_ghost[r] = matrix_row;
+#endif
+            if (debug_matrix) matrix_print();
+            for (uint8_t c = 0; c < MATRIX_COLS; c++) {
+                if (matrix_change & ((matrix_row_t)1<<c)) {
+                    if (!keyevent_queue_put((keyevent_t){
+                        .key = (keypos_t){ .row = r, .col = c },
+                        .pressed = (matrix_row & ((matrix_row_t)1<<c)),
+                        .time = scan_time
+                    })) {
+                        return;
+                    }
+                    // record a queued key
+                    matrix_prev[r] ^= ((matrix_row_t)1<<c);
+                }
+            }
+        }
+    }
+}
+
+/* Scan time of the key event being dispatched, until a report takes it */
+static uint16_t event_time = 0;
+static bool event_time_valid = false;
+
+/** \brief Dispatch queued key events
+ *
+ * Run up to max queued events through the action pipeline, oldest first.
+ * Stops early while the tapping waiting buffer is full, streamed output
+ * such as a send_string() is still going out or the host driver has no room
+ * for more reports, the events stay queued until then. Returns the number of events dispatched.
+ */
+uint8_t keyboard_dispatch_events(uint8_t max)
+{
+    keyevent_t event;
+    uint8_t dispatched = 0;
+
+    while (dispatched < max && !action_tapping_is_full() && !action_output_pending() &&
+           !host_keyboard_busy() && keyevent_queue_get(&event)) {
+        event_time = event.time;
+        event_time_valid = true;
+        action_exec(event);
+        event_time_valid = false;
+        dispatched++;
+    }
+    return dispatched;
+}
+
+/** \brief Take the scan time of the key event being dispatched
+ *
+ * Lets the host driver tell how long a report took from the scan that
+ * caused it to the host. Only the first report sent while an event is
+ * dispatched gets its time; later reports of the same event and reports
+ * sent outside of one get false.
+ */
+bool keyboard_take_event_time(uint16_t *time)
+{
+    if (!event_time_valid) {
+        return false;
+    }
+    *time = event_time;
+    event_time_valid = false;
+    return true;
+}
+
 /** \brief Keyboard task: Do keyboard routine jobs
  *
  * Do routine keyboard jobs:
@@ -209,66 +320,19 @@ void keyboard_init(void) {
  */
 void keyboard_task(void)
 {
-    static matrix_row_t matrix_prev[MATRIX_ROWS];
-#ifdef MATRIX_HAS_GHOST
-  //  static matrix_row_t matrix_ghost[MATRIX_ROWS];
-#endif
     static uint8_t led_status = 0;
-    matrix_row_t matrix_row = 0;
-    matrix_row_t matrix_change = 0;
-#ifdef QMK_KEYS_PER_SCAN
-    uint8_t keys_processed = 0;
-#endif
 
+    PIPELINE_TRACE_BEGIN(PIPELINE_TRACE_MATRIX_SCAN);
     matrix_scan();
+    PIPELINE_TRACE_END(PIPELINE_TRACE_MATRIX_SCAN);
     if (is_keyboard_master()) {
-        for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
-            matrix_row = matrix_get_row(r);
-            matrix_change = matrix_row ^ matrix_prev[r];
-            if (matrix_change) {
-#ifdef MATRIX_HAS_GHOST
-                if (has_ghost_in_row(r, matrix_row)) {
-                    /* Keep track of whether ghosted status has changed for
-                    * debugging. But don't update matrix_prev until un-ghosted, or
-                    * the last key would be lost.
-                    */
-                    //if (debug_matrix && matrix_ghost[r] != matrix_row) {
-                    //    matrix_print();
-                    //}
-                    //matrix_ghost[r] = matrix_row;
-                    continue;
-                }
-                //matrix_ghost[r] = matrix_row;
-#endif
-                if (debug_matrix) matrix_print();
-                for (uint8_t c = 0; c < MATRIX_COLS; c++) {
-                    if (matrix_change & ((matrix_row_t)1<<c)) {
-                        action_exec((keyevent_t){
-                            .key = (keypos_t){ .row = r, .col = c },
-                            .pressed = (matrix_row & ((matrix_row_t)1<<c)),
-                            .time = (timer_read() | 1) /* time should not be 0 */
-                        });
-                        // record a processed key
-                        matrix_prev[r] ^= ((matrix_row_t)1<<c);
-#ifdef QMK_KEYS_PER_SCAN
-                        // only jump out if we have processed "enough" keys.
-                        if (++keys_processed >= QMK_KEYS_PER_SCAN)
-#endif
-                        // process a key per task call
-                        goto MATRIX_LOOP_END;
-                    }
-                }
-            }
-        }
+        keyboard_collect_events();
     }
+    action_output_task();
     // call with pseudo tick event when no real key event.
-#ifdef QMK_KEYS_PER_SCAN
-    // we can get here with some keys processed now.
-    if (!keys_processed)
-#endif
-    action_exec(TICK);
-
-MATRIX_LOOP_END:
+    if (!keyboard_dispatch_events(QMK_KEYS_PER_SCAN)) {
+        action_exec(TICK);
+    }
 
 #ifdef MOUSEKEY_ENABLE
     // mousekey repeat & acceleration
@@ -292,7 +356,9 @@ MATRIX_LOOP_END:
 #endif
 
 #ifdef VISUALIZER_ENABLE
+    PIPELINE_TRACE_BEGIN(PIPELINE_TRACE_VISUALIZER);
     visualizer_update(default_layer_state, layer_state, visualizer_get_mods(), host_keyboard_leds());
+    PIPELINE_TRACE_END(PIPELINE_TRACE_VISUALIZER);
 #endif
 
 #ifdef POINTING_DEVICE_ENABLE
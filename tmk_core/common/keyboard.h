@@ -65,6 +65,12 @@ void keyboard_setup(void);
 void keyboard_init(void);
 /* it runs repeatedly in main loop */
 void keyboard_task(void);
+/* queue key events for every matrix change since the last call */
+void keyboard_collect_events(void);
+/* run up to max queued key events through the action pipeline */
+uint8_t keyboard_dispatch_events(uint8_t max);
+/* scan time of the key event being dispatched, once per event */
+bool keyboard_take_event_time(uint16_t *time);
 /* it runs when host LED status is updated */
 void keyboard_set_leds(uint8_t leds);
 
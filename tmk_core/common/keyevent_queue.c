@@ -0,0 +1,71 @@
+/*
+Copyright 2018 QMK Firmware contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "keyevent_queue.h"
+
+#define KEYEVENT_QUEUE_MASK (KEYEVENT_QUEUE_SIZE - 1)
+
+/* head and tail run freely and are masked on access, so a full queue can be
+ * told apart from an empty one without wasting a slot. */
+static keyevent_t queue[KEYEVENT_QUEUE_SIZE];
+static uint8_t queue_head = 0;
+static uint8_t queue_tail = 0;
+
+/** \brief Discard all pending events */
+void keyevent_queue_clear(void)
+{
+    queue_head = queue_tail = 0;
+}
+
+/** \brief Number of pending events */
+uint8_t keyevent_queue_count(void)
+{
+    return (uint8_t)(queue_head - queue_tail);
+}
+
+/** \brief Is the queue full */
+bool keyevent_queue_is_full(void)
+{
+    return keyevent_queue_count() >= KEYEVENT_QUEUE_SIZE;
+}
+
+/** \brief Append an event
+ *
+ * Returns false without modifying the queue when it is full.
+ */
+bool keyevent_queue_put(keyevent_t event)
+{
+    if (keyevent_queue_is_full()) {
+        return false;
+    }
+    queue[queue_head & KEYEVENT_QUEUE_MASK] = event;
+    queue_head++;
+    return true;
+}
+
+/** \brief Remove the oldest event
+ *
+ * Returns false when there is nothing pending.
+ */
+bool keyevent_queue_get(keyevent_t *event)
+{
+    if (queue_head == queue_tail) {
+        return false;
+    }
+    *event = queue[queue_tail & KEYEVENT_QUEUE_MASK];
+    queue_tail++;
+    return true;
+}
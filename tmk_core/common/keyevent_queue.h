@@ -0,0 +1,51 @@
+/*
+Copyright 2018 QMK Firmware contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef KEYEVENT_QUEUE_H
+#define KEYEVENT_QUEUE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "keyboard.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Number of matrix changes that can be pending between matrix scan and
+ * action dispatch. A full queue does not lose events: the matrix diff
+ * stage stops collecting and picks the remaining changes up on a later scan.
+ * Must be a power of two.
+ */
+#ifndef KEYEVENT_QUEUE_SIZE
+#define KEYEVENT_QUEUE_SIZE 16
+#endif
+
+#if (KEYEVENT_QUEUE_SIZE & (KEYEVENT_QUEUE_SIZE - 1)) != 0 || KEYEVENT_QUEUE_SIZE > 128
+#error "KEYEVENT_QUEUE_SIZE must be a power of two and no larger than 128"
+#endif
+
+void keyevent_queue_clear(void);
+bool keyevent_queue_put(keyevent_t event);
+bool keyevent_queue_get(keyevent_t *event);
+uint8_t keyevent_queue_count(void);
+bool keyevent_queue_is_full(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
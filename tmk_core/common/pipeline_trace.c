@@ -0,0 +1,191 @@
+/*
+Copyright 2018 QMK Firmware contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "pipeline_trace.h"
+
+#if defined(__AVR__)
+#   include <avr/io.h>
+#   include <util/atomic.h>
+#   include "avr/timer_avr.h"
+#elif defined(PROTOCOL_CHIBIOS)
+#   include "ch.h"
+#   include "hal.h"
+#else
+#   include <time.h>
+#endif
+#ifdef RAW_ENABLE
+#   include "raw_hid.h"
+#endif
+
+#define PIPELINE_TRACE_MASK (PIPELINE_TRACE_SIZE - 1)
+#define PIPELINE_TRACE_HEADER_SIZE 8
+#define PIPELINE_TRACE_RECORD_SIZE 5
+
+typedef struct {
+    uint32_t time;
+    uint8_t  stage;
+} trace_record_t;
+
+static trace_record_t records[PIPELINE_TRACE_SIZE];
+static uint16_t records_head = 0;
+static uint16_t records_tail = 0;
+/* overwritten before they were read */
+static uint16_t records_lost = 0;
+
+#if defined(__AVR__)
+
+extern volatile uint32_t timer_count;
+
+/* Timer0 counts up to TIMER_RAW_TOP every millisecond, so the millisecond
+ * count and the counter together give a timestamp in timer ticks. */
+static uint32_t trace_now(void)
+{
+    uint32_t ms;
+    uint8_t raw;
+    bool pending;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        ms = timer_count;
+        raw = TIMER_RAW;
+#ifndef __AVR_ATmega32A__
+        pending = TIFR0 & (1 << OCF0A);
+#else
+        pending = TIFR & (1 << OCF0);
+#endif
+    }
+    // The counter wrapped but the interrupt didn't count it yet
+    if (pending && raw < TIMER_RAW_TOP / 2) {
+        ms++;
+    }
+    return ms * (TIMER_RAW_TOP + 1) + raw;
+}
+
+uint32_t pipeline_trace_tick_hz(void)
+{
+    return TIMER_RAW_FREQ;
+}
+
+#elif defined(PROTOCOL_CHIBIOS) && defined(DWT) && (defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__))
+
+static uint32_t trace_now(void)
+{
+    static bool started = false;
+    if (!started) {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+        started = true;
+    }
+    return DWT->CYCCNT;
+}
+
+uint32_t pipeline_trace_tick_hz(void)
+{
+#if defined(STM32_SYSCLK)
+    return STM32_SYSCLK;
+#elif defined(KINETIS_SYSCLK_FREQUENCY)
+    return KINETIS_SYSCLK_FREQUENCY;
+#else
+    return 0;
+#endif
+}
+
+#elif defined(PROTOCOL_CHIBIOS)
+
+/* Cortex-M0 has no cycle counter */
+static uint32_t trace_now(void)
+{
+    return chVTGetSystemTimeX();
+}
+
+uint32_t pipeline_trace_tick_hz(void)
+{
+    return CH_CFG_ST_FREQUENCY;
+}
+
+#else
+
+static uint32_t trace_now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)now.tv_sec * 1000000000UL + now.tv_nsec;
+}
+
+uint32_t pipeline_trace_tick_hz(void)
+{
+    return 1000000000UL;
+}
+
+#endif
+
+void pipeline_trace_record(uint8_t stage)
+{
+    if ((uint16_t)(records_head - records_tail) == PIPELINE_TRACE_SIZE) {
+        records_tail++;
+        records_lost++;
+    }
+    trace_record_t *record = &records[records_head++ & PIPELINE_TRACE_MASK];
+    record->time = trace_now();
+    record->stage = stage;
+}
+
+static uint8_t *put_le(uint8_t *p, uint32_t value, uint8_t size)
+{
+    while (size--) {
+        *p++ = value & 0xFF;
+        value >>= 8;
+    }
+    return p;
+}
+
+uint8_t pipeline_trace_read_packet(uint8_t *packet, uint8_t size)
+{
+    if (size < PIPELINE_TRACE_HEADER_SIZE) {
+        return 0;
+    }
+    uint16_t available = records_head - records_tail;
+    uint8_t count = (size - PIPELINE_TRACE_HEADER_SIZE) / PIPELINE_TRACE_RECORD_SIZE;
+    if (available < count) {
+        count = available;
+    }
+
+    uint8_t *p = packet;
+    *p++ = PIPELINE_TRACE_RAW_HID_ID;
+    *p++ = count;
+    p = put_le(p, records_lost, 2);
+    p = put_le(p, pipeline_trace_tick_hz(), 4);
+    for (uint8_t i = 0; i < count; i++) {
+        trace_record_t *record = &records[records_tail++ & PIPELINE_TRACE_MASK];
+        *p++ = record->stage;
+        p = put_le(p, record->time, 4);
+    }
+    while (p < packet + size) {
+        *p++ = 0;
+    }
+    records_lost = 0;
+    return count;
+}
+
+#ifdef RAW_ENABLE
+bool pipeline_trace_raw_hid_receive(uint8_t *data, uint8_t length)
+{
+    if (length == 0 || data[0] != PIPELINE_TRACE_RAW_HID_ID) {
+        return false;
+    }
+    pipeline_trace_read_packet(data, length);
+    raw_hid_send(data, length);
+    return true;
+}
+#endif
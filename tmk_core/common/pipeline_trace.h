@@ -0,0 +1,95 @@
+/*
+Copyright 2018 QMK Firmware contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef PIPELINE_TRACE_H
+#define PIPELINE_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Stages of keyboard_task() that record when they start and end. The
+ * numbers are part of the readout format, add new ones at the end. */
+enum pipeline_trace_stage {
+    PIPELINE_TRACE_MATRIX_SCAN = 0,
+    PIPELINE_TRACE_DEBOUNCE,
+    PIPELINE_TRACE_ACTION_EXEC,
+    PIPELINE_TRACE_PROCESS_RECORD,
+    PIPELINE_TRACE_REPORT_SEND,
+    PIPELINE_TRACE_RGB,
+    PIPELINE_TRACE_VISUALIZER,
+};
+
+#define PIPELINE_TRACE_END_BIT 0x80
+
+#ifdef PIPELINE_TRACE_ENABLE
+
+/* Number of start/end records kept, the oldest are overwritten. Must be
+ * a power of two. */
+#ifndef PIPELINE_TRACE_SIZE
+#   ifdef __AVR__
+#       define PIPELINE_TRACE_SIZE 32
+#   else
+#       define PIPELINE_TRACE_SIZE 256
+#   endif
+#endif
+
+#if (PIPELINE_TRACE_SIZE & (PIPELINE_TRACE_SIZE - 1)) != 0
+#error "PIPELINE_TRACE_SIZE must be a power of two"
+#endif
+
+/* First byte of the raw HID request and of every reply */
+#ifndef PIPELINE_TRACE_RAW_HID_ID
+#define PIPELINE_TRACE_RAW_HID_ID 0x54
+#endif
+
+#define PIPELINE_TRACE_BEGIN(stage) pipeline_trace_record(stage)
+#define PIPELINE_TRACE_END(stage)   pipeline_trace_record((stage) | PIPELINE_TRACE_END_BIT)
+
+void pipeline_trace_record(uint8_t stage);
+
+/* Timestamps count at this rate: CPU cycles on ARM, Timer0 ticks on AVR
+ * and nanoseconds in the native tests */
+uint32_t pipeline_trace_tick_hz(void);
+
+/* Move the oldest unread records into a readout packet:
+ *
+ *   id, record count, records lost (2 bytes), tick rate (4 bytes),
+ *   then per record: stage, timestamp (4 bytes)
+ *
+ * All values are little endian. Returns the number of records. */
+uint8_t pipeline_trace_read_packet(uint8_t *packet, uint8_t size);
+
+/* Answers a request of PIPELINE_TRACE_RAW_HID_ID with a readout packet.
+ * Called by the default raw_hid_receive(), call it from your own one too.
+ * Returns false for other requests. */
+bool pipeline_trace_raw_hid_receive(uint8_t *data, uint8_t length);
+
+#else
+
+#define PIPELINE_TRACE_BEGIN(stage)
+#define PIPELINE_TRACE_END(stage)
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -162,6 +162,30 @@ void print_set_sendchar(int8_t (*print_sendchar_func)(uint8_t));
 
 #endif /* __AVR__ / PROTOCOL_CHIBIOS / PROTOCOL_ARM_ATSAM / __arm__ */
 
+// Binary log mode queues the format string's address and the arguments
+// instead of the text, see console_buffer.h
+#if defined(CONSOLE_BINARY_LOG) && defined(CONSOLE_ENABLE)
+
+#  include "console_buffer.h"
+
+#  undef uprint
+#  undef uprintln
+#  undef uprintf
+#  define uprint(s)          console_log(PSTR(s))
+#  define uprintln(s)        console_log(PSTR(s "\r\n"))
+#  define uprintf(fmt, ...)  console_log(PSTR(fmt), ##__VA_ARGS__)
+
+#  ifndef USER_PRINT
+#    undef print
+#    undef println
+#    undef xprintf
+#    define print(s)           uprint(s)
+#    define println(s)         uprintln(s)
+#    define xprintf(fmt, ...)  uprintf(fmt, ##__VA_ARGS__)
+#  endif
+
+#endif /* CONSOLE_BINARY_LOG */
+
 // User print disables the normal print messages in the body of QMK/TMK code and
 // is meant as a lightweight alternative to NOPRINT. Use it when you only want to do
 // a spot of debugging but lack flash resources for allowing all of the codebase to
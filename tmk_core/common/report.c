@@ -21,6 +21,16 @@
 #include "util.h"
 #include <string.h>
 
+#ifdef USB_6KRO_ENABLE
+#define RO_ADD(a, b) ((a + b) % KEYBOARD_REPORT_KEYS)
+#define RO_SUB(a, b) ((a - b + KEYBOARD_REPORT_KEYS) % KEYBOARD_REPORT_KEYS)
+#define RO_INC(a) RO_ADD(a, 1)
+#define RO_DEC(a) RO_SUB(a, 1)
+static int8_t cb_head = 0;
+static int8_t cb_tail = 0;
+static int8_t cb_count = 0;
+#endif
+
 /** \brief has_anykey
  *
  * FIXME: Needs doc
@@ -254,3 +264,147 @@ void clear_keys_from_report(report_keyboard_t* keyboard_report)
 #endif
     memset(keyboard_report->keys, 0, sizeof(keyboard_report->keys));
 }
+
+/** \brief Start an empty report in the given layout
+ *
+ * Clears keys and mods.
+ */
+void report_builder_init(report_builder_t* builder, bool nkro)
+{
+    memset(&builder->report, 0, sizeof(builder->report));
+    builder->key_count = 0;
+#ifdef NKRO_ENABLE
+    builder->nkro = nkro;
+#else
+    (void)nkro;
+    builder->nkro = false;
+#endif
+}
+
+/** \brief Switch between boot and NKRO layout
+ *
+ * Held keys are carried over into the new layout; mods are kept. Going from
+ * NKRO to boot layout keeps the lowest KEYBOARD_REPORT_KEYS keycodes.
+ */
+void report_builder_set_nkro(report_builder_t* builder, bool nkro)
+{
+#ifdef NKRO_ENABLE
+    if (builder->nkro == nkro) {
+        return;
+    }
+    // keys[] and nkro.bits overlap, so take the held keys out first
+    uint8_t held[KEYBOARD_REPORT_KEYS];
+    uint8_t count = 0;
+    if (builder->nkro) {
+        for (uint8_t i = 0; i < KEYBOARD_REPORT_BITS && count < KEYBOARD_REPORT_KEYS; i++) {
+            uint8_t bits = builder->report.nkro.bits[i];
+            for (uint8_t b = 0; bits && count < KEYBOARD_REPORT_KEYS; b++, bits >>= 1) {
+                if (bits & 1) {
+                    held[count++] = i<<3 | b;
+                }
+            }
+        }
+    } else {
+        count = builder->key_count;
+        memcpy(held, builder->report.keys, count);
+    }
+    uint8_t mods = builder->report.mods;
+    report_builder_init(builder, nkro);
+    builder->report.mods = mods;
+    for (uint8_t i = 0; i < count; i++) {
+        report_builder_add_key(builder, held[i]);
+    }
+#else
+    (void)builder;
+    (void)nkro;
+#endif
+}
+
+/** \brief Add a key to the report
+ *
+ * Adding a key that is already held does nothing. When the boot layout is
+ * full the key is dropped, or with USB_6KRO_ENABLE the oldest key makes
+ * room for it.
+ */
+void report_builder_add_key(report_builder_t* builder, uint8_t key)
+{
+#ifdef NKRO_ENABLE
+    if (builder->nkro) {
+        uint8_t index = key>>3;
+        uint8_t bit = 1<<(key&7);
+        if (index >= KEYBOARD_REPORT_BITS) {
+            dprintf("report_builder_add_key: can't add: %02X\n", key);
+            return;
+        }
+        if (!(builder->report.nkro.bits[index] & bit)) {
+            builder->report.nkro.bits[index] |= bit;
+            builder->key_count++;
+        }
+        return;
+    }
+#endif
+    uint8_t *keys = builder->report.keys;
+    for (uint8_t i = 0; i < builder->key_count; i++) {
+        if (keys[i] == key) {
+            return;
+        }
+    }
+    if (builder->key_count == KEYBOARD_REPORT_KEYS) {
+#ifdef USB_6KRO_ENABLE
+        memmove(&keys[0], &keys[1], KEYBOARD_REPORT_KEYS - 1);
+        builder->key_count--;
+#else
+        return;
+#endif
+    }
+    keys[builder->key_count++] = key;
+}
+
+/** \brief Remove a key from the report
+ *
+ * The remaining boot layout keys keep their order.
+ */
+void report_builder_del_key(report_builder_t* builder, uint8_t key)
+{
+#ifdef NKRO_ENABLE
+    if (builder->nkro) {
+        uint8_t index = key>>3;
+        uint8_t bit = 1<<(key&7);
+        if (index >= KEYBOARD_REPORT_BITS) {
+            dprintf("report_builder_del_key: can't del: %02X\n", key);
+            return;
+        }
+        if (builder->report.nkro.bits[index] & bit) {
+            builder->report.nkro.bits[index] &= ~bit;
+            builder->key_count--;
+        }
+        return;
+    }
+#endif
+    uint8_t *keys = builder->report.keys;
+    for (uint8_t i = 0; i < builder->key_count; i++) {
+        if (keys[i] == key) {
+            builder->key_count--;
+            memmove(&keys[i], &keys[i + 1], builder->key_count - i);
+            keys[builder->key_count] = 0;
+            return;
+        }
+    }
+}
+
+/** \brief Remove all keys from the report
+ *
+ * Mods are left alone.
+ */
+void report_builder_clear_keys(report_builder_t* builder)
+{
+#ifdef NKRO_ENABLE
+    if (builder->nkro) {
+        memset(builder->report.nkro.bits, 0, sizeof(builder->report.nkro.bits));
+    } else
+#endif
+    {
+        memset(builder->report.keys, 0, sizeof(builder->report.keys));
+    }
+    builder->key_count = 0;
+}
@@ -19,6 +19,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define REPORT_H
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "keycode.h"
 
 
@@ -88,7 +89,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
     #define KEYBOARD_REPORT_BITS (NKRO_EPSIZE - 1)
     #undef NKRO_SHARED_EP
     #undef MOUSE_SHARED_EP
-  #else
+  #elif !defined(KEYBOARD_REPORT_BITS)
+    /* native builds without a USB stack define KEYBOARD_REPORT_BITS themselves */
     #error "NKRO not supported with this protocol"
   #endif
 #endif
@@ -152,6 +154,21 @@ typedef union {
 #endif
 } __attribute__ ((packed)) report_keyboard_t;
 
+/*
+ * Keyboard report together with the bookkeeping needed to edit it in place.
+ *
+ * key_count is the number of keys held in the report. In boot (6KRO) layout
+ * the keys are kept packed at the front of keys[] in press order, so
+ * key_count is also the index of the next free slot. In NKRO layout each key
+ * is one bit and key_count is the number of bits set. has_anykey() on a
+ * builder is therefore a field read instead of a scan of the report.
+ */
+typedef struct {
+    report_keyboard_t report;
+    uint8_t key_count;
+    bool nkro;
+} report_builder_t;
+
 typedef struct {
 #ifdef MOUSE_SHARED_EP
     uint8_t report_id;
@@ -210,6 +227,13 @@ void add_key_to_report(report_keyboard_t* keyboard_report, uint8_t key);
 void del_key_from_report(report_keyboard_t* keyboard_report, uint8_t key);
 void clear_keys_from_report(report_keyboard_t* keyboard_report);
 
+void report_builder_init(report_builder_t* builder, bool nkro);
+void report_builder_set_nkro(report_builder_t* builder, bool nkro);
+void report_builder_add_key(report_builder_t* builder, uint8_t key);
+void report_builder_del_key(report_builder_t* builder, uint8_t key);
+void report_builder_clear_keys(report_builder_t* builder);
+static inline uint8_t report_builder_key_count(const report_builder_t* builder) { return builder->key_count; }
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,8 +1,8 @@
 SYSTEM_TYPE := $(shell gcc -dumpmachine)
 
 CC = gcc
-OBJCOPY = 
-OBJDUMP = 
+OBJCOPY = objcopy
+OBJDUMP = objdump
 SIZE = 
 AR = 
 NM = 
@@ -21,6 +21,8 @@
 #include "usb_main.h"
 
 #include "host.h"
+#include "keyboard.h"
+#include "timer.h"
 #include "debug.h"
 #include "suspend.h"
 #ifdef SLEEP_LED_ENABLE
@@ -30,6 +32,10 @@
 #include "wait.h"
 #include "usb_descriptor.h"
 #include "usb_driver.h"
+#ifdef CONSOLE_ENABLE
+#include "console_buffer.h"
+#endif
+#include "pipeline_trace.h"
 
 #ifdef NKRO_ENABLE
   #include "keycode_config.h"
@@ -56,6 +62,7 @@ uint16_t keyboard_led_stats __attribute__((aligned(2))) = 0;
 volatile uint16_t keyboard_idle_count = 0;
 static virtual_timer_t keyboard_idle_timer;
 static void keyboard_idle_timer_cb(void *arg);
+static void keyboard_report_reset_i(void);
 
 report_keyboard_t keyboard_report_sent = {{0}};
 #ifdef MOUSE_ENABLE
@@ -291,6 +298,7 @@ static void usb_event_cb(USBDriver *usbp, usbevent_t event) {
 
   case USB_EVENT_CONFIGURED:
     osalSysLockFromISR();
+    keyboard_report_reset_i();
     /* Enable the endpoints specified into the configuration. */
 #ifndef KEYBOARD_SHARED_EP
     usbInitEndpointI(usbp, KEYBOARD_IN_EPNUM, &kbd_ep_config);
@@ -319,6 +327,9 @@ static void usb_event_cb(USBDriver *usbp, usbevent_t event) {
   case USB_EVENT_UNCONFIGURED:
     /* Falls into.*/
   case USB_EVENT_RESET:
+      chSysLockFromISR();
+      keyboard_report_reset_i();
+      chSysUnlockFromISR();
       for (int i=0;i<NUM_USB_DRIVERS;i++) {
         chSysLockFromISR();
         /* Disconnection event on suspend.*/
@@ -570,20 +581,295 @@ void init_usb_driver(USBDriver *usbp) {
  *                  Keyboard functions
  * ---------------------------------------------------------
  */
+
+/* Keyboard report mailbox
+ *
+ * send_keyboard() never waits for the host to poll. Reports are queued and
+ * the IN callback of the endpoint starts the next transfer as soon as the
+ * previous one has made it IN. The head entry is the one in flight.
+ *
+ * Mouse and extra reports on the shared endpoint go through the same queue,
+ * so only one transfer is ever started on that endpoint at a time.
+ *
+ * A keyboard report still waiting to be sent is replaced by a newer one,
+ * unless that would hide a key transition from the host: a key pressed and
+ * released (or released and pressed again) across the two reports stays as
+ * two reports. Mouse and extra reports are never replaced.
+ *
+ * Queued reports are never dropped or overwritten to make room. Key events
+ * are held back in the keyevent queue while host_keyboard_busy(), so the
+ * queue only fills up if a single event sends more reports than the free
+ * half of it. The latest keyboard report that didn't fit is then kept aside
+ * and queued as soon as a slot frees up, other reports are dropped.
+ */
+typedef struct {
+  union {
+    report_keyboard_t keyboard;
+#if defined(MOUSE_ENABLE) && defined(MOUSE_SHARED_EP)
+    report_mouse_t mouse;
+#endif
+#ifdef EXTRAKEY_ENABLE
+    report_extra_t extra;
+#endif
+  } report;
+  usbep_t ep;
+  uint8_t offset;
+  uint8_t size;
+  bool keyboard;            /* false for mouse and extra reports */
+  bool nkro;
+  bool timed;               /* sent while a key event was dispatched */
+  uint16_t event_delay;     /* ms from the key event to queueing the report */
+  uint16_t queued_frame;    /* SOF count when it was queued */
+} keyboard_queued_report_t;
+
+static keyboard_queued_report_t keyboard_report_queue[KEYBOARD_REPORT_QUEUE_SIZE];
+static uint8_t keyboard_report_queue_head = 0;
+static uint8_t keyboard_report_queue_count = 0;
+static bool keyboard_report_in_flight = false;
+/* Latest keyboard report that found the queue full */
+static keyboard_queued_report_t keyboard_report_overflow;
+static bool keyboard_report_overflowed = false;
+
+/* Frames are 1 ms apart at full speed, so the SOF count doubles as a clock
+ * that can be read from the USB interrupt. */
+static volatile uint16_t keyboard_sof_frames = 0;
+#ifdef USB_SOF_ALIGNED_REPORTS
+static uint16_t keyboard_report_start_frame = 0;
+#endif
+static keyboard_latency_t keyboard_latency = {0};
+
+static inline uint8_t keyboard_report_queue_index(uint8_t n) {
+  return (keyboard_report_queue_head + n) % KEYBOARD_REPORT_QUEUE_SIZE;
+}
+
+static bool keyboard_report_has_key(const report_keyboard_t *report, uint8_t key) {
+  for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
+    if (report->keys[i] == key) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/* Can next replace pending without the host missing a transition that
+ * happened between prev and pending? */
+static bool keyboard_report_can_replace(const keyboard_queued_report_t *prev,
+                                        const keyboard_queued_report_t *pending,
+                                        const keyboard_queued_report_t *next) {
+  if (!prev->keyboard || !pending->keyboard || !next->keyboard) {
+    return false;
+  }
+  if (pending->ep != next->ep || pending->nkro != next->nkro || pending->size != next->size) {
+    return false;
+  }
+#ifdef NKRO_ENABLE
+  if (next->nkro) {
+    const uint8_t *a = (const uint8_t *)&prev->report.keyboard.nkro;
+    const uint8_t *b = (const uint8_t *)&pending->report.keyboard.nkro;
+    const uint8_t *c = (const uint8_t *)&next->report.keyboard.nkro;
+    for (uint8_t i = 0; i < sizeof(struct nkro_report); i++) {
+      if ((a[i] ^ b[i]) & (b[i] ^ c[i])) {
+        return false;
+      }
+    }
+    return true;
+  }
+#endif
+  if ((prev->report.keyboard.mods ^ pending->report.keyboard.mods) & (pending->report.keyboard.mods ^ next->report.keyboard.mods)) {
+    return false;
+  }
+  for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
+    uint8_t key = pending->report.keyboard.keys[i];
+    /* pressed in pending, released again in next */
+    if (key && !keyboard_report_has_key(&prev->report.keyboard, key) && !keyboard_report_has_key(&next->report.keyboard, key)) {
+      return false;
+    }
+    key = prev->report.keyboard.keys[i];
+    /* released in pending, pressed again in next */
+    if (key && !keyboard_report_has_key(&pending->report.keyboard, key) && keyboard_report_has_key(&next->report.keyboard, key)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* Starts transmitting the head of the queue if its endpoint is free.
+ * A busy endpoint calls back into keyboard_report_done_i() when it is done. */
+static void keyboard_report_start_i(USBDriver *usbp) {
+  if (keyboard_report_in_flight || keyboard_report_queue_count == 0) {
+    return;
+  }
+  keyboard_queued_report_t *entry = &keyboard_report_queue[keyboard_report_queue_head];
+  if (usbGetTransmitStatusI(usbp, entry->ep)) {
+    return;
+  }
+  usbStartTransmitI(usbp, entry->ep, (uint8_t *)&entry->report + entry->offset, entry->size);
+  keyboard_report_in_flight = true;
+#ifdef USB_SOF_ALIGNED_REPORTS
+  keyboard_report_start_frame = keyboard_sof_frames;
+#endif
+}
+
+/* With USB_SOF_ALIGNED_REPORTS transfers are only started from the SOF
+ * callback, otherwise as soon as there is something to send */
+static inline void keyboard_report_kick_i(USBDriver *usbp) {
+#ifndef USB_SOF_ALIGNED_REPORTS
+  keyboard_report_start_i(usbp);
+#else
+  (void)usbp;
+#endif
+}
+
+/* Called with the system locked from the IN callback of ep */
+static void keyboard_report_done_i(USBDriver *usbp, usbep_t ep) {
+  if (keyboard_report_in_flight && keyboard_report_queue[keyboard_report_queue_head].ep == ep) {
+    keyboard_queued_report_t *entry = &keyboard_report_queue[keyboard_report_queue_head];
+    if (entry->keyboard && !entry->timed) {
+      keyboard_latency.untimed++;
+    } else if (entry->keyboard) {
+      uint16_t latency = entry->event_delay + (uint16_t)(keyboard_sof_frames - entry->queued_frame);
+      keyboard_latency.reports++;
+      keyboard_latency.total += latency;
+      keyboard_latency.last = latency;
+      if (latency > keyboard_latency.max) {
+        keyboard_latency.max = latency;
+      }
+    }
+    keyboard_report_in_flight = false;
+    keyboard_report_queue_head = keyboard_report_queue_index(1);
+    keyboard_report_queue_count--;
+    if (keyboard_report_overflowed) {
+      keyboard_queued_report_t *slot = &keyboard_report_queue[keyboard_report_queue_index(keyboard_report_queue_count)];
+      *slot = keyboard_report_overflow;
+      slot->queued_frame = keyboard_sof_frames;
+      keyboard_report_queue_count++;
+      keyboard_report_overflowed = false;
+    }
+  }
+  keyboard_report_kick_i(usbp);
+}
+
+/* Drops everything queued, the endpoints are reinitialized after this */
+static void keyboard_report_reset_i(void) {
+  keyboard_report_queue_head = 0;
+  keyboard_report_queue_count = 0;
+  keyboard_report_in_flight = false;
+  keyboard_report_overflowed = false;
+}
+
+/* Returns false when the queue is full and entry can't replace its last
+ * report */
+static bool keyboard_report_post_i(USBDriver *usbp, const keyboard_queued_report_t *entry) {
+  /* Only the last entry can be replaced, and only once there is another
+   * one before it to compare with. The head may already be in flight. */
+  if (keyboard_report_queue_count >= 2) {
+    keyboard_queued_report_t *last = &keyboard_report_queue[keyboard_report_queue_index(keyboard_report_queue_count - 1)];
+    keyboard_queued_report_t *prev = &keyboard_report_queue[keyboard_report_queue_index(keyboard_report_queue_count - 2)];
+    if (keyboard_report_can_replace(prev, last, entry)) {
+      /* The host still sees the earlier key event first */
+      if (last->timed || !entry->timed) {
+        uint16_t event_delay = last->event_delay;
+        uint16_t queued_frame = last->queued_frame;
+        bool timed = last->timed;
+        *last = *entry;
+        last->timed = timed;
+        last->event_delay = event_delay;
+        last->queued_frame = queued_frame;
+      } else {
+        *last = *entry;
+        last->queued_frame = keyboard_sof_frames;
+      }
+      keyboard_report_kick_i(usbp);
+      return true;
+    }
+  }
+  if (keyboard_report_queue_count == KEYBOARD_REPORT_QUEUE_SIZE) {
+    return false;
+  }
+  keyboard_queued_report_t *slot = &keyboard_report_queue[keyboard_report_queue_index(keyboard_report_queue_count)];
+  *slot = *entry;
+  slot->queued_frame = keyboard_sof_frames;
+  keyboard_report_queue_count++;
+  keyboard_report_kick_i(usbp);
+  return true;
+}
+
+/* Queues entry without waiting. A keyboard report that doesn't fit is kept
+ * aside for when a slot frees up, replacing one kept aside before, so only
+ * an event that overran the free half of the queue can lose a transition.
+ * Counted in keyboard_latency.overflows. Dropped if the USB driver is not
+ * active. Not callable from ISR or locked state. */
+static void keyboard_report_post(const keyboard_queued_report_t *entry) {
+  osalSysLock();
+  if (usbGetDriverStateI(&USB_DRIVER) == USB_ACTIVE) {
+    if (keyboard_report_overflowed && entry->keyboard) {
+      /* Keep the order, nothing can pass the report kept aside */
+      keyboard_report_overflow = *entry;
+      keyboard_latency.overflows++;
+    } else if (!keyboard_report_post_i(&USB_DRIVER, entry)) {
+      if (entry->keyboard) {
+        keyboard_report_overflow = *entry;
+        keyboard_report_overflowed = true;
+      }
+      keyboard_latency.overflows++;
+    }
+  }
+  osalSysUnlock();
+}
+
+/** \brief Is the report queue too full to take the reports of another key event
+ *
+ * Key events wait in the keyevent queue while less than half of the report
+ * queue is free, so the reports of one event always fit.
+ */
+bool host_keyboard_busy(void) {
+  osalSysLock();
+  bool busy = keyboard_report_overflowed ||
+              keyboard_report_queue_count > KEYBOARD_REPORT_QUEUE_SIZE / 2;
+  osalSysUnlock();
+  return busy;
+}
+
+/* Copy of the scan to host latency counters */
+void keyboard_latency_get(keyboard_latency_t *latency) {
+  osalSysLock();
+  *latency = keyboard_latency;
+  osalSysUnlock();
+}
+
+void keyboard_latency_clear(void) {
+  osalSysLock();
+  keyboard_latency = (keyboard_latency_t){0};
+  osalSysUnlock();
+}
+
 /* keyboard IN callback hander (a kbd report has made it IN) */
 #ifndef KEYBOARD_SHARED_EP
 void kbd_in_cb(USBDriver *usbp, usbep_t ep) {
-  /* STUB */
-  (void)usbp;
-  (void)ep;
+  osalSysLockFromISR();
+  keyboard_report_done_i(usbp, ep);
+  osalSysUnlockFromISR();
 }
 #endif
 
 /* start-of-frame handler
- * TODO: i guess it would be better to re-implement using timers,
- *  so that this is not going to have to be checked every 1ms */
+ * Counts frames for the latency counters and, with USB_SOF_ALIGNED_REPORTS,
+ * starts the next queued report at most once per polling interval */
 void kbd_sof_cb(USBDriver *usbp) {
+  osalSysLockFromISR();
+  keyboard_sof_frames++;
+#ifdef USB_SOF_ALIGNED_REPORTS
+  if (!keyboard_report_in_flight && keyboard_report_queue_count) {
+    usbep_t ep = keyboard_report_queue[keyboard_report_queue_head].ep;
+    uint16_t interval = ep == KEYBOARD_IN_EPNUM ? KEYBOARD_POLLING_INTERVAL_MS : SHARED_POLLING_INTERVAL_MS;
+    if ((uint16_t)(keyboard_sof_frames - keyboard_report_start_frame) >= interval) {
+      keyboard_report_start_i(usbp);
+    }
+  }
+#else
   (void)usbp;
+#endif
+  osalSysUnlockFromISR();
 }
 
 /* Idle requests timer code
@@ -606,7 +892,7 @@ static void keyboard_idle_timer_cb(void *arg) {
   if(keyboard_idle && keyboard_protocol) {
 #endif /* NKRO_ENABLE */
     /* TODO: are we sure we want the KBD_ENDPOINT? */
-    if(!usbGetTransmitStatusI(usbp, KEYBOARD_IN_EPNUM)) {
+    if(keyboard_report_queue_count == 0 && !usbGetTransmitStatusI(usbp, KEYBOARD_IN_EPNUM)) {
       usbStartTransmitI(usbp, KEYBOARD_IN_EPNUM, (uint8_t *)&keyboard_report_sent, KEYBOARD_EPSIZE);
     }
     /* rearm the timer */
@@ -623,57 +909,39 @@ uint8_t keyboard_leds(void) {
   return (uint8_t)(keyboard_led_stats & 0xFF);
 }
 
-/* prepare and start sending a report IN
+/* queue a report IN, it is sent as soon as the endpoint is free
  * not callable from ISR or locked state */
 void send_keyboard(report_keyboard_t *report) {
-  osalSysLock();
-  if(usbGetDriverStateI(&USB_DRIVER) != USB_ACTIVE) {
-    osalSysUnlock();
-    return;
+  keyboard_queued_report_t entry = {
+    .report.keyboard = *report,
+    .offset = 0,
+    .keyboard = true,
+    .nkro = false
+  };
+  uint16_t event_time;
+  if (keyboard_take_event_time(&event_time)) {
+    entry.timed = true;
+    entry.event_delay = timer_elapsed(event_time);
   }
-  osalSysUnlock();
 
 #ifdef NKRO_ENABLE
   if(keymap_config.nkro && keyboard_protocol) {  /* NKRO protocol */
-    /* need to wait until the previous packet has made it through */
-    /* can rewrite this using the synchronous API, then would wait
-     * until *after* the packet has been transmitted. I think
-     * this is more efficient */
-    /* busy wait, should be short and not very common */
-    osalSysLock();
-    if(usbGetTransmitStatusI(&USB_DRIVER, SHARED_IN_EPNUM)) {
-      /* Need to either suspend, or loop and call unlock/lock during
-       * every iteration - otherwise the system will remain locked,
-       * no interrupts served, so USB not going through as well.
-       * Note: for suspend, need USB_USE_WAIT == TRUE in halconf.h */
-      osalThreadSuspendS(&(&USB_DRIVER)->epc[SHARED_IN_EPNUM]->in_state->thread);
-    }
-    usbStartTransmitI(&USB_DRIVER, SHARED_IN_EPNUM, (uint8_t *)report, sizeof(struct nkro_report));
-    osalSysUnlock();
+    entry.ep = SHARED_IN_EPNUM;
+    entry.size = sizeof(struct nkro_report);
+    entry.nkro = true;
   } else
 #endif /* NKRO_ENABLE */
   { /* regular protocol */
-    /* need to wait until the previous packet has made it through */
-    /* busy wait, should be short and not very common */
-    osalSysLock();
-    if(usbGetTransmitStatusI(&USB_DRIVER, KEYBOARD_IN_EPNUM)) {
-      /* Need to either suspend, or loop and call unlock/lock during
-       * every iteration - otherwise the system will remain locked,
-       * no interrupts served, so USB not going through as well.
-       * Note: for suspend, need USB_USE_WAIT == TRUE in halconf.h */
-      osalThreadSuspendS(&(&USB_DRIVER)->epc[KEYBOARD_IN_EPNUM]->in_state->thread);
-    }
-    uint8_t *data, size;
+    entry.ep = KEYBOARD_IN_EPNUM;
     if (keyboard_protocol) {
-      data = (uint8_t*)report;
-      size = KEYBOARD_REPORT_SIZE;
+      entry.size = KEYBOARD_REPORT_SIZE;
     } else {    /* boot protocol */
-      data = &report->mods;
-      size = 8;
+      entry.offset = (uint8_t)((uint8_t *)&report->mods - (uint8_t *)report);
+      entry.size = 8;
     }
-    usbStartTransmitI(&USB_DRIVER, KEYBOARD_IN_EPNUM, data, size);
-    osalSysUnlock();
   }
+
+  keyboard_report_post(&entry);
   keyboard_report_sent = *report;
 }
 
@@ -692,6 +960,20 @@ void mouse_in_cb(USBDriver *usbp, usbep_t ep) {
 }
 #endif
 
+#ifdef MOUSE_SHARED_EP
+/* shares the keyboard report queue with everything else on the endpoint */
+void send_mouse(report_mouse_t *report) {
+  keyboard_queued_report_t entry = {
+    .report.mouse = *report,
+    .ep = SHARED_IN_EPNUM,
+    .offset = 0,
+    .size = sizeof(report_mouse_t),
+    .keyboard = false
+  };
+  keyboard_report_post(&entry);
+}
+
+#else /* MOUSE_SHARED_EP */
 void send_mouse(report_mouse_t *report) {
   osalSysLock();
   if(usbGetDriverStateI(&USB_DRIVER) != USB_ACTIVE) {
@@ -712,6 +994,7 @@ void send_mouse(report_mouse_t *report) {
   usbStartTransmitI(&USB_DRIVER, MOUSE_IN_EPNUM, (uint8_t *)report, sizeof(report_mouse_t));
   osalSysUnlock();
 }
+#endif /* MOUSE_SHARED_EP */
 
 #else /* MOUSE_ENABLE */
 void send_mouse(report_mouse_t *report) {
@@ -726,9 +1009,9 @@ void send_mouse(report_mouse_t *report) {
 #ifdef SHARED_EP_ENABLE
 /* shared IN callback hander */
 void shared_in_cb(USBDriver *usbp, usbep_t ep) {
-  /* STUB */
-  (void)usbp;
-  (void)ep;
+  osalSysLockFromISR();
+  keyboard_report_done_i(usbp, ep);
+  osalSysUnlockFromISR();
 }
 #endif
 
@@ -738,20 +1021,19 @@ void shared_in_cb(USBDriver *usbp, usbep_t ep) {
  */
 
 #ifdef EXTRAKEY_ENABLE
+/* shares the keyboard report queue with everything else on the endpoint */
 static void send_extra_report(uint8_t report_id, uint16_t data) {
-  osalSysLock();
-  if(usbGetDriverStateI(&USB_DRIVER) != USB_ACTIVE) {
-    osalSysUnlock();
-    return;
-  }
-
-  report_extra_t report = {
-    .report_id = report_id,
-    .usage = data
+  keyboard_queued_report_t entry = {
+    .report.extra = {
+      .report_id = report_id,
+      .usage = data
+    },
+    .ep = SHARED_IN_EPNUM,
+    .offset = 0,
+    .size = sizeof(report_extra_t),
+    .keyboard = false
   };
-
-  usbStartTransmitI(&USB_DRIVER, SHARED_IN_EPNUM, (uint8_t *)&report, sizeof(report_extra_t));
-  osalSysUnlock();
+  keyboard_report_post(&entry);
 }
 
 void send_system(uint16_t data) {
@@ -778,10 +1060,10 @@ void send_consumer(uint16_t data) {
 
 #ifdef CONSOLE_ENABLE
 
+/* Only queues the character, console_task() sends it. The character is
+ * dropped when the queue is full. */
 int8_t sendchar(uint8_t c) {
-  // The previous implmentation had timeouts, but I think it's better to just slow down
-  // and make sure that everything is transferred, rather than dropping stuff
-  return chnWrite(&drivers.console_driver.driver, &c, 1);
+  return console_buffer_write(&c, 1) ? 0 : -1;
 }
 
 // Just a dummy function for now, this could be exposed as a weak function
@@ -800,6 +1082,13 @@ void console_task(void) {
         console_receive(buffer, size);
     }
   } while(size > 0);
+
+  // Send what the USB queue takes without waiting, the rest waits for
+  // the next call
+  size = console_buffer_peek(buffer, sizeof(buffer));
+  if (size > 0) {
+    console_buffer_consume(chnWriteTimeout(&drivers.console_driver.driver, buffer, size, TIME_IMMEDIATE));
+  }
 }
 
 #else /* CONSOLE_ENABLE */
@@ -830,6 +1119,9 @@ void raw_hid_receive( uint8_t *data, uint8_t length ) {
 	// Users should #include "raw_hid.h" in their own code
 	// and implement this function there. Leave this as weak linkage
 	// so users can opt to not handle data coming in.
+#ifdef PIPELINE_TRACE_ENABLE
+	pipeline_trace_raw_hid_receive( data, length );
+#endif
 }
 
 void raw_hid_task(void) {
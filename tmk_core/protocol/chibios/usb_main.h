@@ -43,6 +43,31 @@ void init_usb_driver(USBDriver *usbp);
 
 /* extern report_keyboard_t keyboard_report_sent; */
 
+/* Number of keyboard reports, and mouse and extra reports on the shared
+ * endpoint, that can wait for the host to poll. See usb_main.c for how a
+ * full queue is handled. */
+#ifndef KEYBOARD_REPORT_QUEUE_SIZE
+#define KEYBOARD_REPORT_QUEUE_SIZE 8
+#endif
+
+#if KEYBOARD_REPORT_QUEUE_SIZE < 2 || KEYBOARD_REPORT_QUEUE_SIZE > 255
+#error "KEYBOARD_REPORT_QUEUE_SIZE must be between 2 and 255"
+#endif
+
+/* Scan to host latency of keyboard reports, in ms from the scan of the key
+ * event that caused a report to the SOF of the frame that carried it */
+typedef struct {
+  uint32_t reports;     /* reports that made it to the host */
+  uint32_t total;       /* sum of all latencies */
+  uint16_t last;
+  uint16_t max;
+  uint32_t untimed;     /* reports not caused by a key event, not in the above */
+  uint32_t overflows;   /* reports that found the queue full */
+} keyboard_latency_t;
+
+void keyboard_latency_get(keyboard_latency_t *latency);
+void keyboard_latency_clear(void);
+
 /* keyboard IN request callback handler */
 void kbd_in_cb(USBDriver *usbp, usbep_t ep);
 
@@ -43,6 +43,9 @@
 #include "action.h"
 #include "led.h"
 #include "sendchar.h"
+#ifdef CONSOLE_ENABLE
+#include "console_buffer.h"
+#endif
 #include "debug.h"
 #ifdef SLEEP_LED_ENABLE
 #include "sleep_led.h"
@@ -52,9 +55,9 @@
 #include "usb_descriptor.h"
 #include "lufa.h"
 #include "quantum.h"
-#include <util/atomic.h>
 #include "outputselect.h"
 #include "rgblight_reconfig.h"
+#include "pipeline_trace.h"
 
 #ifdef NKRO_ENABLE
   #include "keycode_config.h"
@@ -187,6 +190,9 @@ void raw_hid_receive( uint8_t *data, uint8_t length )
 	// Users should #include "raw_hid.h" in their own code
 	// and implement this function there. Leave this as weak linkage
 	// so users can opt to not handle data coming in.
+#ifdef PIPELINE_TRACE_ENABLE
+	pipeline_trace_raw_hid_receive( data, length );
+#endif
 }
 
 /** \brief Raw HID Task
@@ -233,7 +239,8 @@ static void raw_hid_task(void)
 #ifdef CONSOLE_ENABLE
 /** \brief Console Task
  *
- * FIXME: Needs doc
+ * Sends a packet of the queued console output. Called from the SOF
+ * interrupt, sendchar() only queues the output.
  */
 static void Console_Task(void)
 {
@@ -241,6 +248,9 @@ static void Console_Task(void)
     if (USB_DeviceState != DEVICE_STATE_Configured)
         return;
 
+    if (!console_buffer_used())
+        return;
+
     uint8_t ep = Endpoint_GetCurrentEndpoint();
 
 #if 0
@@ -270,19 +280,23 @@ static void Console_Task(void)
 
     /* IN packet */
     Endpoint_SelectEndpoint(CONSOLE_IN_EPNUM);
-    if (!Endpoint_IsEnabled() || !Endpoint_IsConfigured()) {
+    if (!Endpoint_IsEnabled() || !Endpoint_IsConfigured() || !Endpoint_IsINReady()) {
         Endpoint_SelectEndpoint(ep);
         return;
     }
 
+    uint8_t data[CONSOLE_EPSIZE];
+    uint8_t length = console_buffer_peek(data, sizeof(data));
+    for (uint8_t i = 0; i < length; i++) {
+        Endpoint_Write_8(data[i]);
+    }
+
     // fill empty bank
     while (Endpoint_IsReadWriteAllowed())
         Endpoint_Write_8(0);
 
-    // flash senchar packet
-    if (Endpoint_IsINReady()) {
-        Endpoint_ClearIN();
-    }
+    Endpoint_ClearIN();
+    console_buffer_consume(length);
 
     Endpoint_SelectEndpoint(ep);
 }
@@ -372,27 +386,13 @@ void EVENT_USB_Device_WakeUp()
 
 
 #ifdef CONSOLE_ENABLE
-static bool console_flush = false;
-#define CONSOLE_FLUSH_SET(b)   do { \
-  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {\
-    console_flush = b; \
-  } \
-} while (0)
-
 /** \brief Event USB Device Start Of Frame
  *
- * FIXME: Needs doc
- * called every 1ms
+ * Sends the queued console output, called every 1ms
  */
 void EVENT_USB_Device_StartOfFrame(void)
 {
-    static uint8_t count;
-    if (++count % 50) return;
-    count = 0;
-
-    if (!console_flush) return;
     Console_Task();
-    console_flush = false;
 }
 
 #endif
@@ -809,66 +809,14 @@ static void send_consumer(uint16_t data)
  * sendchar
  ******************************************************************************/
 #ifdef CONSOLE_ENABLE
-#define SEND_TIMEOUT 5
 /** \brief Send Char
  *
- * FIXME: Needs doc
+ * Queues the character for Console_Task(), never waits for USB. The
+ * character is dropped when the queue is full.
  */
 int8_t sendchar(uint8_t c)
 {
-    // Not wait once timeouted.
-    // Because sendchar() is called so many times, waiting each call causes big lag.
-    static bool timeouted = false;
-
-    // prevents Console_Task() from running during sendchar() runs.
-    // or char will be lost. These two function is mutually exclusive.
-    CONSOLE_FLUSH_SET(false);
-
-    if (USB_DeviceState != DEVICE_STATE_Configured)
-        return -1;
-
-    uint8_t ep = Endpoint_GetCurrentEndpoint();
-    Endpoint_SelectEndpoint(CONSOLE_IN_EPNUM);
-    if (!Endpoint_IsEnabled() || !Endpoint_IsConfigured()) {
-        goto ERROR_EXIT;
-    }
-
-    if (timeouted && !Endpoint_IsReadWriteAllowed()) {
-        goto ERROR_EXIT;
-    }
-
-    timeouted = false;
-
-    uint8_t timeout = SEND_TIMEOUT;
-    while (!Endpoint_IsReadWriteAllowed()) {
-        if (USB_DeviceState != DEVICE_STATE_Configured) {
-            goto ERROR_EXIT;
-        }
-        if (Endpoint_IsStalled()) {
-            goto ERROR_EXIT;
-        }
-        if (!(timeout--)) {
-            timeouted = true;
-            goto ERROR_EXIT;
-        }
-        _delay_ms(1);
-    }
-
-    Endpoint_Write_8(c);
-
-    // send when bank is full
-    if (!Endpoint_IsReadWriteAllowed()) {
-        while (!(Endpoint_IsINReady()));
-        Endpoint_ClearIN();
-    } else {
-        CONSOLE_FLUSH_SET(true);
-    }
-
-    Endpoint_SelectEndpoint(ep);
-    return 0;
-ERROR_EXIT:
-    Endpoint_SelectEndpoint(ep);
-    return -1;
+    return console_buffer_write(&c, 1) ? 0 : -1;
 }
 #else
 int8_t sendchar(uint8_t c)
@@ -1084,7 +1032,9 @@ int main(void)
 #endif
 
 #if defined(RGBLIGHT_ANIMATIONS) & defined(RGBLIGHT_ENABLE)
+        PIPELINE_TRACE_BEGIN(PIPELINE_TRACE_RGB);
         rgblight_task();
+        PIPELINE_TRACE_END(PIPELINE_TRACE_RGB);
 #endif
 
 #ifdef MODULE_ADAFRUIT_BLE
@@ -230,6 +230,27 @@ enum usb_endpoints {
 #define CDC_NOTIFICATION_EPSIZE     8
 #define CDC_EPSIZE                  16
 
+/* Polling interval in ms the host is asked to use for the HID endpoints.
+ * 1 is the fastest a full-speed device can be polled (1 kHz). */
+#ifndef USB_POLLING_INTERVAL_MS
+#   define USB_POLLING_INTERVAL_MS  10
+#endif
+#ifndef KEYBOARD_POLLING_INTERVAL_MS
+#   define KEYBOARD_POLLING_INTERVAL_MS USB_POLLING_INTERVAL_MS
+#endif
+#ifndef MOUSE_POLLING_INTERVAL_MS
+#   define MOUSE_POLLING_INTERVAL_MS USB_POLLING_INTERVAL_MS
+#endif
+#ifndef SHARED_POLLING_INTERVAL_MS
+#   define SHARED_POLLING_INTERVAL_MS USB_POLLING_INTERVAL_MS
+#endif
+
+#if KEYBOARD_POLLING_INTERVAL_MS < 1 || KEYBOARD_POLLING_INTERVAL_MS > 255 || \
+    MOUSE_POLLING_INTERVAL_MS < 1 || MOUSE_POLLING_INTERVAL_MS > 255 || \
+    SHARED_POLLING_INTERVAL_MS < 1 || SHARED_POLLING_INTERVAL_MS > 255
+# error USB polling intervals must be between 1 and 255 ms
+#endif
+
 uint16_t get_usb_descriptor(const uint16_t wValue,
                             const uint16_t wIndex,
                             const void** const DescriptorAddress);
@@ -268,6 +268,17 @@ gccversion :
 	$(eval CMD=$(NM) -n $< > $@ )
 	@$(BUILD_CMD)
 
+ifdef KEYMAP_ACTIONS_C
+# Generate the keymap action table from the compiled keymap.
+$(KEYMAP_ACTIONS_C): $(KEYMAP_ACTIONS_KEYMAP_OBJ) $(TOP_DIR)/util/generate_keymap_actions.sh
+	@mkdir -p $(@D)
+	@$(SILENT) || printf "$(MSG_GENERATING) $@" | $(AWK_CMD)
+	$(eval CMD=$(TOP_DIR)/util/generate_keymap_actions.sh "$(OBJDUMP)" "$(OBJCOPY)" $< $@)
+	@$(BUILD_CMD)
+
+keymap_actions: $(KEYMAP_ACTIONS_C)
+endif
+
 %.bin: %.elf
 	@$(SILENT) || printf "$(MSG_BIN) $@" | $(AWK_CMD)
 	$(eval CMD=$(BIN) $< $@ || exit 0)
@@ -396,6 +407,6 @@ $(eval $(foreach OUTPUT,$(OUTPUTS),$(shell mkdir -p $(OUTPUT) 2>/dev/null)))
 
 # Listing of phony targets.
 .PHONY : all finish sizebefore sizeafter qmkversion \
-gccversion build elf hex eep lss sym coff extcoff \
+gccversion build elf hex eep lss sym coff extcoff keymap_actions \
 clean clean_list debug gdb-config show_path \
 program teensy dfu flip dfu-ee flip-ee dfu-start
@@ -0,0 +1,128 @@
+/*
+Copyright 2018 QMK Firmware contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gtest/gtest.h"
+#include <cstring>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "console_buffer.h"
+}
+
+static bool write_string(const char *str) {
+    return console_buffer_write(reinterpret_cast<const uint8_t*>(str), strlen(str));
+}
+
+static std::string drain(void) {
+    std::string out;
+    uint8_t data[32];
+    uint8_t length;
+    while ((length = console_buffer_peek(data, sizeof(data)))) {
+        out.append(reinterpret_cast<char*>(data), length);
+        console_buffer_consume(length);
+    }
+    return out;
+}
+
+static std::vector<uint8_t> drain_bytes(void) {
+    std::string out = drain();
+    return std::vector<uint8_t>(out.begin(), out.end());
+}
+
+class ConsoleBuffer : public testing::Test {
+protected:
+    void SetUp() override {
+        console_buffer_clear();
+    }
+};
+
+TEST_F(ConsoleBuffer, ReadsBackWhatWasWritten) {
+    EXPECT_TRUE(write_string("hello "));
+    EXPECT_TRUE(write_string("world"));
+    EXPECT_EQ(console_buffer_used(), 11);
+    EXPECT_EQ(drain(), "hello world");
+    EXPECT_EQ(console_buffer_used(), 0);
+}
+
+TEST_F(ConsoleBuffer, PeekLeavesTheDataQueued) {
+    write_string("abcdef");
+    uint8_t data[4];
+    EXPECT_EQ(console_buffer_peek(data, sizeof(data)), 4);
+    EXPECT_EQ(memcmp(data, "abcd", 4), 0);
+    console_buffer_consume(2);
+    EXPECT_EQ(drain(), "cdef");
+}
+
+TEST_F(ConsoleBuffer, WrapsAround) {
+    std::string expected, out;
+    for (int i = 0; i < 100; i++) {
+        std::string line = "line " + std::to_string(i) + "\n";
+        ASSERT_TRUE(write_string(line.c_str()));
+        expected += line;
+        out += drain();
+    }
+    EXPECT_EQ(out, expected);
+}
+
+TEST_F(ConsoleBuffer, DropsWhatDoesNotFitAndSaysSo) {
+    uint16_t dropped = console_buffer_dropped();
+    std::string fill(CONSOLE_BUFFER_SIZE - 1, 'x');
+    std::string too_long(CONSOLE_BUFFER_SIZE + 1, 'z');
+    EXPECT_TRUE(write_string(fill.c_str()));
+    EXPECT_TRUE(write_string("y"));
+    EXPECT_FALSE(write_string("z"));
+    EXPECT_FALSE(write_string(too_long.c_str()));
+    EXPECT_FALSE(write_string("z"));
+    EXPECT_EQ(console_buffer_dropped(), dropped + 3);
+
+    EXPECT_EQ(drain(), fill + "y");
+    EXPECT_TRUE(write_string("next"));
+    EXPECT_EQ(drain(), "\r\n[dropped 3]\r\nnext");
+    EXPECT_TRUE(write_string("more"));
+    EXPECT_EQ(drain(), "more");
+}
+
+TEST_F(ConsoleBuffer, LogsFormatAddressAndArguments) {
+    static const char format[] = "%s: %-3d %lu%%\n";
+    console_log(format, "ab", -2, 70000L);
+
+    std::vector<uint8_t> expected = {CONSOLE_LOG_SYNC, 0};
+    uintptr_t address = reinterpret_cast<uintptr_t>(format);
+    for (unsigned i = 0; i < sizeof(const char*); i++) {
+        expected.push_back(i < 4 ? (address >> (i * 8)) & 0xFF : 0);
+    }
+    expected.insert(expected.end(), {'a', 'b', 0});
+    for (int value : {-2}) {
+        for (unsigned i = 0; i < sizeof(int); i++) {
+            expected.push_back((static_cast<unsigned>(value) >> (i * 8)) & 0xFF);
+        }
+    }
+    expected.insert(expected.end(), {0x70, 0x11, 0x01, 0x00});
+    expected[1] = expected.size() - 2;
+    EXPECT_EQ(drain_bytes(), expected);
+}
+
+TEST_F(ConsoleBuffer, DropsLogMessagesThatAreTooLong) {
+    uint16_t dropped = console_buffer_dropped();
+    console_log("%s", "a string longer than any log message can be");
+    EXPECT_EQ(console_buffer_used(), 0);
+    EXPECT_EQ(console_buffer_dropped(), dropped + 1);
+    drain();
+    write_string("x");
+    drain();
+}
@@ -0,0 +1,103 @@
+/*
+Copyright 2018 QMK Firmware contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include "pipeline_trace.h"
+}
+
+static uint32_t read_le(const uint8_t *p, uint8_t size) {
+    uint32_t value = 0;
+    while (size--) {
+        value = (value << 8) | p[size];
+    }
+    return value;
+}
+
+class PipelineTrace : public testing::Test {
+protected:
+    void SetUp() override {
+        uint8_t packet[32];
+        while (pipeline_trace_read_packet(packet, sizeof(packet))) {}
+    }
+};
+
+TEST_F(PipelineTrace, ReadsRecordsIntoAPacket) {
+    PIPELINE_TRACE_BEGIN(PIPELINE_TRACE_MATRIX_SCAN);
+    PIPELINE_TRACE_BEGIN(PIPELINE_TRACE_DEBOUNCE);
+    PIPELINE_TRACE_END(PIPELINE_TRACE_DEBOUNCE);
+    PIPELINE_TRACE_END(PIPELINE_TRACE_MATRIX_SCAN);
+
+    uint8_t packet[32];
+    EXPECT_EQ(pipeline_trace_read_packet(packet, sizeof(packet)), 4);
+    EXPECT_EQ(packet[0], PIPELINE_TRACE_RAW_HID_ID);
+    EXPECT_EQ(packet[1], 4);
+    EXPECT_EQ(read_le(&packet[2], 2), 0u);
+    EXPECT_EQ(read_le(&packet[4], 4), 1000000000u);
+    EXPECT_EQ(packet[8], PIPELINE_TRACE_MATRIX_SCAN);
+    EXPECT_EQ(packet[13], PIPELINE_TRACE_DEBOUNCE);
+    EXPECT_EQ(packet[18], PIPELINE_TRACE_DEBOUNCE | PIPELINE_TRACE_END_BIT);
+    EXPECT_EQ(packet[23], PIPELINE_TRACE_MATRIX_SCAN | PIPELINE_TRACE_END_BIT);
+    EXPECT_EQ(packet[28], 0);
+
+    uint32_t last = read_le(&packet[9], 4);
+    for (int i = 1; i < 4; i++) {
+        uint32_t time = read_le(&packet[9 + i * 5], 4);
+        // Wraps to a huge difference if the clock goes backwards
+        EXPECT_LT(time - last, 1000000000u);
+        last = time;
+    }
+    EXPECT_EQ(pipeline_trace_read_packet(packet, sizeof(packet)), 0);
+}
+
+TEST_F(PipelineTrace, SplitsRecordsOverPackets) {
+    for (int i = 0; i < 6; i++) {
+        PIPELINE_TRACE_BEGIN(PIPELINE_TRACE_ACTION_EXEC);
+    }
+    uint8_t packet[32];
+    // Only 4 records fit in 32 bytes
+    EXPECT_EQ(pipeline_trace_read_packet(packet, sizeof(packet)), 4);
+    EXPECT_EQ(pipeline_trace_read_packet(packet, sizeof(packet)), 2);
+    EXPECT_EQ(pipeline_trace_read_packet(packet, sizeof(packet)), 0);
+    EXPECT_EQ(packet[1], 0);
+}
+
+TEST_F(PipelineTrace, OverwritesTheOldestRecords) {
+    PIPELINE_TRACE_BEGIN(PIPELINE_TRACE_MATRIX_SCAN);
+    PIPELINE_TRACE_BEGIN(PIPELINE_TRACE_MATRIX_SCAN);
+    for (int i = 0; i < 8; i++) {
+        PIPELINE_TRACE_BEGIN(PIPELINE_TRACE_REPORT_SEND);
+    }
+    uint8_t packet[32];
+    EXPECT_EQ(pipeline_trace_read_packet(packet, sizeof(packet)), 4);
+    EXPECT_EQ(read_le(&packet[2], 2), 2u);
+    EXPECT_EQ(packet[8], PIPELINE_TRACE_REPORT_SEND);
+    EXPECT_EQ(pipeline_trace_read_packet(packet, sizeof(packet)), 4);
+    EXPECT_EQ(read_le(&packet[2], 2), 0u);
+}
+
+TEST_F(PipelineTrace, NeedsRoomForTheHeaderAndARecord) {
+    PIPELINE_TRACE_BEGIN(PIPELINE_TRACE_RGB);
+    uint8_t packet[4];
+    EXPECT_EQ(pipeline_trace_read_packet(packet, sizeof(packet)), 0);
+    uint8_t header[8];
+    EXPECT_EQ(pipeline_trace_read_packet(header, sizeof(header)), 0);
+    uint8_t large[13];
+    EXPECT_EQ(pipeline_trace_read_packet(large, sizeof(large)), 1);
+    EXPECT_EQ(large[8], PIPELINE_TRACE_RGB);
+}
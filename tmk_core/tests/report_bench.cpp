@@ -0,0 +1,69 @@
+/*
+Copyright 2018 QMK Firmware contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gtest/gtest.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+extern "C" {
+#include "report.h"
+#include "keycode_config.h"
+
+// Normally owned by the protocol and the keymap; the legacy functions read them
+uint8_t keyboard_protocol = 1;
+keymap_config_t keymap_config;
+}
+
+// Prints the cost of a press, an anykey check and a release with the legacy
+// report functions and with the report builder
+TEST(ReportBench, LegacyAgainstBuilder) {
+    const unsigned rounds = 200000;
+    for (int nkro = 0; nkro < 2; nkro++) {
+        keymap_config.raw = 0;
+        keymap_config.nkro = nkro;
+        volatile unsigned sink = 0;
+
+        report_keyboard_t legacy;
+        memset(&legacy, 0, sizeof(legacy));
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned i = 0; i < rounds; i++) {
+            uint8_t key = KC_A + (i & 31);
+            add_key_to_report(&legacy, key);
+            sink += has_anykey(&legacy);
+            del_key_from_report(&legacy, KC_A + ((i + 29) & 31));
+        }
+        auto legacy_time = std::chrono::steady_clock::now() - start;
+
+        report_builder_t builder;
+        report_builder_init(&builder, nkro);
+        start = std::chrono::steady_clock::now();
+        for (unsigned i = 0; i < rounds; i++) {
+            uint8_t key = KC_A + (i & 31);
+            report_builder_add_key(&builder, key);
+            sink += report_builder_key_count(&builder);
+            report_builder_del_key(&builder, KC_A + ((i + 29) & 31));
+        }
+        auto builder_time = std::chrono::steady_clock::now() - start;
+
+        double legacy_ns = std::chrono::duration<double, std::nano>(legacy_time).count() / rounds;
+        double builder_ns = std::chrono::duration<double, std::nano>(builder_time).count() / rounds;
+        printf("%s: legacy %.1f ns, builder %.1f ns per press/anykey/release\n",
+               nkro ? "NKRO" : "6KRO", legacy_ns, builder_ns);
+        (void)sink;
+    }
+}
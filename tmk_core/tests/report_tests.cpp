@@ -0,0 +1,157 @@
+/*
+Copyright 2018 QMK Firmware contributors
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+extern "C" {
+#include "report.h"
+#include "keycode_config.h"
+
+// Normally owned by the protocol and the keymap; the legacy functions read them
+uint8_t keyboard_protocol = 1;
+keymap_config_t keymap_config;
+}
+
+static void set_legacy_nkro(bool nkro) {
+    keymap_config.raw = 0;
+    keymap_config.nkro = nkro;
+}
+
+static std::vector<uint8_t> boot_keys(const report_keyboard_t& report) {
+    std::vector<uint8_t> keys;
+    for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
+        if (report.keys[i]) {
+            keys.push_back(report.keys[i]);
+        }
+    }
+    std::sort(keys.begin(), keys.end());
+    return keys;
+}
+
+// Deterministic key stream with more presses than releases early on
+static uint8_t next_random(uint32_t& state) {
+    state = state * 1103515245 + 12345;
+    return state >> 16;
+}
+
+TEST(ReportBuilder, BootLayoutKeepsPressOrderAndPacksOnRelease) {
+    report_builder_t builder;
+    report_builder_init(&builder, false);
+    report_builder_add_key(&builder, KC_A);
+    report_builder_add_key(&builder, KC_B);
+    report_builder_add_key(&builder, KC_C);
+    report_builder_add_key(&builder, KC_B);
+    EXPECT_EQ(report_builder_key_count(&builder), 3);
+    report_builder_del_key(&builder, KC_A);
+    EXPECT_EQ(report_builder_key_count(&builder), 2);
+    EXPECT_EQ(builder.report.keys[0], KC_B);
+    EXPECT_EQ(builder.report.keys[1], KC_C);
+    EXPECT_EQ(builder.report.keys[2], 0);
+    report_builder_del_key(&builder, KC_D);
+    EXPECT_EQ(report_builder_key_count(&builder), 2);
+}
+
+TEST(ReportBuilder, FullBootLayoutDropsNewKeys) {
+    report_builder_t builder;
+    report_builder_init(&builder, false);
+    for (uint8_t key = KC_A; key < KC_A + KEYBOARD_REPORT_KEYS + 2; key++) {
+        report_builder_add_key(&builder, key);
+    }
+    EXPECT_EQ(report_builder_key_count(&builder), KEYBOARD_REPORT_KEYS);
+    EXPECT_EQ(builder.report.keys[KEYBOARD_REPORT_KEYS - 1], KC_A + KEYBOARD_REPORT_KEYS - 1);
+}
+
+TEST(ReportBuilder, NkroCountsBitsAndIgnoresRepeats) {
+    report_builder_t builder;
+    report_builder_init(&builder, true);
+    report_builder_add_key(&builder, KC_A);
+    report_builder_add_key(&builder, KC_B);
+    report_builder_add_key(&builder, KC_A);
+    report_builder_add_key(&builder, KC_LANG1);
+    EXPECT_EQ(report_builder_key_count(&builder), 3);
+    // bits[0] holds both KC_A and KC_B, so a byte scan would count 2
+    EXPECT_EQ(builder.report.nkro.bits[KC_A >> 3], (1 << (KC_A & 7)) | (1 << (KC_B & 7)));
+    report_builder_del_key(&builder, KC_B);
+    report_builder_del_key(&builder, KC_B);
+    EXPECT_EQ(report_builder_key_count(&builder), 2);
+    report_builder_clear_keys(&builder);
+    EXPECT_EQ(report_builder_key_count(&builder), 0);
+    for (uint8_t i = 0; i < KEYBOARD_REPORT_BITS; i++) {
+        EXPECT_EQ(builder.report.nkro.bits[i], 0);
+    }
+}
+
+TEST(ReportBuilder, SwitchingLayoutCarriesHeldKeysAndMods) {
+    report_builder_t builder;
+    report_builder_init(&builder, false);
+    builder.report.mods = MOD_BIT(KC_LSHIFT);
+    report_builder_add_key(&builder, KC_Z);
+    report_builder_add_key(&builder, KC_A);
+    report_builder_set_nkro(&builder, true);
+    EXPECT_TRUE(builder.nkro);
+    EXPECT_EQ(report_builder_key_count(&builder), 2);
+    EXPECT_EQ(builder.report.mods, MOD_BIT(KC_LSHIFT));
+    EXPECT_TRUE(builder.report.nkro.bits[KC_Z >> 3] & (1 << (KC_Z & 7)));
+    EXPECT_TRUE(builder.report.nkro.bits[KC_A >> 3] & (1 << (KC_A & 7)));
+
+    for (uint8_t key = KC_B; key < KC_B + KEYBOARD_REPORT_KEYS; key++) {
+        report_builder_add_key(&builder, key);
+    }
+    report_builder_set_nkro(&builder, false);
+    EXPECT_FALSE(builder.nkro);
+    EXPECT_EQ(report_builder_key_count(&builder), KEYBOARD_REPORT_KEYS);
+    EXPECT_EQ(builder.report.mods, MOD_BIT(KC_LSHIFT));
+    EXPECT_EQ(builder.report.keys[0], KC_A);
+    EXPECT_EQ(builder.report.keys[KEYBOARD_REPORT_KEYS - 1], KC_B + KEYBOARD_REPORT_KEYS - 2);
+}
+
+TEST(ReportBuilder, MatchesLegacyFunctionsOnRandomStreams) {
+    for (int nkro = 0; nkro < 2; nkro++) {
+        set_legacy_nkro(nkro);
+        report_keyboard_t legacy;
+        memset(&legacy, 0, sizeof(legacy));
+        report_builder_t builder;
+        report_builder_init(&builder, nkro);
+        uint32_t state = 1;
+        for (unsigned step = 0; step < 20000; step++) {
+            uint8_t r = next_random(state);
+            // Small key range so that presses, repeats and releases all happen
+            uint8_t key = KC_A + (r & 15);
+            if (r & 0x80) {
+                add_key_to_report(&legacy, key);
+                report_builder_add_key(&builder, key);
+            } else {
+                del_key_from_report(&legacy, key);
+                report_builder_del_key(&builder, key);
+            }
+            if (nkro) {
+                ASSERT_EQ(0, memcmp(legacy.nkro.bits, builder.report.nkro.bits, KEYBOARD_REPORT_BITS)) << "step " << step;
+                unsigned bits = 0;
+                for (uint8_t i = 0; i < KEYBOARD_REPORT_BITS; i++) {
+                    bits += __builtin_popcount(legacy.nkro.bits[i]);
+                }
+                ASSERT_EQ(bits, report_builder_key_count(&builder)) << "step " << step;
+            } else {
+                ASSERT_EQ(boot_keys(legacy), boot_keys(builder.report)) << "step " << step;
+                ASSERT_EQ(has_anykey(&legacy), report_builder_key_count(&builder)) << "step " << step;
+            }
+        }
+    }
+}
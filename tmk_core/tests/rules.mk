@@ -0,0 +1,24 @@
+tmk_report_SRC :=\
+	$(TMK_PATH)/tests/report_tests.cpp \
+	$(TMK_PATH)/common/report.c \
+	$(TMK_PATH)/common/util.c
+
+# No USB stack in the native build, so the NKRO report size is given here
+tmk_report_DEFS := -DNKRO_ENABLE -DKEYBOARD_REPORT_BITS=30 -DNO_DEBUG
+
+tmk_report_bench_SRC :=\
+	$(TMK_PATH)/tests/report_bench.cpp \
+	$(TMK_PATH)/common/report.c \
+	$(TMK_PATH)/common/util.c
+
+tmk_report_bench_DEFS := $(tmk_report_DEFS)
+
+tmk_console_SRC :=\
+	$(TMK_PATH)/tests/console_buffer_tests.cpp \
+	$(TMK_PATH)/common/console_buffer.c
+
+tmk_trace_SRC :=\
+	$(TMK_PATH)/tests/pipeline_trace_tests.cpp \
+	$(TMK_PATH)/common/pipeline_trace.c
+
+tmk_trace_DEFS := -DPIPELINE_TRACE_ENABLE -DPIPELINE_TRACE_SIZE=8
@@ -0,0 +1,7 @@
+TEST_LIST +=\
+	tmk_report \
+	tmk_console \
+	tmk_trace
+
+BENCH_LIST +=\
+	tmk_report_bench
@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+# Copyright 2018 QMK Firmware contributors
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+"""Format the console output of a firmware built with CONSOLE_BINARY_LOG.
+
+The firmware sends the address of each format string and the raw
+arguments, see tmk_core/common/console_buffer.h. The strings are looked up
+in the ELF file of the same build.
+
+    util/console_log_decode.py .build/planck_rev4_default.elf < /dev/hidraw3
+"""
+
+import struct
+import sys
+
+CONSOLE_LOG_SYNC = 0xFE
+EM_AVR = 83
+
+
+class Firmware:
+    def __init__(self, path):
+        with open(path, 'rb') as f:
+            self.elf = f.read()
+        if self.elf[:4] != b'\x7fELF' or self.elf[4] != 1 or self.elf[5] != 1:
+            sys.exit('%s: not a 32-bit little endian ELF file' % path)
+        machine, = struct.unpack_from('<H', self.elf, 18)
+        # AVR has 16-bit ints and pointers, the ARM boards 32-bit ones
+        self.int_size = self.ptr_size = 2 if machine == EM_AVR else 4
+        shoff, = struct.unpack_from('<I', self.elf, 32)
+        shentsize, shnum = struct.unpack_from('<HH', self.elf, 46)
+        self.sections = []
+        for i in range(shnum):
+            _, sh_type, flags, addr, offset, size = struct.unpack_from('<IIIIII', self.elf, shoff + i * shentsize)
+            # allocated sections with contents in the file
+            if sh_type == 1 and flags & 2:
+                self.sections.append((addr, offset, size))
+
+    def string(self, address):
+        for addr, offset, size in self.sections:
+            if addr <= address < addr + size:
+                start = offset + address - addr
+                end = self.elf.index(b'\0', start)
+                return self.elf[start:end].decode('latin-1')
+        return '<unknown string 0x%x>' % address
+
+
+def read_uint(data, pos, size):
+    return int.from_bytes(data[pos:pos + size], 'little'), pos + size
+
+
+def format_message(firmware, fmt, args):
+    out = []
+    pos = 0
+    i = 0
+    while i < len(fmt):
+        c = fmt[i]
+        i += 1
+        if c != '%':
+            out.append(c)
+            continue
+        spec = ''
+        while i < len(fmt) and (fmt[i] == '-' or fmt[i].isdigit()):
+            spec += fmt[i]
+            i += 1
+        size = firmware.int_size
+        if i < len(fmt) and fmt[i] in 'lL':
+            size = 4
+            i += 1
+        if i >= len(fmt):
+            break
+        c = fmt[i]
+        i += 1
+        left = spec.startswith('-')
+        spec = spec.lstrip('-')
+        fill = '0' if spec.startswith('0') else ' '
+        width = int(spec) if spec else 0
+        if c == 's':
+            end = args.index(b'\0', pos)
+            text = args[pos:end].decode('latin-1')
+            pos = end + 1
+        elif c == 'S':
+            address, pos = read_uint(args, pos, firmware.ptr_size)
+            text = firmware.string(address)
+        elif c in 'cdiuxXbo':
+            value, pos = read_uint(args, pos, size)
+            if c == 'c':
+                text = chr(value & 0xFF)
+            elif c in 'di':
+                if value >= 1 << (size * 8 - 1):
+                    value -= 1 << (size * 8)
+                text = str(value)
+            else:
+                text = {'u': '%d', 'x': '%x', 'X': '%X', 'o': '%o', 'b': '{:b}'}[c]
+                text = text.format(value) if c == 'b' else text % value
+            text = text.rjust(width, fill) if not left else text.ljust(width)
+        else:
+            text = c
+        out.append(text)
+    return ''.join(out)
+
+
+def decode(firmware, stream, output):
+    data = b''
+    while True:
+        chunk = stream.read1(64)
+        if not chunk:
+            break
+        data += chunk
+        while True:
+            start = data.find(bytes([CONSOLE_LOG_SYNC]))
+            if start < 0 or start + 2 > len(data):
+                data = data[start:] if start >= 0 else b''
+                break
+            length = data[start + 1]
+            if start + 2 + length > len(data):
+                data = data[start:]
+                break
+            message = data[start + 2:start + 2 + length]
+            data = data[start + 2 + length:]
+            address, pos = read_uint(message, 0, firmware.ptr_size)
+            if address == 0:
+                dropped, _ = read_uint(message, pos, 2)
+                output.write('\n[dropped %d]\n' % dropped)
+            else:
+                output.write(format_message(firmware, firmware.string(address), message[pos:]))
+            output.flush()
+
+
+def main():
+    if len(sys.argv) not in (2, 3):
+        sys.exit('usage: %s <firmware.elf> [captured console output]' % sys.argv[0])
+    firmware = Firmware(sys.argv[1])
+    stream = open(sys.argv[2], 'rb') if len(sys.argv) == 3 else sys.stdin.buffer
+    decode(firmware, stream, sys.stdout)
+
+
+if __name__ == '__main__':
+    main()
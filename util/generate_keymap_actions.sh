@@ -0,0 +1,47 @@
+#!/bin/bash
+#
+# Turns the keymaps array of a compiled keymap object into a C file with the
+# matching table of action codes. Each keycode is written out as
+# KEYMAP_STATIC_ACTION(keycode), so the compiler does the conversion and
+# this script doesn't need to know anything about keycodes.
+#
+# usage: generate_keymap_actions.sh <objdump> <objcopy> <keymap.o> <output.c>
+
+set -e
+
+if [ $# -ne 4 ]; then
+	echo "usage: $0 <objdump> <objcopy> <keymap.o> <output.c>" >&2
+	exit 1
+fi
+
+OBJDUMP=$1
+OBJCOPY=$2
+OBJECT=$3
+OUTPUT=$4
+
+# objdump -t: <value> <flags...> <section> <size> <name>
+read -r VALUE SECTION SIZE < <("$OBJDUMP" -t "$OBJECT" | awk '$NF == "keymaps" && $(NF-2) != "*UND*" { print $1, $(NF-2), $(NF-1) }')
+if [ -z "$SECTION" ]; then
+	echo "$0: no keymaps array in $OBJECT" >&2
+	exit 1
+fi
+
+SECTION_BIN=$(mktemp)
+trap 'rm -f "$SECTION_BIN"' EXIT
+"$OBJCOPY" -O binary --only-section="$SECTION" "$OBJECT" "$SECTION_BIN"
+
+{
+	echo "/* Generated from $OBJECT by $(basename "$0"), do not edit */"
+	echo '#include "keymap_actions.h"'
+	echo
+	echo 'const uint16_t PROGMEM keymap_actions[] = {'
+	# Both AVR and ARM are little endian
+	od -An -v -tu1 -j $((16#$VALUE)) -N $((16#$SIZE)) "$SECTION_BIN" | tr -s ' ' '\n' | grep -v '^$' | \
+		awk 'NR % 2 { low = $1; next }
+		     { printf "%sKEYMAP_STATIC_ACTION(0x%04X),", (n % 8) ? " " : "    ", $1 * 256 + low }
+		     ++n % 8 == 0 { printf "\n" }
+		     END { if (n % 8) printf "\n" }'
+	echo '};'
+	echo
+	echo 'const uint8_t keymap_actions_layers = sizeof(keymap_actions) / sizeof(keymap_actions[0]) / (MATRIX_ROWS * MATRIX_COLS);'
+} > "$OUTPUT"
@@ -0,0 +1,159 @@
+#!/usr/bin/env python3
+# Copyright 2018 QMK Firmware contributors
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+"""Print how long each stage of the scan loop takes, for a firmware built
+with PIPELINE_TRACE_ENABLE = yes.
+
+The firmware keeps start and end timestamps of the traced stages and sends
+them on raw HID requests, see tmk_core/common/pipeline_trace.h. This reads
+them until interrupted, or from a file of captured 32 byte packets, and
+prints a latency histogram per stage.
+
+    util/pipeline_trace_decode.py /dev/hidraw4
+    util/pipeline_trace_decode.py --dump trace.bin
+"""
+
+import argparse
+import os
+import sys
+import time
+
+PIPELINE_TRACE_RAW_HID_ID = 0x54
+PIPELINE_TRACE_END_BIT = 0x80
+PACKET_SIZE = 32
+HEADER_SIZE = 8
+RECORD_SIZE = 5
+
+# enum pipeline_trace_stage
+STAGES = ['matrix_scan', 'debounce', 'action_exec', 'process_record', 'report_send', 'rgb', 'visualizer']
+
+
+def parse_packet(packet):
+    """Return (lost, tick_hz, [(stage, time)]) of a readout packet."""
+    if len(packet) < HEADER_SIZE or packet[0] != PIPELINE_TRACE_RAW_HID_ID:
+        return None
+    count = packet[1]
+    lost = int.from_bytes(packet[2:4], 'little')
+    tick_hz = int.from_bytes(packet[4:8], 'little')
+    records = []
+    for i in range(count):
+        pos = HEADER_SIZE + i * RECORD_SIZE
+        if pos + RECORD_SIZE > len(packet):
+            break
+        records.append((packet[pos], int.from_bytes(packet[pos + 1:pos + 5], 'little')))
+    return lost, tick_hz, records
+
+
+class Stats:
+    def __init__(self):
+        self.open = {}
+        self.durations = {}
+        self.lost = 0
+        self.unmatched = 0
+        self.tick_hz = 0
+
+    def reset_open(self):
+        self.unmatched += sum(len(starts) for starts in self.open.values())
+        self.open = {}
+
+    def add_packet(self, packet):
+        parsed = parse_packet(packet)
+        if parsed is None:
+            return 0
+        lost, tick_hz, records = parsed
+        self.tick_hz = tick_hz
+        if lost:
+            # Starts before the gap may have lost their end
+            self.lost += lost
+            self.reset_open()
+        for stage, timestamp in records:
+            starts = self.open.setdefault(stage & ~PIPELINE_TRACE_END_BIT, [])
+            if not stage & PIPELINE_TRACE_END_BIT:
+                # Stages nest, process_record runs inside action_exec and
+                # may send a report
+                starts.append(timestamp)
+            elif starts:
+                ticks = (timestamp - starts.pop()) & 0xFFFFFFFF
+                self.durations.setdefault(stage & ~PIPELINE_TRACE_END_BIT, []).append(ticks)
+            else:
+                self.unmatched += 1
+        return len(records)
+
+    def report(self, output):
+        if not self.tick_hz:
+            output.write('The firmware did not report its clock rate\n')
+            return
+        output.write('%d records lost, %d unmatched\n' % (self.lost, self.unmatched))
+        for stage in sorted(self.durations):
+            us = [ticks * 1000000.0 / self.tick_hz for ticks in self.durations[stage]]
+            name = STAGES[stage] if stage < len(STAGES) else 'stage %d' % stage
+            output.write('\n%s: %d times, min %.1f us, avg %.1f us, max %.1f us\n' %
+                         (name, len(us), min(us), sum(us) / len(us), max(us)))
+            buckets = {}
+            for value in us:
+                bucket = 0
+                while (1 << bucket) <= value:
+                    bucket += 1
+                buckets[bucket] = buckets.get(bucket, 0) + 1
+            largest = max(buckets.values())
+            for bucket in range(min(buckets), max(buckets) + 1):
+                count = buckets.get(bucket, 0)
+                low = (1 << (bucket - 1)) if bucket else 0
+                output.write('  %7d - %7d us %7d %s\n' %
+                             (low, 1 << bucket, count, '#' * (count * 40 // largest)))
+
+
+def read_device(path, stats):
+    fd = os.open(path, os.O_RDWR)
+    try:
+        while True:
+            # The first byte is the report id, the keyboard has none
+            request = bytes([0, PIPELINE_TRACE_RAW_HID_ID]) + bytes(PACKET_SIZE - 1)
+            os.write(fd, request)
+            packet = os.read(fd, PACKET_SIZE)
+            if not stats.add_packet(packet):
+                time.sleep(0.01)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        os.close(fd)
+
+
+def read_dump(path, stats):
+    with open(path, 'rb') as f:
+        while True:
+            packet = f.read(PACKET_SIZE)
+            if len(packet) < HEADER_SIZE:
+                break
+            stats.add_packet(packet)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Print scan loop latency histograms of a traced firmware.')
+    parser.add_argument('path', help='raw HID device of the keyboard, or a dump file with --dump')
+    parser.add_argument('--dump', action='store_true', help='read captured packets from a file')
+    args = parser.parse_args()
+
+    stats = Stats()
+    if args.dump:
+        read_dump(args.path, stats)
+    else:
+        read_device(args.path, stats)
+    stats.report(sys.stdout)
+
+
+if __name__ == '__main__':
+    main()